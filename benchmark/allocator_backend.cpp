@@ -0,0 +1,133 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/allocator.hpp>
+#include <crossbow/program_options.hpp>
+#include <crossbow/slab_allocator.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+
+std::atomic<uint64_t> gAllocNanos(0);
+std::atomic<uint64_t> gFreeNanos(0);
+
+size_t residentBytes() {
+    size_t pages = 0;
+    size_t resident = 0;
+    std::ifstream statm("/proc/self/statm");
+    statm >> pages >> resident;
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+/**
+ * @brief Allocates numObjects objects of the given size and retires them again, repeated for several rounds
+ *
+ * The objects of a round are retired in one epoch and reclaimed while the following rounds allocate, like the nodes of
+ * an index that are replaced over time.
+ */
+void run(uint64_t numObjects, uint64_t size, uint64_t rounds) {
+    std::vector<void*> objects(numObjects);
+    uint64_t allocNanos = 0;
+    uint64_t freeNanos = 0;
+    for (uint64_t r = 0; r < rounds; ++r) {
+        crossbow::allocator _;
+        auto begin = std::chrono::steady_clock::now();
+        for (auto& object : objects) {
+            object = crossbow::allocator::malloc(size);
+            *reinterpret_cast<uint64_t*>(object) = r;
+        }
+        auto middle = std::chrono::steady_clock::now();
+        for (auto object : objects) {
+            crossbow::allocator::free(object);
+        }
+        auto end = std::chrono::steady_clock::now();
+        allocNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(middle - begin).count();
+        freeNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(end - middle).count();
+    }
+
+    // Reclamation is part of the cost of freeing
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < 16; ++i) {
+        crossbow::allocator _;
+    }
+    freeNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+
+    gAllocNanos += allocNanos;
+    gFreeNanos += freeNanos;
+}
+
+} // anonymous namespace
+
+int main(int argc, const char** argv) {
+    uint64_t numThreads = 1;
+    uint64_t numObjects = 100000;
+    uint64_t size = 48;
+    uint64_t rounds = 20;
+    bool slab = false;
+    bool help = false;
+    auto opts = crossbow::program_options::create_options(argv[0],
+            crossbow::program_options::value<'h'>("help", &help),
+            crossbow::program_options::value<'t'>("threads", &numThreads),
+            crossbow::program_options::value<'n'>("objects", &numObjects, crossbow::program_options::tag::description{
+                "Number of objects allocated by every thread per round"}),
+            crossbow::program_options::value<'s'>("size", &size),
+            crossbow::program_options::value<'r'>("rounds", &rounds),
+            crossbow::program_options::value<'l'>("slab", &slab, crossbow::program_options::tag::description{
+                "Use the slab backend instead of ::malloc"}));
+    crossbow::program_options::parse(opts, argc, argv);
+    if (help) {
+        crossbow::program_options::print_help(std::cout, opts);
+        return 0;
+    }
+
+    crossbow::allocator::init(slab ? crossbow::allocator::backend::slab : crossbow::allocator::backend::system);
+    auto resident = residentBytes();
+    std::vector<std::thread> threads;
+    for (uint64_t i = 0; i < numThreads; ++i) {
+        threads.emplace_back(&run, numObjects, size, rounds);
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    auto ops = static_cast<double>(numThreads * numObjects * rounds);
+    auto live = numThreads * numObjects * (size + crossbow::allocator::header_size());
+    std::cout << (slab ? "slab" : "system") << " " << numThreads << " threads, " << size << " bytes: "
+              << gAllocNanos / ops << " ns/malloc, " << gFreeNanos / ops << " ns/free, "
+              << (residentBytes() - std::min(resident, residentBytes())) / 1024 << " KiB resident growth ("
+              << live / 1024 << " KiB live per round";
+    if (slab) {
+        std::cout << ", " << crossbow::slab_allocator::reserved() / 1024 << " KiB slabs";
+    }
+    std::cout << ")" << std::endl;
+    return 0;
+}
@@ -0,0 +1,136 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/allocator.hpp>
+#include <crossbow/program_options.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Object {
+    explicit Object(uint64_t v)
+        : value(v) {
+    }
+
+    uint64_t value;
+};
+
+std::atomic<Object*> gShared(nullptr);
+std::atomic<bool> gStop(false);
+
+/**
+ * @brief Reads the shared object inside a guard as often as possible
+ */
+void reader(uint64_t& ops, uint64_t& checksum) {
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    while (!gStop.load(std::memory_order_relaxed)) {
+        for (int i = 0; i < 64; ++i) {
+            crossbow::allocator _;
+            sum += gShared.load(std::memory_order_acquire)->value;
+        }
+        count += 64;
+    }
+    ops = count;
+    checksum = sum;
+}
+
+/**
+ * @brief Replaces the shared object and retires the old one
+ */
+void writer(uint64_t& ops) {
+    uint64_t count = 0;
+    while (!gStop.load(std::memory_order_relaxed)) {
+        crossbow::allocator _;
+        auto old = gShared.exchange(crossbow::allocator::construct<Object>(count));
+        crossbow::allocator::destroy(old);
+        ++count;
+    }
+    ops = count;
+}
+
+void run(uint64_t numThreads, bool withWriter, uint64_t millis) {
+    gStop = false;
+    std::vector<uint64_t> ops(numThreads + 1, 0);
+    std::vector<uint64_t> sums(numThreads, 0);
+    std::vector<std::thread> threads;
+    for (uint64_t i = 0; i < numThreads; ++i) {
+        threads.emplace_back(&reader, std::ref(ops[i]), std::ref(sums[i]));
+    }
+    if (withWriter) {
+        threads.emplace_back(&writer, std::ref(ops[numThreads]));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(millis));
+    gStop = true;
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    uint64_t reads = 0;
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < numThreads; ++i) {
+        reads += ops[i];
+        sum += sums[i];
+    }
+    auto seconds = millis / 1000.0;
+    std::cout << numThreads << " readers" << (withWriter ? " + writer" : "") << ": "
+              << static_cast<uint64_t>(reads / seconds) << " guarded reads/s, "
+              << (reads == 0 ? 0.0 : millis * 1e6 * numThreads / reads) << " ns/guard per thread";
+    if (withWriter) {
+        std::cout << ", " << static_cast<uint64_t>(ops[numThreads] / seconds) << " retires/s";
+    }
+    std::cout << " (checksum " << sum << ")" << std::endl;
+}
+
+} // anonymous namespace
+
+int main(int argc, const char** argv) {
+    uint64_t maxThreads = 64;
+    uint64_t millis = 500;
+    bool help = false;
+    auto opts = crossbow::program_options::create_options(argv[0],
+            crossbow::program_options::value<'h'>("help", &help),
+            crossbow::program_options::value<'t'>("threads", &maxThreads),
+            crossbow::program_options::value<'d'>("duration", &millis, crossbow::program_options::tag::description{
+                "Duration of every run in milliseconds"}));
+    crossbow::program_options::parse(opts, argc, argv);
+    if (help) {
+        crossbow::program_options::print_help(std::cout, opts);
+        return 0;
+    }
+
+    crossbow::allocator::init();
+    gShared = crossbow::allocator::construct<Object>(0);
+    for (uint64_t i = 1; i <= maxThreads; i *= 2) {
+        run(i, false, millis);
+    }
+    for (uint64_t i = 1; i <= maxThreads; i *= 2) {
+        run(i, true, millis);
+    }
+    return 0;
+}
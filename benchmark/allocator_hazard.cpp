@@ -0,0 +1,244 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/allocator.hpp>
+#include <crossbow/hazard_pointer.hpp>
+#include <crossbow/program_options.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Node {
+    explicit Node(uint64_t v)
+        : value(v) {
+        payload.fill(v);
+    }
+
+    uint64_t value;
+    std::array<uint64_t, 31> payload;
+};
+
+std::vector<std::atomic<Node*>> gSlots;
+std::atomic<bool> gStop(false);
+
+struct Result {
+    uint64_t lookups = 0;
+    uint64_t scans = 0;
+    uint64_t writes = 0;
+    uint64_t checksum = 0;
+};
+
+/**
+ * @brief Reclamation through crossbow::allocator, a scan holds one guard for the whole traversal
+ */
+struct epoch_scheme {
+    static constexpr const char* name = "epoch";
+
+    static Node* create(uint64_t v) {
+        return crossbow::allocator::construct<Node>(v);
+    }
+
+    static void replace(std::mt19937_64& rnd) {
+        crossbow::allocator _;
+        auto& slot = gSlots[rnd() % gSlots.size()];
+        auto old = slot.exchange(create(rnd()));
+        crossbow::allocator::destroy(old);
+    }
+
+    static uint64_t lookup(std::mt19937_64& rnd) {
+        crossbow::allocator _;
+        return gSlots[rnd() % gSlots.size()].load(std::memory_order_acquire)->value;
+    }
+
+    static uint64_t scan() {
+        crossbow::allocator _;
+        uint64_t sum = 0;
+        for (auto& slot : gSlots) {
+            sum += slot.load(std::memory_order_acquire)->payload[7];
+        }
+        return sum;
+    }
+
+    static uint64_t pendingBytes() {
+        return crossbow::allocator::snapshot().pending_bytes;
+    }
+
+    static void reclaimAll() {
+        for (auto& slot : gSlots) {
+            crossbow::allocator::free_now(slot.exchange(nullptr));
+        }
+    }
+};
+
+/**
+ * @brief Reclamation through the global hazard_domain, a scan only protects the node it currently reads
+ */
+struct hazard_scheme {
+    static constexpr const char* name = "hazard";
+
+    static Node* create(uint64_t v) {
+        return new Node(v);
+    }
+
+    static void replace(std::mt19937_64& rnd) {
+        auto& slot = gSlots[rnd() % gSlots.size()];
+        auto old = slot.exchange(create(rnd()));
+        crossbow::hazard_domain::global().retire(old);
+    }
+
+    static uint64_t lookup(std::mt19937_64& rnd) {
+        crossbow::hazard_pointer hp;
+        return hp.protect(gSlots[rnd() % gSlots.size()])->value;
+    }
+
+    static uint64_t scan() {
+        crossbow::hazard_pointer hp;
+        uint64_t sum = 0;
+        for (auto& slot : gSlots) {
+            sum += hp.protect(slot)->payload[7];
+        }
+        return sum;
+    }
+
+    static uint64_t pendingBytes() {
+        return crossbow::hazard_domain::global().pending() * sizeof(Node);
+    }
+
+    static void reclaimAll() {
+        for (auto& slot : gSlots) {
+            delete slot.exchange(nullptr);
+        }
+        crossbow::hazard_domain::global().scan();
+    }
+};
+
+/**
+ * @brief Mostly short lookups, every scanEvery-th operation traverses all slots
+ */
+template <typename Scheme>
+void reader(Result& result, uint64_t seed, uint64_t scanEvery) {
+    std::mt19937_64 rnd(seed);
+    while (!gStop.load(std::memory_order_relaxed)) {
+        for (uint64_t i = 1; i < scanEvery; ++i) {
+            result.checksum += Scheme::lookup(rnd);
+        }
+        result.lookups += scanEvery - 1;
+        result.checksum += Scheme::scan();
+        ++result.scans;
+    }
+}
+
+template <typename Scheme>
+void writer(Result& result, uint64_t seed) {
+    std::mt19937_64 rnd(seed);
+    while (!gStop.load(std::memory_order_relaxed)) {
+        for (int i = 0; i < 64; ++i) {
+            Scheme::replace(rnd);
+        }
+        result.writes += 64;
+    }
+}
+
+template <typename Scheme>
+void run(uint64_t numReaders, uint64_t numWriters, uint64_t scanEvery, uint64_t millis) {
+    for (uint64_t i = 0; i < gSlots.size(); ++i) {
+        gSlots[i].store(Scheme::create(i));
+    }
+
+    gStop = false;
+    std::vector<Result> results(numReaders + numWriters);
+    std::vector<std::thread> threads;
+    for (uint64_t i = 0; i < numReaders; ++i) {
+        threads.emplace_back(&reader<Scheme>, std::ref(results[i]), i, scanEvery);
+    }
+    for (uint64_t i = 0; i < numWriters; ++i) {
+        threads.emplace_back(&writer<Scheme>, std::ref(results[numReaders + i]), numReaders + i);
+    }
+
+    uint64_t maxPending = 0;
+    auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(millis);
+    while (std::chrono::steady_clock::now() < end) {
+        maxPending = std::max(maxPending, Scheme::pendingBytes());
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    gStop = true;
+    for (auto& t : threads) {
+        t.join();
+    }
+    Scheme::reclaimAll();
+
+    Result total;
+    for (auto& r : results) {
+        total.lookups += r.lookups;
+        total.scans += r.scans;
+        total.writes += r.writes;
+        total.checksum += r.checksum;
+    }
+    auto seconds = millis / 1000.0;
+    std::cout << Scheme::name << " " << numReaders << " readers + " << numWriters << " writers: "
+              << static_cast<uint64_t>(total.lookups / seconds) << " lookups/s, "
+              << static_cast<uint64_t>(total.scans / seconds) << " scans/s, "
+              << static_cast<uint64_t>(total.writes / seconds) << " writes/s, "
+              << maxPending / 1024 << " KiB max pending (checksum " << total.checksum << ")" << std::endl;
+}
+
+} // anonymous namespace
+
+int main(int argc, const char** argv) {
+    uint64_t maxThreads = 8;
+    uint64_t numSlots = 1 << 16;
+    uint64_t scanEvery = 1024;
+    uint64_t millis = 1000;
+    bool help = false;
+    auto opts = crossbow::program_options::create_options(argv[0],
+            crossbow::program_options::value<'h'>("help", &help),
+            crossbow::program_options::value<'t'>("threads", &maxThreads, crossbow::program_options::tag::description{
+                "Maximum number of reader threads"}),
+            crossbow::program_options::value<'n'>("slots", &numSlots, crossbow::program_options::tag::description{
+                "Number of slots traversed by a scan"}),
+            crossbow::program_options::value<'s'>("scan-every", &scanEvery, crossbow::program_options::tag::description{
+                "Every n-th read operation is a scan over all slots"}),
+            crossbow::program_options::value<'d'>("duration", &millis, crossbow::program_options::tag::description{
+                "Duration of every run in milliseconds"}));
+    crossbow::program_options::parse(opts, argc, argv);
+    if (help) {
+        crossbow::program_options::print_help(std::cout, opts);
+        return 0;
+    }
+
+    crossbow::allocator::init();
+    gSlots = std::vector<std::atomic<Node*>>(numSlots);
+    for (uint64_t i = 1; i <= maxThreads; i *= 2) {
+        run<epoch_scheme>(i, 1, scanEvery, millis);
+        run<hazard_scheme>(i, 1, scanEvery, millis);
+    }
+    return 0;
+}
@@ -0,0 +1,170 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/allocator.hpp>
+#include <crossbow/program_options.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+std::atomic<uint64_t> gAllocations(0);
+std::atomic<uint64_t> gDestroyed(0);
+std::atomic<uint64_t> gMaxPause(0);
+
+struct Object {
+    Object(uint64_t v)
+        : value(v) {
+    }
+
+    ~Object() {
+        gDestroyed.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint64_t value;
+};
+
+/**
+ * @brief Retires objects through allocator::destroy
+ *
+ * Records the longest time spent in the guard destructor which is where epochs are advanced and reclaimed.
+ */
+void retireDestroy(uint64_t numOps, uint64_t batch) {
+    uint64_t maxPause = 0;
+    std::aligned_storage<sizeof(crossbow::allocator), alignof(crossbow::allocator)>::type storage;
+    for (uint64_t i = 0; i < numOps;) {
+        auto guard = new (&storage) crossbow::allocator();
+        for (auto end = std::min(numOps, i + batch); i < end; ++i) {
+            crossbow::allocator::destroy(crossbow::allocator::construct<Object>(i));
+        }
+        auto begin = std::chrono::steady_clock::now();
+        guard->~allocator();
+        auto pause = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin);
+        maxPause = std::max(maxPause, static_cast<uint64_t>(pause.count()));
+    }
+
+    auto current = gMaxPause.load();
+    while (current < maxPause && !gMaxPause.compare_exchange_weak(current, maxPause)) {
+    }
+}
+
+/**
+ * @brief Retires objects through allocator::invoke with a capturing callback
+ *
+ * The callback does not fit into the small buffer of std::function and has to be heap allocated in any case.
+ */
+void retireInvoke(uint64_t numOps, uint64_t batch) {
+    uint64_t a = 1, b = 2, c = 3;
+    for (uint64_t i = 0; i < numOps;) {
+        crossbow::allocator _;
+        for (auto end = std::min(numOps, i + batch); i < end; ++i) {
+            crossbow::allocator::invoke([a, b, c, i] () {
+                gDestroyed.fetch_add(1 + (a + b + c + i) * 0, std::memory_order_relaxed);
+            });
+        }
+    }
+}
+
+void run(const char* name, void (*fun)(uint64_t, uint64_t), uint64_t numThreads, uint64_t numOps,
+        uint64_t batch) {
+    auto allocations = gAllocations.load();
+    gMaxPause = 0;
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    threads.reserve(numThreads);
+    for (uint64_t i = 0; i < numThreads; ++i) {
+        threads.emplace_back(fun, numOps, batch);
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+    allocations = gAllocations.load() - allocations - numThreads;
+    auto duration = std::chrono::duration_cast<std::chrono::duration<double>>(end - begin).count();
+    auto totalOps = numThreads * numOps;
+    std::cout << name << " " << numThreads << " threads: " << static_cast<uint64_t>(totalOps / duration)
+              << " retires/s, " << static_cast<double>(allocations) / totalOps << " operator new calls/retire";
+    if (gMaxPause != 0) {
+        std::cout << ", max guard exit " << gMaxPause / 1000 << "us";
+    }
+    std::cout << std::endl;
+}
+
+} // anonymous namespace
+
+void* operator new(size_t size) {
+    ++gAllocations;
+    if (auto ptr = ::malloc(size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    ::free(ptr);
+}
+
+int main(int argc, const char** argv) {
+    uint64_t numThreads = 4;
+    uint64_t numOps = 1000000;
+    uint64_t batch = 64;
+    bool background = false;
+    bool help = false;
+    auto opts = crossbow::program_options::create_options(argv[0],
+            crossbow::program_options::value<'h'>("help", &help),
+            crossbow::program_options::value<'t'>("threads", &numThreads),
+            crossbow::program_options::value<'n'>("ops", &numOps, crossbow::program_options::tag::description{
+                "Number of objects retired by every thread"}),
+            crossbow::program_options::value<'b'>("batch", &batch, crossbow::program_options::tag::description{
+                "Number of objects retired while holding one guard"}),
+            crossbow::program_options::value<'r'>("reclaimer", &background, crossbow::program_options::tag::description{
+                "Reclaim expired objects on a background thread"}));
+    crossbow::program_options::parse(opts, argc, argv);
+    if (help) {
+        crossbow::program_options::print_help(std::cout, opts);
+        return 0;
+    }
+
+    crossbow::allocator::init();
+    if (background) {
+        crossbow::allocator::start_reclaimer();
+    }
+    std::cout << "header overhead: " << crossbow::allocator::header_size() << " bytes/object" << std::endl;
+    for (uint64_t i = 1; i <= numThreads; i *= 2) {
+        run("destroy", &retireDestroy, i, numOps, batch);
+    }
+    for (uint64_t i = 1; i <= numThreads; i *= 2) {
+        run("invoke", &retireInvoke, i, numOps, batch);
+    }
+    if (background) {
+        crossbow::allocator::stop_reclaimer();
+    }
+    return 0;
+}
@@ -0,0 +1,221 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/ChunkAllocator.hpp>
+#include <crossbow/program_options.hpp>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::atomic<uint64_t> gAllocations(0);
+std::atomic<bool> gDone(false);
+
+/**
+ * @brief Allocation sizes of one request of the replayed trace
+ */
+using Request = std::vector<uint32_t>;
+
+/**
+ * @brief Generates requests with mostly small allocations, a few buffers and rare oversized payloads
+ */
+std::vector<Request> generateTrace(uint64_t numRequests, uint64_t seed) {
+    std::mt19937_64 rnd(seed);
+    std::vector<Request> trace(numRequests);
+    for (auto& request : trace) {
+        auto count = 32 + rnd() % 512;
+        for (uint64_t i = 0; i < count; ++i) {
+            auto kind = rnd() % 1000;
+            if (kind < 950) {
+                request.push_back(8 + rnd() % 248);
+            } else if (kind < 999) {
+                request.push_back(1024 + rnd() % (32 * 1024));
+            } else {
+                request.push_back(1024 * 1024 + rnd() % (2 * 1024 * 1024));
+            }
+        }
+    }
+    return trace;
+}
+
+uint64_t residentBytes() {
+    std::ifstream statm("/proc/self/statm");
+    uint64_t size = 0;
+    uint64_t resident = 0;
+    statm >> size >> resident;
+    return resident * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+}
+
+/**
+ * @brief Simulates parsing into the allocated memory
+ */
+inline void touch(void* ptr, uint32_t size) {
+    memset(ptr, 1, std::min<uint32_t>(size, 64));
+}
+
+struct malloc_replay {
+    static constexpr const char* name = "new/delete";
+
+    void operator()(const Request& request) {
+        for (auto size : request) {
+            auto p = new char[size];
+            touch(p, size);
+            mAllocated.push_back(p);
+        }
+        for (auto p : mAllocated) {
+            delete[] p;
+        }
+        mAllocated.clear();
+    }
+
+    std::vector<char*> mAllocated;
+};
+
+struct pool_replay {
+    static constexpr const char* name = "pool per request";
+
+    void operator()(const Request& request) {
+        crossbow::ChunkMemoryPool pool;
+        for (auto size : request) {
+            touch(pool.allocate(size), size);
+        }
+    }
+};
+
+struct cached_pool_replay {
+    static constexpr const char* name = "cached pool per request";
+
+    void operator()(const Request& request) {
+        crossbow::ChunkMemoryPool pool(crossbow::ChunkCache::global());
+        for (auto size : request) {
+            touch(pool.allocate(size), size);
+        }
+    }
+};
+
+struct local_pool_replay {
+    static constexpr const char* name = "thread-local pool";
+
+    void operator()(const Request& request) {
+        crossbow::ChunkPoolScope scope;
+        for (auto size : request) {
+            touch(scope.pool().allocate(size), size);
+        }
+    }
+};
+
+template <typename Replay>
+void replay(const std::vector<Request>& trace, uint64_t offset, uint64_t numRequests) {
+    Replay r;
+    for (uint64_t i = 0; i < numRequests; ++i) {
+        r(trace[(offset + i) % trace.size()]);
+    }
+}
+
+template <typename Replay>
+void run(const std::vector<Request>& trace, uint64_t numThreads, uint64_t numRequests) {
+    uint64_t numAllocations = 0;
+    for (uint64_t i = 0; i < numRequests; ++i) {
+        numAllocations += trace[i % trace.size()].size();
+    }
+    numAllocations *= numThreads;
+
+    gDone = false;
+    auto allocations = gAllocations.load();
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (uint64_t i = 0; i < numThreads; ++i) {
+        threads.emplace_back(&replay<Replay>, std::cref(trace), i * trace.size() / numThreads, numRequests);
+    }
+    std::thread joiner([&threads]() {
+        for (auto& t : threads) {
+            t.join();
+        }
+        gDone = true;
+    });
+    uint64_t maxResident = 0;
+    while (!gDone.load()) {
+        maxResident = std::max(maxResident, residentBytes());
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    joiner.join();
+    auto end = std::chrono::steady_clock::now();
+    allocations = gAllocations.load() - allocations;
+
+    auto seconds = std::chrono::duration<double>(end - begin).count();
+    std::cout << Replay::name << ", " << numThreads << " threads: "
+              << static_cast<uint64_t>(numAllocations / seconds) << " allocations/s, "
+              << static_cast<double>(allocations) / (numRequests * numThreads) << " operator new calls/request, "
+              << maxResident / (1024 * 1024) << " MiB max RSS" << std::endl;
+}
+
+} // anonymous namespace
+
+void* operator new(size_t size) {
+    ++gAllocations;
+    if (auto ptr = ::malloc(size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    ::free(ptr);
+}
+
+int main(int argc, const char** argv) {
+    uint64_t numThreads = 4;
+    uint64_t numRequests = 20000;
+    bool help = false;
+    auto opts = crossbow::program_options::create_options(argv[0],
+            crossbow::program_options::value<'h'>("help", &help),
+            crossbow::program_options::value<'t'>("threads", &numThreads),
+            crossbow::program_options::value<'n'>("requests", &numRequests, crossbow::program_options::tag::description{
+                "Number of requests replayed by every thread"}));
+    crossbow::program_options::parse(opts, argc, argv);
+    if (help) {
+        crossbow::program_options::print_help(std::cout, opts);
+        return 0;
+    }
+
+    auto trace = generateTrace(1024, 42);
+    for (uint64_t i = 1; i <= numThreads; i *= 2) {
+        run<malloc_replay>(trace, i, numRequests);
+        run<pool_replay>(trace, i, numRequests);
+        run<cached_pool_replay>(trace, i, numRequests);
+        run<local_pool_replay>(trace, i, numRequests);
+    }
+    return 0;
+}
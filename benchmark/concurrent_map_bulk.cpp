@@ -0,0 +1,122 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/concurrent_map.hpp>
+#include <crossbow/program_options.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace {
+
+template <typename Fun>
+double measure(const Fun& fun) {
+    auto begin = std::chrono::steady_clock::now();
+    fun();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::duration<double>>(end - begin).count();
+}
+
+void report(const char* name, size_t numOps, double duration) {
+    std::cout << name << ": " << static_cast<uint64_t>(numOps / duration) << " ops/s" << std::endl;
+}
+
+} // anonymous namespace
+
+int main(int argc, const char** argv) {
+    uint64_t numKeys = 1000000;
+    uint64_t batchSize = 4096;
+    bool help = false;
+    auto opts = crossbow::program_options::create_options(argv[0],
+            crossbow::program_options::value<'h'>("help", &help),
+            crossbow::program_options::value<'n'>("keys", &numKeys),
+            crossbow::program_options::value<'b'>("batch", &batchSize));
+    crossbow::program_options::parse(opts, argc, argv);
+    if (help) {
+        crossbow::program_options::print_help(std::cout, opts);
+        return 0;
+    }
+
+    using map_type = crossbow::concurrent_map<uint64_t, uint64_t>;
+    std::mt19937_64 rnd(42);
+    std::vector<std::pair<uint64_t, uint64_t>> elements(numKeys);
+    std::vector<uint64_t> keys(numKeys);
+    for (uint64_t i = 0; i < numKeys; ++i) {
+        elements[i] = std::make_pair(rnd(), i);
+    }
+    for (auto& k : keys) {
+        k = elements[rnd() % numKeys].first;
+    }
+
+    {
+        map_type map;
+        report("insert", numKeys, measure([&map, &elements]() {
+            for (auto& e : elements) {
+                map.insert(e.first, e.second);
+            }
+        }));
+        uint64_t found = 0;
+        report("at", numKeys, measure([&map, &keys, &found]() {
+            for (auto k : keys) {
+                found += map.at(k).second;
+            }
+        }));
+        report("erase", numKeys, measure([&map, &keys]() {
+            for (auto k : keys) {
+                map.erase(k);
+            }
+        }));
+        std::cout << "(checksum " << found << ")" << std::endl;
+    }
+
+    {
+        map_type map;
+        report("insert_bulk", numKeys, measure([&map, &elements, batchSize]() {
+            for (size_t i = 0; i < elements.size(); i += batchSize) {
+                auto end = std::min(i + batchSize, elements.size());
+                map.insert_bulk(elements.begin() + i, elements.begin() + end);
+            }
+        }));
+        std::vector<std::pair<bool, uint64_t>> results(batchSize);
+        report("at_bulk", numKeys, measure([&map, &keys, &results, batchSize]() {
+            for (size_t i = 0; i < keys.size(); i += batchSize) {
+                auto end = std::min(i + batchSize, keys.size());
+                map.at_bulk(keys.begin() + i, keys.begin() + end, results.begin());
+            }
+        }));
+        report("erase_bulk", numKeys, measure([&map, &keys, batchSize]() {
+            for (size_t i = 0; i < keys.size(); i += batchSize) {
+                auto end = std::min(i + batchSize, keys.size());
+                map.erase_bulk(keys.begin() + i, keys.begin() + end);
+            }
+        }));
+    }
+
+    report("bulk-load constructor", numKeys, measure([&elements]() {
+        map_type map(elements.begin(), elements.end());
+    }));
+    return 0;
+}
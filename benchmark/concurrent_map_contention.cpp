@@ -0,0 +1,106 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/adaptive_mutex.hpp>
+#include <crossbow/concurrent_map.hpp>
+#include <crossbow/program_options.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief Write-heavy workload: every thread inserts and erases random keys of a small key range
+ *
+ * The key range stays below the initial resize threshold so the benchmark measures the lock and counter traffic of the
+ * map and not the cost of resizing.
+ */
+template <typename Map>
+void runBenchmark(const char* name, uint64_t numKeys, uint64_t numOps, unsigned maxThreads) {
+    for (unsigned numThreads = 1; numThreads <= maxThreads; numThreads *= 2) {
+        Map map;
+        map.reserve(numKeys);
+
+        std::atomic<bool> start(false);
+        std::vector<std::thread> threads;
+        for (unsigned t = 0; t < numThreads; ++t) {
+            threads.emplace_back([&map, &start, numKeys, numOps, t]() {
+                std::mt19937_64 rnd(t);
+                while (!start.load()) {
+                }
+                for (uint64_t i = 0; i < numOps; ++i) {
+                    auto key = rnd() % numKeys;
+                    if (i % 2 == 0) {
+                        map.insert(key, i);
+                    } else {
+                        map.erase(key);
+                    }
+                }
+            });
+        }
+
+        auto begin = std::chrono::steady_clock::now();
+        start.store(true);
+        for (auto& t : threads) {
+            t.join();
+        }
+        auto end = std::chrono::steady_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::duration<double>>(end - begin).count();
+
+        std::cout << name << ": " << numThreads << " threads, "
+                  << static_cast<uint64_t>(numThreads * numOps / duration) << " writes/s (size " << map.size() << ")"
+                  << std::endl;
+    }
+}
+
+} // anonymous namespace
+
+int main(int argc, const char** argv) {
+    uint64_t numKeys = 4096;
+    uint64_t numOps = 1000000;
+    unsigned maxThreads = 64;
+    bool help = false;
+    auto opts = crossbow::program_options::create_options(argv[0],
+            crossbow::program_options::value<'h'>("help", &help),
+            crossbow::program_options::value<'n'>("keys", &numKeys),
+            crossbow::program_options::value<'o'>("ops", &numOps, crossbow::program_options::tag::description{
+                "Writes per thread"}),
+            crossbow::program_options::value<'t'>("threads", &maxThreads));
+    crossbow::program_options::parse(opts, argc, argv);
+    if (help) {
+        crossbow::program_options::print_help(std::cout, opts);
+        return 0;
+    }
+
+    runBenchmark<crossbow::concurrent_map<uint64_t, uint64_t>>("std::mutex", numKeys, numOps, maxThreads);
+    runBenchmark<crossbow::concurrent_map<uint64_t, uint64_t, std::hash<uint64_t>, std::equal_to<uint64_t>,
+            std::allocator<std::pair<const uint64_t, uint64_t>>, crossbow::adaptive_mutex<>>>("adaptive_mutex",
+            numKeys, numOps, maxThreads);
+    return 0;
+}
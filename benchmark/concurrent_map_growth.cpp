@@ -0,0 +1,97 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/concurrent_flat_map.hpp>
+#include <crossbow/concurrent_map.hpp>
+#include <crossbow/program_options.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief Inserts keys into an initially empty map and reports the insert latency percentiles
+ */
+template <typename Map>
+void runBenchmark(const char* name, uint64_t numKeys, unsigned numThreads) {
+    Map map;
+    std::mutex latencyMutex;
+    std::vector<uint64_t> latencies;
+    latencies.reserve(numKeys);
+
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < numThreads; ++t) {
+        threads.emplace_back([&map, &latencyMutex, &latencies, numKeys, numThreads, t]() {
+            std::mt19937_64 rnd(t);
+            std::vector<uint64_t> local;
+            local.reserve(numKeys / numThreads + 1);
+            for (uint64_t i = t; i < numKeys; i += numThreads) {
+                auto key = rnd();
+                auto begin = std::chrono::steady_clock::now();
+                map.insert(key, i);
+                auto end = std::chrono::steady_clock::now();
+                local.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count());
+            }
+            std::lock_guard<std::mutex> _(latencyMutex);
+            latencies.insert(latencies.end(), local.begin(), local.end());
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double p) {
+        return latencies[std::min(latencies.size() - 1, static_cast<size_t>(latencies.size() * p))];
+    };
+    std::cout << name << ": " << numKeys << " inserts, " << numThreads << " threads, latency [ns] p50 "
+              << percentile(0.5) << ", p99 " << percentile(0.99) << ", p99.9 " << percentile(0.999)
+              << ", p99.99 " << percentile(0.9999) << ", max " << latencies.back() << std::endl;
+}
+
+} // anonymous namespace
+
+int main(int argc, const char** argv) {
+    uint64_t numKeys = 10000000;
+    unsigned numThreads = 1;
+    bool help = false;
+    auto opts = crossbow::program_options::create_options(argv[0],
+            crossbow::program_options::value<'h'>("help", &help),
+            crossbow::program_options::value<'n'>("keys", &numKeys),
+            crossbow::program_options::value<'t'>("threads", &numThreads));
+    crossbow::program_options::parse(opts, argc, argv);
+    if (help) {
+        crossbow::program_options::print_help(std::cout, opts);
+        return 0;
+    }
+
+    runBenchmark<crossbow::concurrent_map<uint64_t, uint64_t>>("concurrent_map", numKeys, numThreads);
+    runBenchmark<crossbow::concurrent_flat_map<uint64_t, uint64_t>>("concurrent_flat_map", numKeys, numThreads);
+    return 0;
+}
@@ -0,0 +1,100 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/concurrent_flat_map.hpp>
+#include <crossbow/concurrent_map.hpp>
+#include <crossbow/program_options.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+
+template <typename Map>
+void runBenchmark(const char* name, const std::vector<uint64_t>& keys, uint64_t numKeys,
+        const std::vector<uint64_t>& lookups) {
+    Map map;
+
+    auto begin = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < numKeys; ++i) {
+        map.insert(keys[i], keys[i]);
+    }
+    auto end = std::chrono::steady_clock::now();
+    auto insertTime = std::chrono::duration_cast<std::chrono::duration<double>>(end - begin).count();
+
+    uint64_t found = 0;
+    begin = std::chrono::steady_clock::now();
+    for (auto k : lookups) {
+        found += map.at(k).first ? 1 : 0;
+    }
+    end = std::chrono::steady_clock::now();
+    auto lookupTime = std::chrono::duration_cast<std::chrono::duration<double>>(end - begin).count();
+
+    std::cout << name << ": " << numKeys << " keys, "
+              << static_cast<uint64_t>(numKeys / insertTime) << " inserts/s, "
+              << static_cast<uint64_t>(lookups.size() / lookupTime) << " lookups/s ("
+              << found << " hits)" << std::endl;
+}
+
+} // anonymous namespace
+
+int main(int argc, const char** argv) {
+    uint64_t minKeys = 1000000;
+    uint64_t maxKeys = 100000000;
+    uint64_t numLookups = 10000000;
+    bool help = false;
+    auto opts = crossbow::program_options::create_options(argv[0],
+            crossbow::program_options::value<'h'>("help", &help),
+            crossbow::program_options::value<'m'>("min-keys", &minKeys, crossbow::program_options::tag::description{
+                "Number of keys of the smallest map"}),
+            crossbow::program_options::value<'n'>("keys", &maxKeys, crossbow::program_options::tag::description{
+                "Number of keys of the largest map, the sizes in between grow by a factor of 10"}),
+            crossbow::program_options::value<'l'>("lookups", &numLookups, crossbow::program_options::tag::description{
+                "Number of lookups per map"}));
+    crossbow::program_options::parse(opts, argc, argv);
+    if (help) {
+        crossbow::program_options::print_help(std::cout, opts);
+        return 0;
+    }
+
+    // Random keys, the smaller maps use a prefix of the keys of the largest map
+    std::mt19937_64 rnd(42);
+    std::vector<uint64_t> keys(std::max(minKeys, maxKeys));
+    for (auto& k : keys) {
+        k = rnd();
+    }
+    std::vector<uint64_t> lookups(numLookups);
+    for (uint64_t numKeys = minKeys; numKeys <= maxKeys; numKeys *= 10) {
+        // Half of the lookups hit an existing key
+        for (auto& k : lookups) {
+            k = (rnd() % 2 == 0) ? keys[rnd() % numKeys] : rnd();
+        }
+
+        runBenchmark<crossbow::concurrent_map<uint64_t, uint64_t>>("concurrent_map", keys, numKeys, lookups);
+        runBenchmark<crossbow::concurrent_flat_map<uint64_t, uint64_t>>("concurrent_flat_map", keys, numKeys, lookups);
+    }
+    return 0;
+}
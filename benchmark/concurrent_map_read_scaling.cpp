@@ -0,0 +1,110 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/concurrent_map.hpp>
+#include <crossbow/program_options.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief Value type that is not trivially copyable and thus forces concurrent_map to take the lock on every read
+ */
+struct LockedValue {
+    LockedValue() : value(0) {}
+    LockedValue(uint64_t v) : value(v) {}
+    LockedValue(const LockedValue& other) : value(other.value) {}
+    LockedValue& operator=(const LockedValue& other) {
+        value = other.value;
+        return *this;
+    }
+
+    uint64_t value;
+};
+
+template <typename Map>
+void runBenchmark(const char* name, uint64_t numKeys, uint64_t numLookups, unsigned maxThreads) {
+    Map map;
+    for (uint64_t i = 0; i < numKeys; ++i) {
+        map.insert(i, i);
+    }
+
+    for (unsigned numThreads = 1; numThreads <= maxThreads; numThreads *= 2) {
+        std::atomic<bool> start(false);
+        std::atomic<uint64_t> found(0);
+        std::vector<std::thread> threads;
+        for (unsigned t = 0; t < numThreads; ++t) {
+            threads.emplace_back([&map, &start, &found, numKeys, numLookups, t]() {
+                std::mt19937_64 rnd(t);
+                uint64_t hits = 0;
+                while (!start.load()) {
+                }
+                for (uint64_t i = 0; i < numLookups; ++i) {
+                    hits += map.at(rnd() % numKeys).first ? 1 : 0;
+                }
+                found += hits;
+            });
+        }
+
+        auto begin = std::chrono::steady_clock::now();
+        start.store(true);
+        for (auto& t : threads) {
+            t.join();
+        }
+        auto end = std::chrono::steady_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::duration<double>>(end - begin).count();
+
+        std::cout << name << ": " << numThreads << " threads, "
+                  << static_cast<uint64_t>(numThreads * numLookups / duration) << " lookups/s" << std::endl;
+    }
+}
+
+} // anonymous namespace
+
+int main(int argc, const char** argv) {
+    uint64_t numKeys = 1000000;
+    uint64_t numLookups = 1000000;
+    unsigned maxThreads = 64;
+    bool help = false;
+    auto opts = crossbow::program_options::create_options(argv[0],
+            crossbow::program_options::value<'h'>("help", &help),
+            crossbow::program_options::value<'n'>("keys", &numKeys),
+            crossbow::program_options::value<'l'>("lookups", &numLookups, crossbow::program_options::tag::description{
+                "Lookups per thread"}),
+            crossbow::program_options::value<'t'>("threads", &maxThreads));
+    crossbow::program_options::parse(opts, argc, argv);
+    if (help) {
+        crossbow::program_options::print_help(std::cout, opts);
+        return 0;
+    }
+
+    runBenchmark<crossbow::concurrent_map<uint64_t, LockedValue>>("locked", numKeys, numLookups, maxThreads);
+    runBenchmark<crossbow::concurrent_map<uint64_t, uint64_t>>("optimistic", numKeys, numLookups, maxThreads);
+    return 0;
+}
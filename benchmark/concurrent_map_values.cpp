@@ -0,0 +1,150 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/allocator.hpp>
+#include <crossbow/concurrent_map.hpp>
+#include <crossbow/epoch_ptr.hpp>
+#include <crossbow/program_options.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <random>
+#include <vector>
+
+namespace {
+
+std::atomic<uint64_t> gAllocations(0);
+
+typedef std::vector<uint64_t> value_type;
+
+value_type makeValue(uint64_t key, size_t length) {
+    return value_type(length, key);
+}
+
+void report(const char* name, uint64_t ops, uint64_t allocations, double duration) {
+    std::cout << name << ": " << static_cast<uint64_t>(ops / duration) << " ops/s, "
+              << static_cast<double>(allocations) / ops << " operator new calls/op" << std::endl;
+}
+
+template <typename Fun>
+void measure(const char* name, uint64_t ops, const Fun& fun) {
+    auto allocations = gAllocations.load();
+    auto begin = std::chrono::steady_clock::now();
+    fun();
+    auto end = std::chrono::steady_clock::now();
+    report(name, ops, gAllocations.load() - allocations,
+            std::chrono::duration_cast<std::chrono::duration<double>>(end - begin).count());
+}
+
+void runCopy(uint64_t numKeys, uint64_t numLookups, size_t length) {
+    crossbow::concurrent_map<uint64_t, value_type> map;
+    map.reserve(numKeys);
+    std::vector<value_type> values;
+    for (uint64_t i = 0; i < numKeys; ++i) {
+        values.emplace_back(makeValue(i, length));
+    }
+    measure("copy insert", numKeys, [&map, &values, numKeys]() {
+        for (uint64_t i = 0; i < numKeys; ++i) {
+            map.insert(i, std::move(values[i]));
+        }
+    });
+
+    std::mt19937_64 rnd(0);
+    uint64_t sum = 0;
+    measure("copy at", numLookups, [&map, &rnd, &sum, numKeys, numLookups]() {
+        for (uint64_t i = 0; i < numLookups; ++i) {
+            auto res = map.at(rnd() % numKeys);
+            sum += res.second.front();
+        }
+    });
+    std::cout << "(checksum " << sum << ")" << std::endl;
+}
+
+/**
+ * @brief Values owned by epoch pointers - lookups return a pointer protected by a crossbow::allocator guard
+ *
+ * make_epoch_ptr allocates the object through allocator::malloc which is not counted by the operator new hook.
+ */
+void runEpoch(uint64_t numKeys, uint64_t numLookups, size_t length) {
+    crossbow::concurrent_map<uint64_t, crossbow::epoch_ptr<value_type>> map;
+    map.reserve(numKeys);
+    std::vector<value_type> values;
+    for (uint64_t i = 0; i < numKeys; ++i) {
+        values.emplace_back(makeValue(i, length));
+    }
+    measure("epoch insert", numKeys, [&map, &values, numKeys]() {
+        for (uint64_t i = 0; i < numKeys; ++i) {
+            map.insert(i, crossbow::make_epoch_ptr<value_type>(std::move(values[i])));
+        }
+    });
+
+    std::mt19937_64 rnd(0);
+    uint64_t sum = 0;
+    measure("epoch get", numLookups, [&map, &rnd, &sum, numKeys, numLookups]() {
+        crossbow::allocator _;
+        for (uint64_t i = 0; i < numLookups; ++i) {
+            sum += map.get(rnd() % numKeys)->front();
+        }
+    });
+    std::cout << "(checksum " << sum << ")" << std::endl;
+}
+
+} // anonymous namespace
+
+void* operator new(size_t size) {
+    ++gAllocations;
+    if (auto ptr = ::malloc(size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    ::free(ptr);
+}
+
+int main(int argc, const char** argv) {
+    uint64_t numKeys = 100000;
+    uint64_t numLookups = 1000000;
+    size_t length = 16;
+    bool help = false;
+    auto opts = crossbow::program_options::create_options(argv[0],
+            crossbow::program_options::value<'h'>("help", &help),
+            crossbow::program_options::value<'n'>("keys", &numKeys),
+            crossbow::program_options::value<'l'>("lookups", &numLookups),
+            crossbow::program_options::value<'s'>("length", &length, crossbow::program_options::tag::description{
+                "Number of elements in every value vector"}));
+    crossbow::program_options::parse(opts, argc, argv);
+    if (help) {
+        crossbow::program_options::print_help(std::cout, opts);
+        return 0;
+    }
+
+    crossbow::allocator::init();
+    runCopy(numKeys, numLookups, length);
+    runEpoch(numKeys, numLookups, length);
+    return 0;
+}
@@ -0,0 +1,183 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/ChunkAllocator.hpp>
+#include <crossbow/program_options.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::atomic<uint64_t> gAllocations(0);
+
+const char gText[] = "a text long enough to exceed the inline capacity of any string implementation around";
+
+/**
+ * @brief Shape of one request: the name lengths and tag counts of its items
+ */
+struct RequestShape {
+    std::vector<std::pair<uint32_t, uint32_t>> items;
+};
+
+std::vector<RequestShape> generateShapes(uint64_t count) {
+    std::mt19937_64 rnd(42);
+    std::vector<RequestShape> shapes(count);
+    for (auto& shape : shapes) {
+        auto numItems = 4 + rnd() % 29;
+        for (uint64_t i = 0; i < numItems; ++i) {
+            shape.items.emplace_back(8 + rnd() % 60, rnd() % 9);
+        }
+    }
+    return shapes;
+}
+
+/**
+ * @brief Builds the object graph of a parsed request with the given allocator
+ */
+template <typename Alloc>
+uint64_t handleRequest(const RequestShape& shape, const Alloc& alloc) {
+    using traits = std::allocator_traits<Alloc>;
+    using string = std::basic_string<char, std::char_traits<char>, typename traits::template rebind_alloc<char>>;
+    using tags = std::vector<uint32_t, typename traits::template rebind_alloc<uint32_t>>;
+
+    struct Item {
+        Item(uint64_t i, const char* text, uint32_t length, const Alloc& a)
+            : id(i),
+              name(text, length, a),
+              tagList(a) {
+        }
+
+        uint64_t id;
+        string name;
+        tags tagList;
+    };
+
+    std::vector<Item, typename traits::template rebind_alloc<Item>> items(alloc);
+    uint64_t id = 0;
+    for (auto& i : shape.items) {
+        items.emplace_back(id++, gText, i.first, alloc);
+        for (uint32_t t = 0; t < i.second; ++t) {
+            items.back().tagList.push_back(t);
+        }
+    }
+
+    uint64_t checksum = 0;
+    for (auto& i : items) {
+        checksum += i.id + i.name.size() + i.tagList.size();
+    }
+    return checksum;
+}
+
+struct std_allocator_handler {
+    static constexpr const char* name = "std::allocator";
+
+    uint64_t operator()(const RequestShape& shape) {
+        return handleRequest(shape, std::allocator<char>());
+    }
+};
+
+template <std::size_t N>
+struct inline_arena_handler {
+    static const char* name;
+
+    uint64_t operator()(const RequestShape& shape) {
+        crossbow::inline_arena<N> arena;
+        return handleRequest(shape, crossbow::ChunkAllocator<char>(&arena));
+    }
+};
+
+template <>
+const char* inline_arena_handler<1024>::name = "inline_arena<1024>";
+
+template <>
+const char* inline_arena_handler<8192>::name = "inline_arena<8192>";
+
+struct scope_handler {
+    static constexpr const char* name = "ChunkPoolScope";
+
+    uint64_t operator()(const RequestShape& shape) {
+        crossbow::ChunkPoolScope scope;
+        return handleRequest(shape, crossbow::ChunkAllocator<char>(&scope.pool()));
+    }
+};
+
+template <typename Handler>
+void run(const std::vector<RequestShape>& shapes, uint64_t numRequests) {
+    Handler handler;
+    uint64_t checksum = 0;
+    auto allocations = gAllocations.load();
+    auto begin = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < numRequests; ++i) {
+        checksum += handler(shapes[i % shapes.size()]);
+    }
+    auto end = std::chrono::steady_clock::now();
+    allocations = gAllocations.load() - allocations;
+
+    std::cout << Handler::name << ": "
+              << std::chrono::duration<double, std::nano>(end - begin).count() / numRequests << " ns/request, "
+              << static_cast<double>(allocations) / numRequests << " operator new calls/request (checksum "
+              << checksum << ")" << std::endl;
+}
+
+} // anonymous namespace
+
+void* operator new(size_t size) {
+    ++gAllocations;
+    if (auto ptr = ::malloc(size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    ::free(ptr);
+}
+
+int main(int argc, const char** argv) {
+    uint64_t numRequests = 1000000;
+    bool help = false;
+    auto opts = crossbow::program_options::create_options(argv[0],
+            crossbow::program_options::value<'h'>("help", &help),
+            crossbow::program_options::value<'n'>("requests", &numRequests, crossbow::program_options::tag::description{
+                "Number of handled requests"}));
+    crossbow::program_options::parse(opts, argc, argv);
+    if (help) {
+        crossbow::program_options::print_help(std::cout, opts);
+        return 0;
+    }
+
+    auto shapes = generateShapes(1024);
+    run<std_allocator_handler>(shapes, numRequests);
+    run<inline_arena_handler<1024>>(shapes, numRequests);
+    run<inline_arena_handler<8192>>(shapes, numRequests);
+    run<scope_handler>(shapes, numRequests);
+    return 0;
+}
@@ -0,0 +1,154 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/fixed_size_stack.hpp>
+#include <crossbow/magazine_depot.hpp>
+#include <crossbow/program_options.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t NumIds = 1 << 16;
+
+/// Number of ids every thread holds at once
+constexpr size_t WorkingSet = 16;
+
+template <typename Stack>
+void allocateAndFree(Stack& stack, uint64_t numOps) {
+    uint32_t ids[WorkingSet];
+    for (uint64_t i = 0; i < numOps; i += 2 * WorkingSet) {
+        for (auto& id : ids) {
+            stack.pop(id);
+        }
+        for (auto id : ids) {
+            stack.push(id);
+        }
+    }
+}
+
+/**
+ * @brief All threads allocate directly from the shared stack
+ */
+class SharedRun {
+public:
+    SharedRun(crossbow::fixed_size_stack<uint32_t>& stack)
+        : mStack(stack) {
+    }
+
+    void run(uint64_t numOps) {
+        allocateAndFree(mStack, numOps);
+    }
+
+    void report() {
+    }
+
+private:
+    crossbow::fixed_size_stack<uint32_t>& mStack;
+};
+
+/**
+ * @brief All threads share one depot and allocate through their own magazine cache
+ */
+template <size_t MagazineSize>
+class MagazineRun {
+public:
+    MagazineRun(crossbow::fixed_size_stack<uint32_t>& stack)
+        : mDepot(stack) {
+    }
+
+    void run(uint64_t numOps) {
+        typename crossbow::magazine_depot<uint32_t, MagazineSize>::cache cache(mDepot);
+        allocateAndFree(cache, numOps);
+    }
+
+    void report() {
+        std::cout << ", hit rate " << 100.0 * mDepot.hits() / (mDepot.hits() + mDepot.misses()) << "%";
+    }
+
+private:
+    crossbow::magazine_depot<uint32_t, MagazineSize> mDepot;
+};
+
+/**
+ * @brief Every thread allocates WorkingSet ids, frees them again and repeats
+ */
+template <typename Run>
+void runBenchmark(const char* name, unsigned maxThreads, uint64_t numOps) {
+    for (unsigned numThreads = 1; numThreads <= maxThreads; numThreads *= 2) {
+        crossbow::fixed_size_stack<uint32_t> stack(NumIds, 0);
+        for (uint32_t i = 0; i < NumIds; ++i) {
+            stack.push(i);
+        }
+        Run run(stack);
+
+        std::atomic<bool> start(false);
+        std::vector<std::thread> threads;
+        for (unsigned t = 0; t < numThreads; ++t) {
+            threads.emplace_back([&run, &start, numOps]() {
+                while (!start.load()) {
+                }
+                run.run(numOps);
+            });
+        }
+
+        auto begin = std::chrono::steady_clock::now();
+        start.store(true);
+        for (auto& t : threads) {
+            t.join();
+        }
+        auto end = std::chrono::steady_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::duration<double>>(end - begin).count();
+        std::cout << name << ": " << numThreads << " threads, " << static_cast<uint64_t>(numThreads * numOps / duration)
+                  << " ops/s";
+        run.report();
+        std::cout << std::endl;
+    }
+}
+
+} // anonymous namespace
+
+int main(int argc, const char** argv) {
+    uint64_t numOps = 1000000;
+    unsigned maxThreads = 64;
+    bool help = false;
+    auto opts = crossbow::program_options::create_options(argv[0],
+            crossbow::program_options::value<'h'>("help", &help),
+            crossbow::program_options::value<'o'>("ops", &numOps, crossbow::program_options::tag::description{
+                "Allocations and frees per thread"}),
+            crossbow::program_options::value<'t'>("threads", &maxThreads));
+    crossbow::program_options::parse(opts, argc, argv);
+    if (help) {
+        crossbow::program_options::print_help(std::cout, opts);
+        return 0;
+    }
+
+    runBenchmark<SharedRun>("fixed_size_stack", maxThreads, numOps);
+    runBenchmark<MagazineRun<4>>("magazine (size 4)", maxThreads, numOps);
+    runBenchmark<MagazineRun<32>>("magazine (size 32)", maxThreads, numOps);
+    return 0;
+}
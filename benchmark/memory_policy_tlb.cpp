@@ -0,0 +1,183 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/memory_policy.hpp>
+#include <crossbow/program_options.hpp>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+
+using page_size = crossbow::memory_policy::page_size;
+
+const char* pageName(page_size pages) {
+    switch (pages) {
+    case page_size::heap:
+        return "heap";
+    case page_size::standard:
+        return "4K";
+    case page_size::huge_2m:
+        return "2M";
+    case page_size::huge_1g:
+        return "1G";
+    }
+    return "";
+}
+
+/**
+ * @brief Counts data TLB read misses of the calling thread, if the kernel permits it
+ */
+class tlb_counter {
+public:
+    tlb_counter() {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        mFd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+
+    ~tlb_counter() {
+        if (mFd >= 0) {
+            close(mFd);
+        }
+    }
+
+    bool valid() const {
+        return mFd >= 0;
+    }
+
+    void start() {
+        if (mFd >= 0) {
+            ioctl(mFd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(mFd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+
+    uint64_t stop() {
+        uint64_t count = 0;
+        if (mFd >= 0) {
+            ioctl(mFd, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(mFd, &count, sizeof(count)) != sizeof(count)) {
+                count = 0;
+            }
+        }
+        return count;
+    }
+
+private:
+    int mFd;
+};
+
+/**
+ * @brief Chases a random cyclic permutation through the block so that every access depends on the previous one
+ */
+void run(const crossbow::memory_policy& policy, uint64_t length, uint64_t numAccesses) {
+    auto begin = std::chrono::steady_clock::now();
+    page_size used;
+    auto data = static_cast<uint64_t*>(policy.allocate(length, &used));
+    auto allocated = std::chrono::steady_clock::now();
+
+    // One slot per cache line
+    auto numSlots = length / 64;
+    auto stride = 64 / sizeof(uint64_t);
+    std::vector<uint64_t> order(numSlots);
+    for (uint64_t i = 0; i < numSlots; ++i) {
+        order[i] = i;
+    }
+    std::mt19937_64 rnd(42);
+    std::shuffle(order.begin(), order.end(), rnd);
+    for (uint64_t i = 0; i < numSlots; ++i) {
+        data[order[i] * stride] = order[(i + 1) % numSlots] * stride;
+    }
+    std::vector<uint64_t>().swap(order);
+
+    tlb_counter counter;
+    counter.start();
+    auto start = std::chrono::steady_clock::now();
+    uint64_t pos = 0;
+    for (uint64_t i = 0; i < numAccesses; ++i) {
+        pos = data[pos];
+    }
+    auto end = std::chrono::steady_clock::now();
+    auto misses = counter.stop();
+
+    policy.deallocate(data, length);
+
+    std::cout << pageName(policy.pages) << (policy.prefault ? " prefaulted" : "") << " (mapped " << pageName(used)
+              << "): allocate " << std::chrono::duration_cast<std::chrono::microseconds>(allocated - begin).count()
+              << "us, " << std::chrono::duration<double, std::nano>(end - start).count() / numAccesses
+              << " ns/access, ";
+    if (counter.valid()) {
+        std::cout << static_cast<double>(misses) / numAccesses << " dTLB misses/access";
+    } else {
+        std::cout << "dTLB misses n/a";
+    }
+    std::cout << " (" << pos << ")" << std::endl;
+}
+
+} // anonymous namespace
+
+int main(int argc, const char** argv) {
+    uint64_t length = 1024;
+    uint64_t numAccesses = 20000000;
+    int node = -1;
+    bool help = false;
+    auto opts = crossbow::program_options::create_options(argv[0],
+            crossbow::program_options::value<'h'>("help", &help),
+            crossbow::program_options::value<'s'>("size", &length, crossbow::program_options::tag::description{
+                "Size of the accessed memory in MiB"}),
+            crossbow::program_options::value<'n'>("accesses", &numAccesses, crossbow::program_options::tag::description{
+                "Number of random accesses"}),
+            crossbow::program_options::value<'m'>("node", &node, crossbow::program_options::tag::description{
+                "NUMA node the memory is bound to"}));
+    crossbow::program_options::parse(opts, argc, argv);
+    if (help) {
+        crossbow::program_options::print_help(std::cout, opts);
+        return 0;
+    }
+    length *= 1024 * 1024;
+
+    run(crossbow::memory_policy(), length, numAccesses);
+    run(crossbow::memory_policy(page_size::standard, node), length, numAccesses);
+    run(crossbow::memory_policy(page_size::standard, node, true), length, numAccesses);
+    run(crossbow::memory_policy(page_size::huge_2m, node), length, numAccesses);
+    run(crossbow::memory_policy(page_size::huge_2m, node, true), length, numAccesses);
+    run(crossbow::memory_policy(page_size::huge_1g, node, true), length, numAccesses);
+    return 0;
+}
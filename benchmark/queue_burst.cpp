@@ -0,0 +1,140 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/mpmc_queue.hpp>
+#include <crossbow/mpsc_queue.hpp>
+#include <crossbow/program_options.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+typedef std::function<void()> task;
+
+/**
+ * @brief Producers submit tasks in bursts to a single poll thread that needs some time for every task
+ *
+ * Reports how long the producers were stalled submitting a burst (a bounded queue blocks once the poll thread falls
+ * behind) and the overall task throughput.
+ */
+template <typename Queue, typename Submit>
+void runBenchmark(const char* name, unsigned numProducers, uint64_t numBursts, uint64_t burstSize, uint64_t work,
+        const Submit& submit) {
+    Queue queue;
+    std::atomic<bool> start(false);
+    std::atomic<uint64_t> executed(0);
+    std::vector<std::chrono::nanoseconds> maxBurst(numProducers, std::chrono::nanoseconds(0));
+    std::vector<std::thread> threads;
+    for (unsigned p = 0; p < numProducers; ++p) {
+        threads.emplace_back([&queue, &start, &executed, &maxBurst, &submit, p, numBursts, burstSize, work]() {
+            while (!start.load()) {
+            }
+            for (uint64_t b = 0; b < numBursts; ++b) {
+                auto begin = std::chrono::steady_clock::now();
+                for (uint64_t i = 0; i < burstSize; ++i) {
+                    submit(queue, [&executed, work]() {
+                        volatile uint64_t sum = 0;
+                        for (uint64_t j = 0; j < work; ++j) {
+                            sum += j;
+                        }
+                        executed.fetch_add(1, std::memory_order_relaxed);
+                    });
+                }
+                auto end = std::chrono::steady_clock::now();
+                maxBurst[p] = std::max(maxBurst[p], std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin));
+                std::this_thread::yield();
+            }
+        });
+    }
+
+    auto total = numProducers * numBursts * burstSize;
+    std::array<task, 16> tasks;
+    auto begin = std::chrono::steady_clock::now();
+    start.store(true);
+    while (executed.load(std::memory_order_relaxed) < total) {
+        auto count = queue.read_bulk(tasks.begin(), tasks.end());
+        if (count == 0) {
+            std::this_thread::yield();
+        }
+        for (size_t i = 0; i < count; ++i) {
+            tasks[i]();
+            tasks[i] = nullptr;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    auto duration = std::chrono::duration_cast<std::chrono::duration<double>>(end - begin).count();
+    auto stall = *std::max_element(maxBurst.begin(), maxBurst.end());
+    std::cout << name << ": " << numProducers << " producers, " << static_cast<uint64_t>(total / duration)
+              << " tasks/s, slowest burst submitted in "
+              << std::chrono::duration_cast<std::chrono::microseconds>(stall).count() << "us" << std::endl;
+}
+
+void submitBounded(crossbow::mpmc_queue<task, 256>& queue, task fun) {
+    queue.write(std::move(fun));
+}
+
+void submitUnbounded(crossbow::mpsc_queue<task>& queue, task fun) {
+    queue.emplace(std::move(fun));
+}
+
+} // anonymous namespace
+
+int main(int argc, const char** argv) {
+    uint64_t numBursts = 100;
+    uint64_t burstSize = 2048;
+    uint64_t work = 100;
+    unsigned maxProducers = 8;
+    bool help = false;
+    auto opts = crossbow::program_options::create_options(argv[0],
+            crossbow::program_options::value<'h'>("help", &help),
+            crossbow::program_options::value<'b'>("bursts", &numBursts, crossbow::program_options::tag::description{
+                "Bursts per producer"}),
+            crossbow::program_options::value<'s'>("burst-size", &burstSize),
+            crossbow::program_options::value<'w'>("work", &work, crossbow::program_options::tag::description{
+                "Loop iterations executed by every task"}),
+            crossbow::program_options::value<'p'>("producers", &maxProducers));
+    crossbow::program_options::parse(opts, argc, argv);
+    if (help) {
+        crossbow::program_options::print_help(std::cout, opts);
+        return 0;
+    }
+
+    for (unsigned p = 1; p <= maxProducers; p *= 2) {
+        runBenchmark<crossbow::mpmc_queue<task, 256>>("bounded mpmc_queue", p, numBursts, burstSize, work,
+                &submitBounded);
+        runBenchmark<crossbow::mpsc_queue<task>>("unbounded mpsc_queue", p, numBursts, burstSize, work,
+                &submitUnbounded);
+    }
+    return 0;
+}
@@ -0,0 +1,147 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/mpmc_queue.hpp>
+#include <crossbow/program_options.hpp>
+#include <crossbow/singleconsumerqueue.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr size_t QueueSize = 256;
+constexpr size_t BatchSize = 16;
+
+/**
+ * @brief Runs numProducers producer threads against a single consumer and reports the throughput
+ *
+ * The consumer drains the queue in batches of BatchSize elements as infinio::TaskQueue does.
+ */
+template <typename Queue, typename Produce>
+void runBenchmark(const char* name, unsigned numProducers, uint64_t numItems, const Produce& produce) {
+    Queue queue;
+    std::atomic<bool> start(false);
+    std::vector<std::thread> threads;
+    for (unsigned p = 0; p < numProducers; ++p) {
+        threads.emplace_back([&queue, &start, &produce, numItems]() {
+            while (!start.load()) {
+            }
+            produce(queue, numItems);
+        });
+    }
+
+    auto total = numProducers * numItems;
+    uint64_t received = 0;
+    uint64_t sum = 0;
+    std::array<uint64_t, BatchSize> values;
+
+    auto begin = std::chrono::steady_clock::now();
+    start.store(true);
+    while (received < total) {
+        auto count = queue.readMultiple(values.begin(), values.end());
+        if (count == 0) {
+            std::this_thread::yield();
+        }
+        for (size_t i = 0; i < count; ++i) {
+            sum += values[i];
+        }
+        received += count;
+    }
+    auto end = std::chrono::steady_clock::now();
+    for (auto& t : threads) {
+        t.join();
+    }
+    auto duration = std::chrono::duration_cast<std::chrono::duration<double>>(end - begin).count();
+    std::cout << name << ": " << numProducers << " producers, " << static_cast<uint64_t>(total / duration)
+              << " elements/s (checksum " << sum << ")" << std::endl;
+}
+
+/**
+ * @brief Adapter giving the MPMC queue the interface of SingleConsumerQueue
+ */
+template <typename T, size_t Size>
+class mpmc_adapter : public crossbow::mpmc_queue<T, Size> {
+public:
+    template <typename Iter>
+    size_t readMultiple(Iter out, Iter end) {
+        return this->read_bulk(out, end);
+    }
+};
+
+void produceSingleConsumer(crossbow::SingleConsumerQueue<uint64_t, QueueSize>& queue, uint64_t numItems) {
+    for (uint64_t i = 0; i < numItems; ++i) {
+        queue.write(i);
+    }
+}
+
+void produceMpmc(mpmc_adapter<uint64_t, QueueSize>& queue, uint64_t numItems) {
+    for (uint64_t i = 0; i < numItems; ++i) {
+        queue.write(i);
+    }
+}
+
+void produceMpmcBulk(mpmc_adapter<uint64_t, QueueSize>& queue, uint64_t numItems) {
+    std::array<uint64_t, BatchSize> values;
+    for (uint64_t i = 0; i < numItems;) {
+        auto count = std::min<uint64_t>(BatchSize, numItems - i);
+        for (size_t j = 0; j < count; ++j) {
+            values[j] = i + j;
+        }
+        auto written = queue.write_bulk(values.begin(), values.begin() + count);
+        if (written == 0) {
+            std::this_thread::yield();
+        }
+        i += written;
+    }
+}
+
+} // anonymous namespace
+
+int main(int argc, const char** argv) {
+    uint64_t numItems = 1000000;
+    unsigned maxProducers = 8;
+    bool help = false;
+    auto opts = crossbow::program_options::create_options(argv[0],
+            crossbow::program_options::value<'h'>("help", &help),
+            crossbow::program_options::value<'n'>("items", &numItems, crossbow::program_options::tag::description{
+                "Elements per producer"}),
+            crossbow::program_options::value<'p'>("producers", &maxProducers));
+    crossbow::program_options::parse(opts, argc, argv);
+    if (help) {
+        crossbow::program_options::print_help(std::cout, opts);
+        return 0;
+    }
+
+    for (unsigned p = 1; p <= maxProducers; p *= 2) {
+        runBenchmark<crossbow::SingleConsumerQueue<uint64_t, QueueSize>>("SingleConsumerQueue", p, numItems,
+                &produceSingleConsumer);
+        runBenchmark<mpmc_adapter<uint64_t, QueueSize>>("mpmc_queue", p, numItems, &produceMpmc);
+        runBenchmark<mpmc_adapter<uint64_t, QueueSize>>("mpmc_queue bulk", p, numItems, &produceMpmcBulk);
+    }
+    return 0;
+}
@@ -0,0 +1,153 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/Serializer.hpp>
+#include <crossbow/program_options.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Sample {
+    uint32_t sensor;
+    float x;
+    float y;
+    float z;
+};
+
+/**
+ * @brief Serializes the vector one element at a time like the generic policy does
+ */
+template <typename T>
+std::size_t serializeElementWise(uint8_t* buffer, const std::vector<T>& v) {
+    crossbow::serializer_into_array ser(buffer);
+    ser & v.size();
+    for (auto& e : v) {
+        ser & e;
+    }
+    return static_cast<std::size_t>(ser.pos - buffer);
+}
+
+/**
+ * @brief Deserializes the vector one element at a time like the generic policy does
+ */
+template <typename T>
+void deserializeElementWise(const uint8_t* buffer, std::vector<T>& out) {
+    crossbow::deserializer des(buffer);
+    std::size_t s;
+    des & s;
+    out.reserve(s);
+    for (std::size_t i = 0; i < s; ++i) {
+        T obj;
+        des & obj;
+        out.push_back(obj);
+    }
+}
+
+template <typename T>
+std::size_t serializeBulk(uint8_t* buffer, const std::vector<T>& v) {
+    crossbow::serializer_into_array ser(buffer);
+    ser & v;
+    return static_cast<std::size_t>(ser.pos - buffer);
+}
+
+template <typename T>
+void deserializeBulk(const uint8_t* buffer, std::vector<T>& out) {
+    crossbow::deserialize(out, buffer);
+}
+
+template <typename Fun>
+double measure(uint64_t iterations, Fun fun) {
+    auto begin = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; ++i) {
+        fun();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end - begin).count();
+}
+
+template <typename T>
+void run(const std::string& name, const std::vector<T>& values, uint64_t iterations) {
+    std::unique_ptr<uint8_t[]> buffer(new uint8_t[sizeof(std::size_t) + values.size() * sizeof(T)]);
+    std::size_t bytes = 0;
+    std::size_t elements = 0;
+
+    auto report = [&](const char* what, double duration) {
+        std::cout << name << " " << what << ": " << duration * 1e9 / (iterations * values.size()) << " ns/element, "
+                  << static_cast<double>(bytes) * iterations / duration / (1024 * 1024 * 1024) << " GB/s"
+                  << std::endl;
+    };
+
+    report("serialize element-wise", measure(iterations, [&]() {
+        bytes = serializeElementWise(buffer.get(), values);
+    }));
+    report("serialize bulk", measure(iterations, [&]() {
+        bytes = serializeBulk(buffer.get(), values);
+    }));
+    report("deserialize element-wise", measure(iterations, [&]() {
+        std::vector<T> out;
+        deserializeElementWise(buffer.get(), out);
+        elements += out.size();
+    }));
+    report("deserialize bulk", measure(iterations, [&]() {
+        std::vector<T> out;
+        deserializeBulk(buffer.get(), out);
+        elements += out.size();
+    }));
+    if (elements != 2 * iterations * values.size()) {
+        std::cerr << "Deserialized " << elements << " elements" << std::endl;
+    }
+}
+
+} // anonymous namespace
+
+int main(int argc, const char** argv) {
+    uint64_t numElements = 1000000;
+    uint64_t iterations = 50;
+    bool help = false;
+    auto opts = crossbow::program_options::create_options(argv[0],
+            crossbow::program_options::value<'h'>("help", &help),
+            crossbow::program_options::value<'n'>("elements", &numElements, crossbow::program_options::tag::description{
+                "Number of elements in the vector"}),
+            crossbow::program_options::value<'i'>("iterations", &iterations, crossbow::program_options::tag::description{
+                "Number of times the vector is serialized"}));
+    crossbow::program_options::parse(opts, argc, argv);
+    if (help) {
+        crossbow::program_options::print_help(std::cout, opts);
+        return 0;
+    }
+
+    std::vector<uint64_t> integers(numElements);
+    std::vector<Sample> samples(numElements);
+    for (uint64_t i = 0; i < numElements; ++i) {
+        integers[i] = i * 2654435761u;
+        samples[i] = Sample{static_cast<uint32_t>(i), i * 0.5f, i * 0.25f, i * 0.125f};
+    }
+    run("vector<uint64_t>", integers, iterations);
+    run("vector<Sample>", samples, iterations);
+    return 0;
+}
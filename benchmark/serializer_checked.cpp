@@ -0,0 +1,155 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/Serializer.hpp>
+#include <crossbow/program_options.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Order {
+    uint64_t id;
+    int32_t quantity;
+    double price;
+    std::string product;
+
+    template <class Archiver>
+    void visit(Archiver& ar) {
+        ar & id;
+        ar & quantity;
+        ar & price;
+        ar & product;
+    }
+};
+
+struct Customer {
+    uint64_t id;
+    std::string name;
+    std::vector<Order> orders;
+    std::vector<uint64_t> history;
+    std::map<std::string, std::string> attributes;
+
+    template <class Archiver>
+    void visit(Archiver& ar) {
+        ar & id;
+        ar & name;
+        ar & orders;
+        ar & history;
+        ar & attributes;
+    }
+};
+
+using Message = std::vector<Customer>;
+
+Message generateMessage(uint64_t numCustomers) {
+    std::mt19937_64 rnd(42);
+    Message msg(numCustomers);
+    for (auto& c : msg) {
+        c.id = rnd();
+        c.name = std::string(4 + rnd() % 28, 'c');
+        c.orders.resize(rnd() % 8);
+        for (auto& o : c.orders) {
+            o.id = rnd();
+            o.quantity = static_cast<int32_t>(rnd() % 100);
+            o.price = static_cast<double>(rnd() % 10000) / 100;
+            o.product = std::string(4 + rnd() % 20, 'p');
+        }
+        c.history.resize(rnd() % 64);
+        for (auto i = rnd() % 4; i > 0; --i) {
+            c.attributes["attribute" + std::to_string(i)] = std::string(rnd() % 16, 'v');
+        }
+    }
+    return msg;
+}
+
+template <typename Fun>
+double measure(uint64_t iterations, Fun fun) {
+    auto begin = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; ++i) {
+        fun();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end - begin).count() * 1e9 / iterations;
+}
+
+} // anonymous namespace
+
+int main(int argc, const char** argv) {
+    uint64_t numCustomers = 100;
+    uint64_t iterations = 20000;
+    uint64_t rounds = 5;
+    bool help = false;
+    auto opts = crossbow::program_options::create_options(argv[0],
+            crossbow::program_options::value<'h'>("help", &help),
+            crossbow::program_options::value<'c'>("customers", &numCustomers, crossbow::program_options::tag::description{
+                "Number of customers per message"}),
+            crossbow::program_options::value<'i'>("iterations", &iterations, crossbow::program_options::tag::description{
+                "Number of deserializations per round"}),
+            crossbow::program_options::value<'r'>("rounds", &rounds, crossbow::program_options::tag::description{
+                "Number of alternating measurement rounds"}));
+    crossbow::program_options::parse(opts, argc, argv);
+    if (help) {
+        crossbow::program_options::print_help(std::cout, opts);
+        return 0;
+    }
+
+    auto msg = generateMessage(numCustomers);
+    std::unique_ptr<uint8_t[]> buffer;
+    auto size = crossbow::serialize(buffer, msg);
+    std::cout << "message size: " << size << " bytes" << std::endl;
+
+    // Alternate between both deserializers to even out frequency and cache effects
+    double unchecked = 0;
+    double checked = 0;
+    uint64_t failures = 0;
+    for (uint64_t r = 0; r < rounds; ++r) {
+        unchecked += measure(iterations, [&]() {
+            Message out;
+            crossbow::deserialize(out, buffer.get());
+        });
+        checked += measure(iterations, [&]() {
+            Message out;
+            if (crossbow::checked_deserialize(out, buffer.get(), size) == nullptr) {
+                ++failures;
+            }
+        });
+    }
+    unchecked /= rounds;
+    checked /= rounds;
+
+    std::cout << "deserializer: " << unchecked << " ns/message" << std::endl;
+    std::cout << "checked_deserializer: " << checked << " ns/message" << std::endl;
+    std::cout << "overhead: " << (checked / unchecked - 1) * 100 << "%" << std::endl;
+    if (failures != 0) {
+        std::cerr << failures << " deserializations failed" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,167 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/Serializer.hpp>
+#include <crossbow/program_options.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Event {
+    uint64_t id;
+    int32_t delta;
+    uint32_t count;
+    std::string tag;
+    std::vector<uint32_t> values;
+
+    template <class Archiver>
+    void visit(Archiver& ar) {
+        ar & id;
+        ar & delta;
+        ar & count;
+        ar & tag;
+        ar & values;
+    }
+};
+
+using Message = std::vector<Event>;
+
+Message generateMessage(uint64_t numEvents, uint64_t maxValue) {
+    std::mt19937_64 rnd(42);
+    Message msg(numEvents);
+    for (auto& e : msg) {
+        e.id = rnd() % 100000;
+        e.delta = static_cast<int32_t>(rnd() % 200) - 100;
+        e.count = static_cast<uint32_t>(rnd() % 16);
+        e.tag = std::string(rnd() % 12, 't');
+        e.values.resize(rnd() % 32);
+        for (auto& v : e.values) {
+            v = static_cast<uint32_t>(rnd() % maxValue);
+        }
+    }
+    return msg;
+}
+
+template <typename Fun>
+double measure(uint64_t iterations, Fun fun) {
+    auto begin = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; ++i) {
+        fun();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end - begin).count();
+}
+
+void report(const char* what, std::size_t bytes, uint64_t iterations, double duration) {
+    std::cout << what << ": " << bytes << " bytes, " << duration * 1e6 / iterations << " us/message, "
+              << static_cast<double>(bytes) * iterations / duration / (1024 * 1024) << " MB/s" << std::endl;
+}
+
+void runMessages(const Message& msg, uint64_t iterations) {
+    std::unique_ptr<uint8_t[]> fixed;
+    std::size_t fixedSize = 0;
+    report("fixed encode", crossbow::serialize(fixed, msg), iterations, measure(iterations, [&]() {
+        fixedSize = crossbow::serialize(fixed, msg);
+    }));
+    report("fixed decode", fixedSize, iterations, measure(iterations, [&]() {
+        Message out;
+        crossbow::deserialize(out, fixed.get());
+    }));
+
+    std::unique_ptr<uint8_t[]> compact;
+    std::size_t compactSize = 0;
+    report("compact encode", crossbow::compact_serialize(compact, msg), iterations, measure(iterations, [&]() {
+        compactSize = crossbow::compact_serialize(compact, msg);
+    }));
+    report("compact decode", compactSize, iterations, measure(iterations, [&]() {
+        Message out;
+        crossbow::compact_deserialize(out, compact.get(), compactSize);
+    }));
+    std::cout << "compact/fixed size: " << static_cast<double>(compactSize) / fixedSize << std::endl;
+}
+
+void runIntegers(uint64_t numValues, uint64_t maxValue, uint64_t iterations) {
+    std::mt19937_64 rnd(7);
+    std::vector<uint32_t> values(numValues);
+    for (auto& v : values) {
+        v = static_cast<uint32_t>(rnd() % maxValue);
+    }
+    std::unique_ptr<uint8_t[]> buffer;
+    auto size = crossbow::compact_serialize(buffer, values);
+    std::vector<uint32_t> out(numValues);
+
+    auto perValue = [&](double duration) {
+        return duration * 1e9 / (iterations * numValues);
+    };
+    auto scalar = measure(iterations, [&]() {
+        uint64_t count;
+        auto pos = crossbow::impl::read_varint(buffer.get(), count);
+        for (uint64_t i = 0; i < count; ++i) {
+            uint64_t v;
+            pos = crossbow::impl::read_varint(pos, v);
+            out[i] = static_cast<uint32_t>(v);
+        }
+    });
+    auto batch = measure(iterations, [&]() {
+        uint64_t count;
+        auto pos = crossbow::impl::read_varint(buffer.get(), count);
+        crossbow::impl::read_varints(pos, buffer.get() + size, out.data(), count);
+    });
+    std::cout << "vector<uint32_t> < " << maxValue << ": " << size << " bytes (fixed "
+              << sizeof(std::size_t) + numValues * sizeof(uint32_t) << "), scalar decode " << perValue(scalar)
+              << " ns/value, batch decode " << perValue(batch) << " ns/value" << std::endl;
+}
+
+} // anonymous namespace
+
+int main(int argc, const char** argv) {
+    uint64_t numEvents = 1000;
+    uint64_t iterations = 2000;
+    uint64_t maxValue = 1000;
+    bool help = false;
+    auto opts = crossbow::program_options::create_options(argv[0],
+            crossbow::program_options::value<'h'>("help", &help),
+            crossbow::program_options::value<'e'>("events", &numEvents, crossbow::program_options::tag::description{
+                "Number of events per message"}),
+            crossbow::program_options::value<'i'>("iterations", &iterations, crossbow::program_options::tag::description{
+                "Number of times every message is encoded and decoded"}),
+            crossbow::program_options::value<'m'>("max-value", &maxValue, crossbow::program_options::tag::description{
+                "Upper bound of the generated integer values"}));
+    crossbow::program_options::parse(opts, argc, argv);
+    if (help) {
+        crossbow::program_options::print_help(std::cout, opts);
+        return 0;
+    }
+
+    runMessages(generateMessage(numEvents, maxValue), iterations);
+    runIntegers(100000, 128, iterations / 10);
+    runIntegers(100000, maxValue, iterations / 10);
+    runIntegers(100000, uint64_t(1) << 32, iterations / 10);
+    return 0;
+}
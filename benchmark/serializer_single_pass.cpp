@@ -0,0 +1,224 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/Serializer.hpp>
+#include <crossbow/program_options.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Position {
+    double x;
+    double y;
+    double z;
+};
+
+struct Order {
+    uint64_t id;
+    int32_t quantity;
+    std::string product;
+    std::vector<Position> route;
+
+    template <class Archiver>
+    void visit(Archiver& ar) {
+        ar & id;
+        ar & quantity;
+        ar & product;
+        ar & route;
+    }
+};
+
+struct Customer {
+    uint64_t id;
+    std::string name;
+    std::vector<Order> orders;
+    std::map<std::string, std::vector<uint32_t>> attributes;
+
+    template <class Archiver>
+    void visit(Archiver& ar) {
+        ar & id;
+        ar & name;
+        ar & orders;
+        ar & attributes;
+    }
+};
+
+using Message = std::vector<Customer>;
+
+std::vector<Message> generateMessages(uint64_t count, uint64_t customers) {
+    std::mt19937_64 rnd(42);
+    std::vector<Message> messages(count);
+    for (auto& msg : messages) {
+        msg.resize(1 + rnd() % (2 * customers));
+        for (auto& c : msg) {
+            c.id = rnd();
+            c.name = std::string(4 + rnd() % 28, 'c');
+            c.orders.resize(rnd() % 8);
+            for (auto& o : c.orders) {
+                o.id = rnd();
+                o.quantity = static_cast<int32_t>(rnd() % 100);
+                o.product = std::string(4 + rnd() % 20, 'p');
+                o.route.resize(rnd() % 6);
+            }
+            for (auto i = rnd() % 4; i > 0; --i) {
+                c.attributes["attribute" + std::to_string(i)] = std::vector<uint32_t>(rnd() % 8, 7);
+            }
+        }
+    }
+    return messages;
+}
+
+/**
+ * @brief Sizer pass followed by the serializer into a freshly allocated buffer
+ */
+struct two_pass {
+    static constexpr const char* name = "two pass, new buffer";
+
+    std::size_t operator()(const Message& msg) {
+        std::unique_ptr<uint8_t[]> buffer;
+        return crossbow::serialize(buffer, msg);
+    }
+};
+
+/**
+ * @brief Sizer pass followed by the serializer into a reused buffer
+ */
+struct two_pass_reuse {
+    static constexpr const char* name = "two pass, reused buffer";
+
+    std::size_t operator()(const Message& msg) {
+        crossbow::sizer sizer;
+        sizer & msg;
+        if (mCapacity < sizer.size) {
+            mCapacity = sizer.size;
+            mBuffer.reset(new uint8_t[mCapacity]);
+        }
+        crossbow::serializer_into_array ser(mBuffer.get());
+        ser & msg;
+        return static_cast<std::size_t>(ser.pos - mBuffer.get());
+    }
+
+    std::unique_ptr<uint8_t[]> mBuffer;
+    std::size_t mCapacity = 0;
+};
+
+/**
+ * @brief Single pass serializer starting with a new buffer
+ */
+struct single_pass {
+    static constexpr const char* name = "single pass, new buffer";
+
+    std::size_t operator()(const Message& msg) {
+        crossbow::growing_serializer ser;
+        ser & msg;
+        return ser.size();
+    }
+};
+
+/**
+ * @brief Single pass serializer reusing its buffer
+ */
+struct single_pass_reuse {
+    static constexpr const char* name = "single pass, reused buffer";
+
+    std::size_t operator()(const Message& msg) {
+        mSerializer.clear();
+        mSerializer & msg;
+        return mSerializer.size();
+    }
+
+    crossbow::growing_serializer mSerializer;
+};
+
+/**
+ * @brief Single pass serializer writing into a caller provided buffer_writer
+ */
+struct single_pass_writer {
+    static constexpr const char* name = "single pass, buffer_writer";
+
+    single_pass_writer()
+            : mBuffer(new char[BUFFER_SIZE]) {
+    }
+
+    std::size_t operator()(const Message& msg) {
+        crossbow::buffer_writer writer(mBuffer.get(), BUFFER_SIZE);
+        if (!crossbow::serialize(writer, msg)) {
+            return 0;
+        }
+        return static_cast<std::size_t>(writer.data() - mBuffer.get());
+    }
+
+    static constexpr std::size_t BUFFER_SIZE = 1024 * 1024;
+    std::unique_ptr<char[]> mBuffer;
+};
+
+constexpr std::size_t single_pass_writer::BUFFER_SIZE;
+
+template <typename Serializer>
+void run(const std::vector<Message>& messages, uint64_t numMessages) {
+    Serializer serializer;
+    uint64_t bytes = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < numMessages; ++i) {
+        bytes += serializer(messages[i % messages.size()]);
+    }
+    auto end = std::chrono::steady_clock::now();
+    auto duration = std::chrono::duration<double>(end - begin).count();
+
+    std::cout << Serializer::name << ": " << duration * 1e9 / numMessages << " ns/message, "
+              << static_cast<double>(bytes) / duration / (1024 * 1024) << " MB/s" << std::endl;
+}
+
+} // anonymous namespace
+
+int main(int argc, const char** argv) {
+    uint64_t numMessages = 200000;
+    uint64_t numCustomers = 8;
+    bool help = false;
+    auto opts = crossbow::program_options::create_options(argv[0],
+            crossbow::program_options::value<'h'>("help", &help),
+            crossbow::program_options::value<'n'>("messages", &numMessages, crossbow::program_options::tag::description{
+                "Number of serialized messages"}),
+            crossbow::program_options::value<'c'>("customers", &numCustomers, crossbow::program_options::tag::description{
+                "Average number of customers per message"}));
+    crossbow::program_options::parse(opts, argc, argv);
+    if (help) {
+        crossbow::program_options::print_help(std::cout, opts);
+        return 0;
+    }
+
+    auto messages = generateMessages(256, numCustomers);
+    run<two_pass>(messages, numMessages);
+    run<two_pass_reuse>(messages, numMessages);
+    run<single_pass>(messages, numMessages);
+    run<single_pass_reuse>(messages, numMessages);
+    run<single_pass_writer>(messages, numMessages);
+    return 0;
+}
@@ -0,0 +1,120 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/alignment.hpp>
+#include <crossbow/bounded_stack.hpp>
+#include <crossbow/fixed_size_stack.hpp>
+#include <crossbow/program_options.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr size_t Capacity = 1024;
+constexpr size_t BatchSize = 8;
+
+/**
+ * @brief Every thread alternately pushes and pops numOps elements, the stack starts half full
+ */
+template <typename Stack, typename Create, typename Op>
+void runBenchmark(const char* name, unsigned maxThreads, uint64_t numOps, const Create& create, const Op& op) {
+    for (unsigned numThreads = 1; numThreads <= maxThreads; numThreads *= 2) {
+        std::unique_ptr<Stack, crossbow::aligned_deleter<Stack>> stack(create());
+        for (uint64_t i = 0; i < Capacity / 2; ++i) {
+            stack->push(i);
+        }
+
+        std::atomic<bool> start(false);
+        std::vector<std::thread> threads;
+        for (unsigned t = 0; t < numThreads; ++t) {
+            threads.emplace_back([&stack, &start, &op, numOps]() {
+                while (!start.load()) {
+                }
+                op(*stack, numOps);
+            });
+        }
+
+        auto begin = std::chrono::steady_clock::now();
+        start.store(true);
+        for (auto& t : threads) {
+            t.join();
+        }
+        auto end = std::chrono::steady_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::duration<double>>(end - begin).count();
+        std::cout << name << ": " << numThreads << " threads, " << static_cast<uint64_t>(numThreads * numOps / duration)
+                  << " ops/s" << std::endl;
+    }
+}
+
+template <typename Stack>
+void pushPop(Stack& stack, uint64_t numOps) {
+    uint64_t value = 0;
+    for (uint64_t i = 0; i < numOps; i += 2) {
+        if (stack.pop(value)) {
+            stack.push(value);
+        }
+    }
+}
+
+void pushPopBulk(crossbow::bounded_stack<uint64_t>& stack, uint64_t numOps) {
+    std::array<uint64_t, BatchSize> values;
+    for (uint64_t i = 0; i < numOps; i += 2 * BatchSize) {
+        auto count = stack.pop_bulk(values.begin(), values.end());
+        stack.push_bulk(values.begin(), values.begin() + count);
+    }
+}
+
+} // anonymous namespace
+
+int main(int argc, const char** argv) {
+    uint64_t numOps = 1000000;
+    unsigned maxThreads = 64;
+    bool help = false;
+    auto opts = crossbow::program_options::create_options(argv[0],
+            crossbow::program_options::value<'h'>("help", &help),
+            crossbow::program_options::value<'o'>("ops", &numOps, crossbow::program_options::tag::description{
+                "Push and pop operations per thread"}),
+            crossbow::program_options::value<'t'>("threads", &maxThreads));
+    crossbow::program_options::parse(opts, argc, argv);
+    if (help) {
+        crossbow::program_options::print_help(std::cout, opts);
+        return 0;
+    }
+
+    runBenchmark<crossbow::fixed_size_stack<uint64_t>>("fixed_size_stack", maxThreads, numOps, []() {
+        return crossbow::aligned_new<crossbow::fixed_size_stack<uint64_t>>(Capacity, 0);
+    }, &pushPop<crossbow::fixed_size_stack<uint64_t>>);
+    runBenchmark<crossbow::bounded_stack<uint64_t>>("bounded_stack", maxThreads, numOps, []() {
+        return crossbow::aligned_new<crossbow::bounded_stack<uint64_t>>(Capacity);
+    }, &pushPop<crossbow::bounded_stack<uint64_t>>);
+    runBenchmark<crossbow::bounded_stack<uint64_t>>("bounded_stack bulk", maxThreads, numOps, []() {
+        return crossbow::aligned_new<crossbow::bounded_stack<uint64_t>>(Capacity);
+    }, &pushPopBulk);
+    return 0;
+}
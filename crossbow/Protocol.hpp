@@ -30,6 +30,10 @@
  * form of:
  * |8 bytes: total buffer size|4 bytes: command-id (>= 1)|command args ...|
  *
+ * Arguments may use crossbow::serialized_string_view and crossbow::serialized_span
+ * in place of strings and vectors to read them directly from the receive buffer.
+ * Such views are only valid until the implementation invokes the callback.
+ *
  */
 #pragma once
 #include <tuple>
@@ -188,21 +192,17 @@ public:
                 std::is_same<typename Signature<C>::arguments, typename argsType<Args...>::type>::value,
                 "Wrong function arguments");
         using ResType = typename Signature<C>::result;
-        crossbow::sizer sizer;
-        sizer & sizer.size;
-        sizer & C;
-        impl::ArgSerializer<Args...> argSerializer;
-        argSerializer.exec(sizer, args...);
-        if (mCurrSize < sizer.size) {
-            mCurrentRequest.reset(new uint8_t[sizer.size]);
-            mCurrSize = sizer.size;
-        }
-        crossbow::serializer ser(mCurrentRequest.get());
-        ser & sizer.size;
+        // Serialize in a single pass and patch the total size in afterwards
+        crossbow::growing_serializer ser(std::move(mCurrentRequest), mCurrSize);
+        ser & std::size_t(0);
         ser & C;
+        impl::ArgSerializer<Args...> argSerializer;
         argSerializer.exec(ser, args...);
-        ser.buffer.release();
-        boost::asio::async_write(mSocket, boost::asio::buffer(mCurrentRequest.get(), sizer.size),
+        auto size = ser.size();
+        mCurrSize = ser.capacity();
+        mCurrentRequest = ser.release();
+        memcpy(mCurrentRequest.get(), &size, sizeof(size));
+        boost::asio::async_write(mSocket, boost::asio::buffer(mCurrentRequest.get(), size),
                     [this, callback](const boost::system::error_code& ec, size_t){
                         if (ec) {
                             error<ResType>(ec, callback);
@@ -277,19 +277,16 @@ private:
         using Res = typename Signature<C>::result;
         execute<C>([this](const Res& result) {
             // Serialize result
-            crossbow::sizer sizer;
-            sizer & sizer.size;
-            sizer & result;
-            if (mBufSize < sizer.size) {
-                mBuffer.reset(new uint8_t[sizer.size]);
-            }
-            crossbow::serializer ser(mBuffer.get());
-            ser & sizer.size;
+            crossbow::growing_serializer ser(std::move(mBuffer), mBufSize);
+            ser & std::size_t(0);
             ser & result;
-            ser.buffer.release();
+            auto size = ser.size();
+            mBufSize = ser.capacity();
+            mBuffer = ser.release();
+            memcpy(mBuffer.get(), &size, sizeof(size));
             // send the result back
             boost::asio::async_write(mSocket,
-                    boost::asio::buffer(mBuffer.get(), sizer.size),
+                    boost::asio::buffer(mBuffer.get(), size),
                     [this](const error_code& ec, size_t bytes_written) {
                         if (ec) {
                             std::cerr << ec.message() << std::endl;
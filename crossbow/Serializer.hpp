@@ -26,5 +26,10 @@
 #include <crossbow/serializer/string.hpp>
 #include <crossbow/serializer/crossbow_string.hpp>
 #include <crossbow/serializer/vector.hpp>
+#include <crossbow/serializer/array.hpp>
 #include <crossbow/serializer/map.hpp>
 #include <crossbow/serializer/unordered_map.hpp>
+#include <crossbow/serializer/serialized_view.hpp>
+#include <crossbow/serializer/compact_serializer.hpp>
+#include <crossbow/serializer/checked_deserializer.hpp>
+#include <crossbow/serializer/growing_serializer.hpp>
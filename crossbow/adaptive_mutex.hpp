@@ -0,0 +1,120 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#pragma once
+
+#include <crossbow/non_copyable.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace crossbow {
+
+/**
+ * @brief Mutex that spins for a while before it parks the thread in the kernel
+ *
+ * Critical sections guarded by the lock stripes of the concurrent maps are only a few hundred cycles long, so a waiting
+ * thread usually gets the lock by spinning without paying for a system call. If the lock is still taken after SpinCount
+ * attempts the thread sleeps on a futex (on other platforms it yields instead).
+ *
+ * Satisfies the Lockable concept and can be used as the MutexType of concurrent_map and concurrent_flat_map.
+ */
+template <size_t SpinCount = 128>
+class adaptive_mutex : non_copyable, non_movable {
+public:
+    adaptive_mutex()
+        : mState(UNLOCKED) {
+    }
+
+    void lock() {
+        uint32_t state = UNLOCKED;
+        if (mState.compare_exchange_strong(state, LOCKED, std::memory_order_acquire)) {
+            return;
+        }
+
+        for (size_t i = 0; i < SpinCount; ++i) {
+            pause();
+            state = mState.load(std::memory_order_relaxed);
+            if (state == UNLOCKED && mState.compare_exchange_weak(state, LOCKED, std::memory_order_acquire)) {
+                return;
+            }
+        }
+
+        // Announce the waiter before sleeping so unlock knows it has to wake somebody up
+        while (mState.exchange(CONTENDED, std::memory_order_acquire) != UNLOCKED) {
+            park();
+        }
+    }
+
+    bool try_lock() {
+        uint32_t state = UNLOCKED;
+        return mState.compare_exchange_strong(state, LOCKED, std::memory_order_acquire);
+    }
+
+    void unlock() {
+        if (mState.exchange(UNLOCKED, std::memory_order_release) == CONTENDED) {
+            unpark();
+        }
+    }
+
+private:
+    static constexpr uint32_t UNLOCKED = 0;
+    static constexpr uint32_t LOCKED = 1;
+    static constexpr uint32_t CONTENDED = 2;
+
+    static void pause() {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    }
+
+#ifdef __linux__
+    void park() {
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&mState), FUTEX_WAIT_PRIVATE, CONTENDED, nullptr, nullptr, 0);
+    }
+
+    void unpark() {
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&mState), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+    }
+#else
+    void park() {
+        std::this_thread::yield();
+    }
+
+    void unpark() {
+    }
+#endif
+
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "Futex word must be a plain 32 bit integer");
+
+    std::atomic<uint32_t> mState;
+};
+
+} // namespace crossbow
@@ -25,10 +25,18 @@
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <cstdlib>
+#include <new>
 #include <type_traits>
+#include <utility>
 
 namespace crossbow {
 
+/**
+ * @brief Size of a cache line, used to keep data written by different threads apart
+ */
+constexpr size_t cache_line_size = 64;
+
 /**
  * @brief Align the integral type to be a multiple of alignment
  *
@@ -51,4 +59,56 @@ inline typename std::enable_if<std::is_pointer<T>::value, T>::type align(T value
     return reinterpret_cast<T>((reinterpret_cast<uintptr_t>(value) - 1u + alignment) & -alignment);
 }
 
+/**
+ * @brief Allocate size bytes aligned to alignment, the memory has to be released with free
+ *
+ * Throws std::bad_alloc if the allocation fails.
+ */
+inline void* aligned_allocate(size_t size, size_t alignment) {
+    // The size passed to aligned_alloc has to be a multiple of the alignment
+    auto ptr = ::aligned_alloc(alignment, align(size, alignment));
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+/**
+ * @brief Allocate and construct a T on the heap respecting its alignment
+ *
+ * Before C++17 new ignores alignments larger than alignof(std::max_align_t), heap instances of types aligned to cache
+ * lines have to be created through this function and destroyed with aligned_delete.
+ */
+template<typename T, typename... Args>
+T* aligned_new(Args&&... args) {
+    auto ptr = aligned_allocate(sizeof(T), alignof(T));
+    try {
+        return new (ptr) T(std::forward<Args>(args)...);
+    } catch (...) {
+        ::free(ptr);
+        throw;
+    }
+}
+
+/**
+ * @brief Destroy and free an object created with aligned_new
+ */
+template<typename T>
+void aligned_delete(T* ptr) {
+    if (ptr) {
+        ptr->~T();
+        ::free(ptr);
+    }
+}
+
+/**
+ * @brief Deleter for std::unique_ptr owning an object created with aligned_new
+ */
+template<typename T>
+struct aligned_deleter {
+    void operator()(T* ptr) const {
+        aligned_delete(ptr);
+    }
+};
+
 } // namespace crossbow
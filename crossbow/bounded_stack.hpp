@@ -0,0 +1,223 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#pragma once
+
+#include <crossbow/alignment.hpp>
+#include <crossbow/non_copyable.hpp>
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace crossbow {
+
+/**
+ * @brief Lock-free stack with a fixed capacity
+ *
+ * Index based Treiber stack: the elements live in a preallocated node array, free nodes and nodes holding an element
+ * are kept in two linked lists. The head of each list packs the index of the first node with a tag that is incremented
+ * on every modification into 64 bits, which prevents the ABA problem. Unlike fixed_size_stack concurrent push and pop
+ * operations never wait for each other.
+ *
+ * push_bulk and pop_bulk move a whole chain of nodes with a single CAS on each list.
+ *
+ * The heads of both lists are cache line aligned, heap allocated instances therefore have to be created with
+ * crossbow::aligned_new (operator new ignores extended alignment before C++17).
+ */
+template <class T>
+class bounded_stack : crossbow::non_copyable, crossbow::non_movable {
+    static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types supported");
+
+    static constexpr uint32_t Null = std::numeric_limits<uint32_t>::max();
+
+    struct Node {
+        T value;
+        std::atomic<uint32_t> next;
+    };
+
+public:
+    explicit bounded_stack(size_t capacity)
+        : mNodes(capacity),
+          mHead(pack(Null, 0)),
+          mFree(pack(capacity == 0 ? Null : 0, 0)) {
+        assert(capacity < Null);
+        for (size_t i = 0; i < capacity; ++i) {
+            mNodes[i].next.store(i + 1 == capacity ? Null : static_cast<uint32_t>(i + 1), std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @return False if the stack is full
+     */
+    bool push(T element) {
+        uint32_t node;
+        if (take(mFree, 1, node) == 0) {
+            return false;
+        }
+        mNodes[node].value = element;
+        put(mHead, node, node);
+        return true;
+    }
+
+    /**
+     * @return True if pop succeeded - result will be set to the popped element
+     */
+    bool pop(T& result) {
+        uint32_t node;
+        if (take(mHead, 1, node) == 0) {
+            return false;
+        }
+        result = mNodes[node].value;
+        put(mFree, node, node);
+        return true;
+    }
+
+    /**
+     * @brief Pushes as many elements of the range as there is space for
+     *
+     * The first element of the range ends up on top, so pop_bulk returns the elements in the order of the range.
+     *
+     * @return Number of elements pushed from the front of the range
+     */
+    template <typename Iter>
+    size_t push_bulk(Iter first, Iter last) {
+        uint32_t chain;
+        auto count = take(mFree, static_cast<size_t>(std::distance(first, last)), chain);
+        if (count == 0) {
+            return 0;
+        }
+        auto node = chain;
+        for (size_t i = 0; i < count; ++i, ++first) {
+            mNodes[node].value = *first;
+            if (i + 1 < count) {
+                node = mNodes[node].next.load(std::memory_order_relaxed);
+            }
+        }
+        put(mHead, chain, node);
+        return count;
+    }
+
+    /**
+     * @brief Pops up to std::distance(out, end) elements, starting with the top of the stack
+     *
+     * @return Number of elements written to the front of the output range
+     */
+    template <typename Iter>
+    size_t pop_bulk(Iter out, Iter end) {
+        uint32_t chain;
+        auto count = take(mHead, static_cast<size_t>(std::distance(out, end)), chain);
+        if (count == 0) {
+            return 0;
+        }
+        auto node = chain;
+        for (size_t i = 0; i < count; ++i, ++out) {
+            *out = mNodes[node].value;
+            if (i + 1 < count) {
+                node = mNodes[node].next.load(std::memory_order_relaxed);
+            }
+        }
+        put(mFree, chain, node);
+        return count;
+    }
+
+    bool empty() const {
+        return indexOf(mHead.load(std::memory_order_relaxed)) == Null;
+    }
+
+    /**
+     * @brief Maximum capacity of the stack
+     */
+    size_t capacity() const {
+        return mNodes.size();
+    }
+
+private:
+    static uint64_t pack(uint32_t index, uint32_t tag) {
+        return (static_cast<uint64_t>(tag) << 32) | index;
+    }
+
+    static uint32_t indexOf(uint64_t head) {
+        return static_cast<uint32_t>(head);
+    }
+
+    static uint32_t tagOf(uint64_t head) {
+        return static_cast<uint32_t>(head >> 32);
+    }
+
+    /**
+     * @brief Detaches up to max nodes from the front of the list
+     *
+     * The next pointers of the walked nodes might be modified concurrently, but then the tag of the head changed and the
+     * CAS fails.
+     *
+     * @param first Set to the first node of the detached chain, the nodes are linked through their next pointer
+     * @return Number of detached nodes
+     */
+    size_t take(std::atomic<uint64_t>& head, size_t max, uint32_t& first) {
+        auto current = head.load(std::memory_order_acquire);
+        while (true) {
+            first = indexOf(current);
+            if (first == Null || max == 0) {
+                return 0;
+            }
+            size_t count = 1;
+            auto last = first;
+            auto next = mNodes[last].next.load(std::memory_order_relaxed);
+            while (count < max && count < mNodes.size() && next != Null) {
+                last = next;
+                next = mNodes[last].next.load(std::memory_order_relaxed);
+                ++count;
+            }
+            if (head.compare_exchange_weak(current, pack(next, tagOf(current) + 1), std::memory_order_acquire,
+                    std::memory_order_acquire)) {
+                return count;
+            }
+        }
+    }
+
+    /**
+     * @brief Prepends the chain of nodes from first to last to the list
+     */
+    void put(std::atomic<uint64_t>& head, uint32_t first, uint32_t last) {
+        auto current = head.load(std::memory_order_relaxed);
+        do {
+            mNodes[last].next.store(indexOf(current), std::memory_order_relaxed);
+        } while (!head.compare_exchange_weak(current, pack(first, tagOf(current) + 1), std::memory_order_release,
+                std::memory_order_relaxed));
+    }
+
+    std::vector<Node> mNodes;
+
+    /// Top of the stack
+    alignas(cache_line_size) std::atomic<uint64_t> mHead;
+
+    /// List of unused nodes
+    alignas(cache_line_size) std::atomic<uint64_t> mFree;
+};
+
+} // namespace crossbow
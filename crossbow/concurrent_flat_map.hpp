@@ -0,0 +1,606 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#pragma once
+
+#include <crossbow/memory_resource.hpp>
+#include <crossbow/non_copyable.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace crossbow {
+namespace flat_map_impl {
+
+/// Control byte of a slot that was never used
+constexpr int8_t CTRL_EMPTY = -128;
+
+/// Control byte of a slot whose element was erased (tombstone)
+constexpr int8_t CTRL_DELETED = -2;
+
+/// Number of slots whose control bytes are scanned in one probe
+constexpr size_t GROUP_SIZE = 16;
+
+/**
+ * @brief Bitmask of slots in a group, one bit per slot
+ */
+class group_mask {
+public:
+    explicit group_mask(uint32_t mask)
+        : mMask(mask) {
+    }
+
+    explicit operator bool() const {
+        return mMask != 0;
+    }
+
+    /**
+     * @brief Index of the lowest slot set in the mask
+     */
+    size_t lowest() const {
+        return static_cast<size_t>(__builtin_ctz(mMask));
+    }
+
+    /**
+     * @brief Clear the lowest slot set in the mask
+     */
+    void pop() {
+        mMask &= (mMask - 1);
+    }
+
+private:
+    uint32_t mMask;
+};
+
+/**
+ * @brief View on the control bytes of one group of GROUP_SIZE slots
+ *
+ * Uses SSE2 to compare all control bytes of a group in a single instruction, falls back to a scalar loop on platforms
+ * without SSE2.
+ */
+class group {
+public:
+    explicit group(const int8_t* ctrl) {
+#ifdef __SSE2__
+        mCtrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+#else
+        memcpy(mCtrl, ctrl, GROUP_SIZE);
+#endif
+    }
+
+    /**
+     * @brief Slots whose control byte equals the given 7 bit hash
+     */
+    group_mask match(int8_t h2) const {
+#ifdef __SSE2__
+        auto cmp = _mm_cmpeq_epi8(_mm_set1_epi8(h2), mCtrl);
+        return group_mask(static_cast<uint32_t>(_mm_movemask_epi8(cmp)));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < GROUP_SIZE; ++i) {
+            mask |= static_cast<uint32_t>(mCtrl[i] == h2) << i;
+        }
+        return group_mask(mask);
+#endif
+    }
+
+    /**
+     * @brief Slots that were never used
+     */
+    group_mask matchEmpty() const {
+        return match(CTRL_EMPTY);
+    }
+
+    /**
+     * @brief Slots that are either empty or deleted (i.e. have the sign bit set)
+     */
+    group_mask matchEmptyOrDeleted() const {
+#ifdef __SSE2__
+        return group_mask(static_cast<uint32_t>(_mm_movemask_epi8(mCtrl)));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < GROUP_SIZE; ++i) {
+            mask |= static_cast<uint32_t>(mCtrl[i] < 0) << i;
+        }
+        return group_mask(mask);
+#endif
+    }
+
+private:
+#ifdef __SSE2__
+    __m128i mCtrl;
+#else
+    int8_t mCtrl[GROUP_SIZE];
+#endif
+};
+
+/**
+ * @brief Mixes the user supplied hash
+ *
+ * std::hash is the identity for integral types, the control bytes and the shard selection require all bits of the hash
+ * to be well distributed.
+ */
+inline size_t mix(size_t hash) {
+    uint64_t h = static_cast<uint64_t>(hash) * 0x9E3779B97F4A7C15ull;
+    return static_cast<size_t>(h ^ (h >> 32));
+}
+
+} // namespace flat_map_impl
+
+/**
+ * @brief Thread safe hash map using open addressing
+ *
+ * Drop-in replacement for crossbow::concurrent_map with the same template parameters and the same interface. Instead of
+ * one element per bucket plus an overflow vector the map is split into ConcurrencyLevel independent open addressing
+ * tables (one per lock). Every table stores a control byte per slot holding 7 bits of the hash, lookups compare the
+ * control bytes of 16 slots at a time and only touch the slot when the hash bits match.
+ *
+ * Each table grows independently while holding only its own lock.
+ */
+template <
+typename Key,
+         typename T,
+         typename Hash = std::hash<Key>,
+         typename KeyEqual = std::equal_to<Key>,
+         typename Allocator = std::allocator<std::pair<const Key, T> >,
+         typename MutexType = std::mutex,
+         size_t ConcurrencyLevel = 32,
+         size_t InitialCapacity = 32,
+         size_t LoadFactor = 75
+         >
+class concurrent_flat_map : crossbow::non_copyable, crossbow::non_movable {
+public:
+    typedef Key key_type;
+    typedef T mapped_type;
+    typedef const T const_mapped_type;
+    typedef size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef Hash hasher;
+    typedef KeyEqual key_equal;
+    typedef Allocator allocator_type;
+    typedef typename std::allocator_traits<allocator_type>::pointer pointer;
+    typedef typename std::allocator_traits<allocator_type>::const_pointer const_pointer;
+    typedef MutexType mutex_type;
+
+    static_assert(LoadFactor > 0 && LoadFactor < 100, "Load factor must be between 0 and 100 percent");
+
+private:
+    struct Slot {
+        template <typename K, typename V>
+        Slot(K && key, V && value) : key(std::forward<K>(key)), value(std::forward<V>(value)) {}
+
+        key_type key;
+        mapped_type value;
+    };
+
+    typedef typename std::aligned_storage<sizeof(Slot), alignof(Slot)>::type SlotStorage;
+
+    struct alignas(flat_map_impl::GROUP_SIZE) CtrlGroup {
+        int8_t ctrl[flat_map_impl::GROUP_SIZE];
+    };
+
+    typedef std::vector<CtrlGroup, typename std::allocator_traits<allocator_type>::template rebind_alloc<CtrlGroup>> ctrl_vector;
+    typedef std::vector<SlotStorage, typename std::allocator_traits<allocator_type>::template rebind_alloc<SlotStorage>> slot_vector;
+
+    /**
+     * @brief Open addressing table protected by one of the locks
+     */
+    class Table {
+    public:
+        Table(const allocator_type &allocator)
+            : _ctrl(allocator),
+              _slots(allocator),
+              _size(0),
+              _growth_left(0) {
+        }
+
+        Table(Table && other)
+            : _ctrl(std::move(other._ctrl)),
+              _slots(std::move(other._slots)),
+              _size(other._size),
+              _growth_left(other._growth_left) {
+            other._ctrl.clear();
+            other._slots.clear();
+            other._size = 0;
+            other._growth_left = 0;
+        }
+
+        ~Table() {
+            destroySlots();
+        }
+
+        size_t capacity() const {
+            return _slots.size();
+        }
+
+        /**
+         * @brief Position of the slot containing the key or capacity() if it does not exist
+         */
+        size_t find(size_t hash, const key_type &key, const key_equal &equal) const {
+            if (_ctrl.empty()) {
+                return capacity();
+            }
+            auto h2 = ctrlHash(hash);
+            auto mask = _ctrl.size() - 1;
+            auto g = groupHash(hash) & mask;
+            for (size_t i = 1; ; ++i) {
+                flat_map_impl::group grp(_ctrl[g].ctrl);
+                for (auto m = grp.match(h2); m; m.pop()) {
+                    auto pos = g * flat_map_impl::GROUP_SIZE + m.lowest();
+                    if (equal(slot(pos).key, key)) {
+                        return pos;
+                    }
+                }
+                if (grp.matchEmpty()) {
+                    return capacity();
+                }
+                g = (g + i) & mask;
+            }
+        }
+
+        Slot &slot(size_t pos) {
+            return *reinterpret_cast<Slot*>(&_slots[pos]);
+        }
+
+        const Slot &slot(size_t pos) const {
+            return *reinterpret_cast<const Slot*>(&_slots[pos]);
+        }
+
+        /**
+         * @brief Construct a new element - the key must not exist in the table
+         */
+        template <typename K, typename V>
+        Slot &emplace(size_t hash, const hasher &hash_fn, K && key, V && value) {
+            if (_growth_left == 0) {
+                grow(hash_fn);
+            }
+            auto pos = findInsertPosition(hash);
+            auto &c = ctrlAt(pos);
+            if (c == flat_map_impl::CTRL_EMPTY) {
+                --_growth_left;
+            }
+            new(&_slots[pos]) Slot(std::forward<K>(key), std::forward<V>(value));
+            c = ctrlHash(hash);
+            ++_size;
+            return slot(pos);
+        }
+
+        void erase(size_t pos) {
+            slot(pos).~Slot();
+            --_size;
+
+            // If the group still contains an empty slot no probe sequence ever continued past this group and the slot
+            // can be reused right away, otherwise we have to leave a tombstone.
+            flat_map_impl::group grp(_ctrl[pos / flat_map_impl::GROUP_SIZE].ctrl);
+            if (grp.matchEmpty()) {
+                ctrlAt(pos) = flat_map_impl::CTRL_EMPTY;
+                ++_growth_left;
+            } else {
+                ctrlAt(pos) = flat_map_impl::CTRL_DELETED;
+            }
+        }
+
+        template<typename Fun>
+        void for_each(const Fun &fun) {
+            for (size_t pos = 0; pos < capacity(); ++pos) {
+                if (ctrlAt(pos) >= 0) {
+                    auto &s = slot(pos);
+                    fun(s.key, s.value);
+                }
+            }
+        }
+
+        void clear() {
+            destroySlots();
+            resetCtrl();
+        }
+
+        /**
+         * @brief Make room for at least count elements without any further rehashing
+         */
+        void reserve(size_t count, const hasher &hash_fn) {
+            if (count <= _size + _growth_left) {
+                return;
+            }
+            auto new_capacity = std::max(capacity(), flat_map_impl::GROUP_SIZE);
+            while (maxLoad(new_capacity) < count) {
+                new_capacity *= 2;
+            }
+            rehash(new_capacity, hash_fn);
+        }
+
+    private:
+        static int8_t ctrlHash(size_t hash) {
+            return static_cast<int8_t>(hash >> (sizeof(size_t) * 8 - 7));
+        }
+
+        static size_t groupHash(size_t hash) {
+            return hash;
+        }
+
+        static size_t maxLoad(size_t capacity) {
+            return capacity * LoadFactor / 100;
+        }
+
+        void destroySlots() {
+            if (_size == 0) {
+                return;
+            }
+            for (size_t pos = 0; pos < capacity(); ++pos) {
+                if (ctrlAt(pos) >= 0) {
+                    slot(pos).~Slot();
+                }
+            }
+            _size = 0;
+        }
+
+        void resetCtrl() {
+            for (auto &g : _ctrl) {
+                memset(g.ctrl, flat_map_impl::CTRL_EMPTY, flat_map_impl::GROUP_SIZE);
+            }
+            _growth_left = maxLoad(capacity());
+        }
+
+        int8_t ctrlAt(size_t pos) const {
+            return _ctrl[pos / flat_map_impl::GROUP_SIZE].ctrl[pos % flat_map_impl::GROUP_SIZE];
+        }
+
+        int8_t &ctrlAt(size_t pos) {
+            return _ctrl[pos / flat_map_impl::GROUP_SIZE].ctrl[pos % flat_map_impl::GROUP_SIZE];
+        }
+
+        size_t findInsertPosition(size_t hash) const {
+            auto mask = _ctrl.size() - 1;
+            auto g = groupHash(hash) & mask;
+            for (size_t i = 1; ; ++i) {
+                flat_map_impl::group grp(_ctrl[g].ctrl);
+                auto m = grp.matchEmptyOrDeleted();
+                if (m) {
+                    return g * flat_map_impl::GROUP_SIZE + m.lowest();
+                }
+                g = (g + i) & mask;
+            }
+        }
+
+        void grow(const hasher &hash_fn) {
+            // Only tombstones are left - rehashing in place is enough to reclaim them
+            if (capacity() != 0 && _size < maxLoad(capacity()) / 2) {
+                rehash(capacity(), hash_fn);
+            } else {
+                rehash(std::max(capacity() * 2, flat_map_impl::GROUP_SIZE), hash_fn);
+            }
+        }
+
+        void rehash(size_t new_capacity, const hasher &hash_fn) {
+            // Swap in the new arrays, afterwards old_ctrl and old_slots hold the current content
+            ctrl_vector old_ctrl(new_capacity / flat_map_impl::GROUP_SIZE, _ctrl.get_allocator());
+            slot_vector old_slots(new_capacity, _slots.get_allocator());
+            old_ctrl.swap(_ctrl);
+            old_slots.swap(_slots);
+
+            resetCtrl();
+            for (size_t pos = 0; pos < old_slots.size(); ++pos) {
+                if (old_ctrl[pos / flat_map_impl::GROUP_SIZE].ctrl[pos % flat_map_impl::GROUP_SIZE] < 0) {
+                    continue;
+                }
+                auto &s = *reinterpret_cast<Slot*>(&old_slots[pos]);
+                auto hash = flat_map_impl::mix(hash_fn(s.key));
+                auto new_pos = findInsertPosition(hash);
+                new(&_slots[new_pos]) Slot(std::move(s.key), std::move(s.value));
+                ctrlAt(new_pos) = ctrlHash(hash);
+                s.~Slot();
+            }
+            _growth_left = maxLoad(capacity()) - _size;
+        }
+
+        ctrl_vector _ctrl;
+        slot_vector _slots;
+        size_t _size;
+        size_t _growth_left;
+    };
+
+private: // data members
+    hasher hash_;
+    key_equal equal_;
+    allocator_type allocator_;
+    std::vector<Table, typename std::allocator_traits<allocator_type>::template rebind_alloc<Table>> _tables;
+    std::array<mutex_type, ConcurrencyLevel> _locks;
+    std::atomic_size_t _count;
+
+public: // construction and destruction
+    explicit concurrent_flat_map(const hasher &hash = hasher(),
+                                 const key_equal &equal = key_equal(),
+                                 const allocator_type &allocator = allocator_type())
+        : hash_(hash),
+          equal_(equal),
+          allocator_(allocator),
+          _tables(allocator),
+          _count(0) {
+        _tables.reserve(ConcurrencyLevel);
+        for (size_t i = 0; i < ConcurrencyLevel; ++i) {
+            _tables.emplace_back(allocator_);
+        }
+        if (InitialCapacity > 0) {
+            reserve(InitialCapacity);
+        }
+    }
+
+    allocator_type get_allocator() const {
+        return allocator_;
+    }
+
+public:
+    size_t size() {
+        return _count;
+    }
+
+    template <typename K, typename V>
+    std::pair<bool, mapped_type> insert(K && key, V && value) {
+        size_t hash = flat_map_impl::mix(hash_(key));
+        std::lock_guard<mutex_type> l(getMutex(hash));
+        auto &table = getTable(hash);
+        auto pos = table.find(hash, key, equal_);
+        if (pos != table.capacity()) {
+            auto &el = table.slot(pos).value;
+            mapped_type old_value = std::move(el);
+            el = std::forward<V>(value);
+            return std::make_pair(false, std::move(old_value));
+        }
+        table.emplace(hash, hash_, std::forward<K>(key), std::forward<V>(value));
+        _count.fetch_add(1);
+        return std::make_pair(true, mapped_type());
+    }
+
+    std::pair<bool, mapped_type> erase(const key_type &key) {
+        size_t hash = flat_map_impl::mix(hash_(key));
+        std::lock_guard<mutex_type> l(getMutex(hash));
+        auto &table = getTable(hash);
+        auto pos = table.find(hash, key, equal_);
+        if (pos == table.capacity()) {
+            return std::make_pair(false, mapped_type());
+        }
+        auto res = std::make_pair(true, std::move(table.slot(pos).value));
+        table.erase(pos);
+        _count.fetch_sub(1);
+        return res;
+    }
+
+    std::pair<bool, mapped_type> at(const key_type &key) {
+        size_t hash = flat_map_impl::mix(hash_(key));
+        std::lock_guard<mutex_type> l(getMutex(hash));
+        auto &table = getTable(hash);
+        auto pos = table.find(hash, key, equal_);
+        if (pos == table.capacity()) {
+            return std::make_pair(false, mapped_type());
+        }
+        return std::make_pair(true, table.slot(pos).value);
+    }
+
+    void clear() {
+        clear(0);
+    }
+
+    template<typename Fun>
+    void exec_on(const key_type &key, const Fun &fun) {
+        size_t hash = flat_map_impl::mix(hash_(key));
+        std::lock_guard<mutex_type> l(getMutex(hash));
+        auto &table = getTable(hash);
+        auto pos = table.find(hash, key, equal_);
+        if (pos != table.capacity()) {
+            if (fun(table.slot(pos).value)) {
+                table.erase(pos);
+                _count.fetch_sub(1);
+            }
+            return;
+        }
+        mapped_type value = mapped_type();
+        if (!fun(value)) {
+            table.emplace(hash, hash_, key, std::move(value));
+            _count.fetch_add(1);
+        }
+    }
+
+    template<typename Fun>
+    void for_each(const Fun &fun) {
+        for_each(fun, 0);
+    }
+
+    //allocates space to fit count elements
+    void reserve(size_t count) {
+        auto per_table = (count + ConcurrencyLevel - 1) / ConcurrencyLevel;
+        for (size_t i = 0; i < ConcurrencyLevel; ++i) {
+            std::lock_guard<mutex_type> l(_locks[i]);
+            _tables[i].reserve(per_table, hash_);
+        }
+    }
+
+private:
+    template<typename Fun>
+    void for_each(const Fun &fun, size_t lock) {
+        if (lock < ConcurrencyLevel) {
+            std::lock_guard<mutex_type> l(_locks[lock]);
+            for_each(fun, lock + 1);
+            return;
+        }
+        for (auto &t : _tables) {
+            t.for_each(fun);
+        }
+    }
+
+    void clear(size_t lock) {
+        if (lock < ConcurrencyLevel) {
+            std::lock_guard<mutex_type> l(_locks[lock]);
+            clear(lock + 1);
+            return;
+        }
+        for (auto &t : _tables) {
+            t.clear();
+        }
+        _count.store(0);
+    }
+
+    // The low bits of the hash select the group inside the table so use the upper half to select the table
+    size_t tableIndex(size_t hash) const {
+        return (hash >> (sizeof(size_t) * 4)) % ConcurrencyLevel;
+    }
+
+    mutex_type &getMutex(size_t hash) {
+        return _locks[tableIndex(hash)];
+    }
+
+    Table &getTable(size_t hash) {
+        return _tables[tableIndex(hash)];
+    }
+};
+
+namespace pmr {
+
+/**
+ * @brief concurrent_flat_map allocating its tables from a memory_resource
+ */
+template <
+typename Key,
+         typename T,
+         typename Hash = std::hash<Key>,
+         typename KeyEqual = std::equal_to<Key>,
+         typename MutexType = std::mutex
+         >
+using concurrent_flat_map = crossbow::concurrent_flat_map<Key, T, Hash, KeyEqual,
+        polymorphic_allocator<std::pair<const Key, T>>, MutexType>;
+
+} // namespace pmr
+
+} // namespace crossbow
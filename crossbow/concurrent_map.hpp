@@ -22,6 +22,9 @@
  */
 #pragma once
 
+#include <crossbow/alignment.hpp>
+#include <crossbow/memory_resource.hpp>
+
 #include <functional>
 #include <memory>
 #include <utility>
@@ -32,6 +35,9 @@
 #include <mutex>
 #include <type_traits>
 #include <limits>
+#include <algorithm>
+#include <cstring>
+#include <iterator>
 #include <stdint.h>
 
 namespace crossbow {
@@ -57,10 +63,26 @@ public:
     typedef Hash hasher;
     typedef KeyEqual key_equal;
     typedef Allocator allocator_type;
-    typedef typename allocator_type::pointer pointer;
-    typedef typename allocator_type::const_pointer const_pointer;
+    typedef typename std::allocator_traits<allocator_type>::pointer pointer;
+    typedef typename std::allocator_traits<allocator_type>::const_pointer const_pointer;
     typedef MutexType mutex_type;
+
+    /**
+     * @brief Whether at and find_if can read without acquiring the lock
+     *
+     * Lock-free reads copy the key and value while a writer might modify them and validate the copy afterwards, this
+     * is only allowed for trivially copyable types.
+     *
+     * As a reader might still access the bucket array replaced by a resize, readers announce themselves in a counter
+     * per lock. Replaced bucket arrays are only freed once no reader is running, until then they are kept (together
+     * they are smaller than the current array) and freed by a later resize, clear or release_retired.
+     */
+    static constexpr bool optimistic_reads = std::is_trivially_copyable<Key>::value
+            && std::is_trivially_copyable<T>::value;
 private:
+    /// Number of optimistic read attempts before falling back to the lock
+    static constexpr size_t OptimisticRetries = 4;
+
     enum class ElemState {
         UNASSIGNED,
         DELETED,
@@ -88,18 +110,48 @@ private:
 
 public: // private types
 
+    /**
+     * @brief Lock, version and element count guarded by one lock
+     *
+     * Every stripe lives on its own cache line so writers working on different locks do not invalidate each other's
+     * cache lines. The count is only modified while holding the lock. As the stripes are stored inline, heap allocated
+     * maps have to be created with crossbow::aligned_new (operator new ignores extended alignment before C++17).
+     */
+    struct alignas(cache_line_size) Stripe {
+        Stripe()
+            : version(0),
+              count(0),
+              migrated(MigrationDone) {
+        }
+
+        void increment() {
+            count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+
+        void decrement() {
+            count.store(count.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+        }
+
+        mutex_type lock;
+        std::atomic<uint64_t> version;
+        std::atomic_size_t count;
+
+        // Number of old buckets of the lock already moved into the new array (MigrationDone if nothing is left to move)
+        std::atomic_size_t migrated;
+    };
+
     struct Bucket {
         template <typename K, typename V>
         std::pair<bool, mapped_type> insert(K && key, V && value) {
 for (auto & el : arr) {
                 if (el.state == ElemState::UNASSIGNED) {
                     el.state = ElemState::VALID;
-                    el.value = value;//TODO: forward this
-                    el.key = key;
+                    el.value = std::forward<V>(value);
+                    el.key = std::forward<K>(key);
                     return std::make_pair(true, mapped_type());
                 } else if (el.state == ElemState::VALID && el.key == key) {
                     mapped_type old_value = std::move(el.value);
-                    el.value = value;//TODO: forward this
+                    el.value = std::forward<V>(value);
                     return std::make_pair(false, std::move(old_value));
                 }
             }
@@ -107,7 +159,7 @@ for (auto & el : overflow) {
                 //no need to check for validity, all entries in the vector are valid
                 if (el.key == key) {
                     mapped_type old_value = std::move(el.value);
-                    el.value = value;//TODO: forward this
+                    el.value = std::forward<V>(value);
                     return std::make_pair(false, std::move(old_value));
                 }
             }
@@ -159,6 +211,22 @@ for (auto & el : overflow) {
             return std::make_pair(false, mapped_type());
         }
 
+        template<typename Fun>
+        void find(const key_type &key, const Fun &fun) {
+            for (auto & el : arr) {
+                if (el.state == ElemState::VALID && el.key == key) {
+                    fun(el.value);
+                    return;
+                }
+            }
+            for (auto & el : overflow) {
+                if (el.key == key) {
+                    fun(el.value);
+                    return;
+                }
+            }
+        }
+
         template<typename Fun>
         void for_each(const Fun &fun) {
             for (auto i = arr.begin(); i < arr.end(); ++i) {
@@ -173,7 +241,7 @@ for (auto & el : overflow) {
         }
 
         template<typename Fun>
-        void exec_on(size_t hash, const key_type &key, const Fun &fun, std::atomic_size_t &global_count) {
+        void exec_on(size_t hash, const key_type &key, const Fun &fun, Stripe &stripe) {
             auto is_valid_and_equal = [&](KeyValueElement & el) {
                 return el.state == ElemState::VALID && el.key == key;
             };
@@ -181,7 +249,7 @@ for (auto & el : overflow) {
                 if (is_valid_and_equal(*i)) {
                     if (fun(i->value)) {
                         erase(i);
-                        global_count.fetch_sub(1);
+                        stripe.decrement();
                     }
                     return;
                 }
@@ -190,7 +258,7 @@ for (auto & el : overflow) {
                 if (is_valid_and_equal(*i)) {
                     if (fun(i->value)) {
                         erase(i);
-                        global_count.fetch_sub(1);
+                        stripe.decrement();
                     }
                     return;
                 }
@@ -198,7 +266,7 @@ for (auto & el : overflow) {
             auto p = KeyValueElement(key, mapped_type());
             if (!fun(p.value)) {
                 insertNoDuplicateCheck(std::move(p));
-                global_count.fetch_add(1);
+                stripe.increment();
             }
 
         }
@@ -215,7 +283,7 @@ for (auto & el : overflow) {
             }
         }
 
-        typedef typename allocator_type::template rebind<KeyValueElement>::other  key_value_alloc;
+        typedef typename std::allocator_traits<allocator_type>::template rebind_alloc<KeyValueElement> key_value_alloc;
         std::array<KeyValueElement, 1> arr;
         std::vector<KeyValueElement, key_value_alloc> overflow;
     private:
@@ -230,38 +298,142 @@ for (auto & el : overflow) {
                 *i = std::move(overflow.back());
                 overflow.pop_back();
             }
-            return std::make_pair(true, res);
+            return std::make_pair(true, std::move(res));
         }
 
         std::pair<bool, mapped_type> erase(decltype(overflow.begin()) i) {
             auto res = std::move(i->value);
             i->state = ElemState::UNASSIGNED;
             overflow.erase(i);
-            return std::make_pair(true, res);
+            return std::make_pair(true, std::move(res));
         }
     };
 
+    typedef std::vector<Bucket, typename std::allocator_traits<allocator_type>::template rebind_alloc<Bucket>> bucket_vector;
+
+    /**
+     * @brief Marks a modification of the buckets guarded by one lock
+     *
+     * The version of the lock is odd while the modification is in progress, optimistic readers use the version to
+     * detect concurrent writers. Must only be used while holding the associated lock.
+     */
+    class write_section {
+    public:
+        write_section(std::atomic<uint64_t> &version)
+            : _version(version) {
+            _version.store(_version.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+        }
+
+        ~write_section() {
+            _version.store(_version.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+    private:
+        std::atomic<uint64_t> &_version;
+    };
+
+    /**
+     * @brief Number of optimistic readers of the keys guarded by one lock
+     */
+    struct alignas(cache_line_size) reader_count {
+        reader_count()
+            : count(0) {
+        }
+
+        std::atomic_size_t count;
+    };
+
+    /**
+     * @brief Announces an optimistic reader while it might access a bucket array
+     */
+    class read_section {
+    public:
+        read_section(std::atomic_size_t &count)
+            : _count(count) {
+            // Sequentially consistent so the reader either sees the unpublished array or is seen by the writer
+            _count.fetch_add(1);
+        }
+
+        ~read_section() {
+            _count.fetch_sub(1, std::memory_order_release);
+        }
+
+    private:
+        std::atomic_size_t &_count;
+    };
+
 private: // data members
     hasher hash_;
     key_equal equal_;
     allocator_type allocator_;
-    std::vector<Bucket, typename allocator_type::template rebind<Bucket>::other> _buckets;
-    std::array<mutex_type, ConcurrencyLevel> _locks;
-    std::atomic_size_t _count;
+    bucket_vector _buckets;
+    std::array<Stripe, ConcurrencyLevel> _stripes;
     std::atomic_size_t _upper_bound;
     size_t bucket_flag;
 
+    // Serializes the decision to grow the table
+    mutex_type _resize_lock;
+
+    // Bucket array of the previous size while an incremental resize is in progress
+    bucket_vector _old_buckets;
+    size_t old_bucket_flag;
+
+    // Number of locks whose old buckets have not been moved completely
+    std::atomic_size_t _migrating;
+
+    // Bucket arrays and masks as seen by optimistic readers
+    std::atomic<Bucket*> _reader_buckets;
+    std::atomic_size_t _reader_flag;
+    std::atomic<Bucket*> _reader_old_buckets;
+    std::atomic_size_t _reader_old_flag;
+
+    // Bucket arrays replaced by a resize that were still visible to running optimistic readers (their overflow vectors
+    // are released immediately)
+    std::vector<bucket_vector> _retired_buckets;
+
+    // Optimistic readers per lock, empty if optimistic reads are disabled
+    std::array<reader_count, optimistic_reads ? ConcurrencyLevel : 0> _readers;
+
+private:
+    struct capacity_tag {};
+
+    concurrent_map(capacity_tag, size_t capacity, const hasher &hash, const key_equal &equal,
+                   const allocator_type &allocator)
+        : hash_(hash),
+          equal_(equal),
+          allocator_(allocator),
+          _buckets(capacity, typename bucket_vector::allocator_type(allocator)),
+          _upper_bound(capacity * LoadFactor / 100),
+          bucket_flag(((size_t) - 1) % _buckets.size()),
+          _old_buckets(_buckets.get_allocator()),
+          old_bucket_flag(0),
+          _migrating(0),
+          _reader_buckets(_buckets.data()),
+          _reader_flag(bucket_flag),
+          _reader_old_buckets(nullptr),
+          _reader_old_flag(0) {
+    }
+
 public: // construction and destruction
     explicit concurrent_map(const hasher &hash = hasher(),
                             const key_equal &equal = key_equal(),
                             const allocator_type &allocator = allocator_type())
-        : hash_(hash),
-          equal_(equal),
-          allocator_(allocator),
-          _buckets(InitialCapacity),
-          _count(0),
-          _upper_bound(InitialCapacity* LoadFactor / 100),
-          bucket_flag(((size_t) - 1) % _buckets.size()) {
+        : concurrent_map(capacity_tag(), InitialCapacity, hash, equal, allocator) {
+    }
+
+    /**
+     * @brief Bulk-loads the map from a range of key-value pairs
+     *
+     * The bucket array is sized once to fit all elements of the range.
+     */
+    template<typename ForwardIt>
+    concurrent_map(ForwardIt first, ForwardIt last,
+                   const hasher &hash = hasher(),
+                   const key_equal &equal = key_equal(),
+                   const allocator_type &allocator = allocator_type())
+        : concurrent_map(capacity_tag(), capacityFor(std::distance(first, last)), hash, equal, allocator) {
+        insert_bulk(first, last);
     }
 
     concurrent_map(const concurrent_map<Key, T, Hash, KeyEqual, Allocator, MutexType, ConcurrencyLevel, InitialCapacity, LoadFactor> &) = default;
@@ -278,34 +450,149 @@ public: // construction and destruction
     }
 
 public:
+    /**
+     * @brief Number of elements in the map
+     *
+     * Sums up the counts of all lock stripes, the result is only exact if no writer is active.
+     */
     size_t size() {
-        return _count;
+        size_t count = 0;
+        for (auto &stripe : _stripes) {
+            count += stripe.count.load(std::memory_order_relaxed);
+        }
+        return count;
     }
     template <typename K, typename V>
     std::pair<bool, mapped_type> insert(K && key, V && value) {
         size_t hash = hash_(key);
-        reserve(_count);
-        std::lock_guard<mutex_type> l(getMutex(hash));
+        auto &stripe = getStripe(hash);
+        grow(stripe);
+        bucket_vector garbage(_buckets.get_allocator());
+        std::lock_guard<mutex_type> l(stripe.lock);
+        write_section w(stripe.version);
+        migrate(hash % ConcurrencyLevel, MigrationBatch, garbage);
         auto ret = getBucket(hash).insert(std::forward<K>(key), std::forward<V>(value));
         if (ret.first)//new entry was inserted
-            _count.fetch_add(1);
+            stripe.increment();
         return ret;
     }
 
     std::pair<bool, mapped_type> erase(const key_type &key) {
         size_t hash = hash_(key);
-        std::lock_guard<mutex_type> l(getMutex(hash));
+        auto &stripe = getStripe(hash);
+        bucket_vector garbage(_buckets.get_allocator());
+        std::lock_guard<mutex_type> l(stripe.lock);
+        write_section w(stripe.version);
+        migrate(hash % ConcurrencyLevel, MigrationBatch, garbage);
         auto ret = getBucket(hash).erase(key);
         if (ret.first)//an entry was removed
-            _count.fetch_sub(1);
+            stripe.decrement();
         return ret;
 
     }
 
+    /**
+     * @brief Inserts all key-value pairs of the range
+     *
+     * Hashes the whole batch up front and acquires each lock only once for all keys it guards. Existing values are
+     * overwritten.
+     *
+     * @return Number of newly inserted keys
+     */
+    template<typename ForwardIt>
+    size_t insert_bulk(ForwardIt first, ForwardIt last) {
+        reserve(size() + std::distance(first, last));
+        size_t inserted = 0;
+        bulk_exec<true>(first, last, [](ForwardIt i) -> const key_type & {
+            return i->first;
+        }, [this, &inserted](Bucket &bucket, const bulk_item<ForwardIt> &item) {
+            if (bucket.insert(item.iter->first, item.iter->second).first) {
+                getStripe(item.hash).increment();
+                ++inserted;
+            }
+        });
+        return inserted;
+    }
+
+    /**
+     * @brief Looks up all keys of the range
+     *
+     * Writes one std::pair<bool, mapped_type> per key (in the order of the range) to out. If optimistic_reads is enabled
+     * the keys are looked up without locks, otherwise each lock is acquired once for all keys it guards.
+     */
+    template<typename ForwardIt, typename OutputIt>
+    OutputIt at_bulk(ForwardIt first, ForwardIt last, OutputIt out) {
+        return at_bulk(first, last, out, std::integral_constant<bool, optimistic_reads>());
+    }
+
+    /**
+     * @brief Erases all keys of the range
+     *
+     * @return Number of erased keys
+     */
+    template<typename ForwardIt>
+    size_t erase_bulk(ForwardIt first, ForwardIt last) {
+        size_t erased = 0;
+        bulk_exec<true>(first, last, [](ForwardIt i) -> const key_type & {
+            return *i;
+        }, [this, &erased](Bucket &bucket, const bulk_item<ForwardIt> &item) {
+            if (bucket.erase(*item.iter).first) {
+                getStripe(item.hash).decrement();
+                ++erased;
+            }
+        });
+        return erased;
+    }
+
+    /**
+     * @brief Copy of the value associated with the key
+     *
+     * If optimistic_reads is enabled the lookup does not acquire the lock unless it detects a concurrent writer.
+     */
     std::pair<bool, mapped_type> at(const key_type &key) {
+        return lookup(hash_(key), key);
+    }
+
+    /**
+     * @brief Invokes fun with a consistent snapshot of the value associated with the key
+     *
+     * fun has to take the value as a const reference and return a boolean. Like at this does not acquire the lock if
+     * optimistic_reads is enabled, fun might then be called with a private copy of the value.
+     *
+     * @return false if the key does not exist, otherwise the result of fun
+     */
+    template<typename Fun>
+    bool find_if(const key_type &key, const Fun &fun) {
         size_t hash = hash_(key);
-        std::lock_guard<mutex_type> l(getMutex(hash));
-        return getBucket(hash).at(key);
+        std::pair<bool, mapped_type> res;
+        if (tryOptimisticAt(hash, key, res, std::integral_constant<bool, optimistic_reads>())) {
+            return res.first && fun(static_cast<const mapped_type &>(res.second));
+        }
+        std::lock_guard<mutex_type> l(getStripe(hash).lock);
+        bool result = false;
+        getBucket(hash).find(key, [&fun, &result](const mapped_type &value) {
+            result = fun(value);
+        });
+        return result;
+    }
+
+    /**
+     * @brief Pointer to the object owned by the value associated with the key, nullptr if the key does not exist
+     *
+     * Only available if mapped_type is a pointer type like crossbow::epoch_ptr. Unlike at this does not copy the object.
+     * With crossbow::epoch_ptr the object is only destroyed through the epoch based crossbow::allocator, so the pointer
+     * stays valid as long as the caller holds a crossbow::allocator guard acquired before calling get - even if the key
+     * is overwritten or erased concurrently.
+     */
+    template<typename V = mapped_type>
+    auto get(const key_type &key) -> decltype(std::declval<const V &>().get()) {
+        size_t hash = hash_(key);
+        decltype(std::declval<const V &>().get()) result = nullptr;
+        std::lock_guard<mutex_type> l(getStripe(hash).lock);
+        getBucket(hash).find(key, [&result](const mapped_type &value) {
+            result = value.get();
+        });
+        return result;
     }
 
     void clear() {
@@ -315,9 +602,13 @@ public:
     template<typename Fun>
     void exec_on(const key_type &key, const Fun &fun) {
         size_t hash = hash_(key);
-        reserve(_count);
-        std::lock_guard<mutex_type> l(getMutex(hash));
-        getBucket(hash).exec_on(hash, key, fun, _count);
+        auto &stripe = getStripe(hash);
+        grow(stripe);
+        bucket_vector garbage(_buckets.get_allocator());
+        std::lock_guard<mutex_type> l(stripe.lock);
+        write_section w(stripe.version);
+        migrate(hash % ConcurrencyLevel, MigrationBatch, garbage);
+        getBucket(hash).exec_on(hash, key, fun, stripe);
     }
 
     template<typename Fun>
@@ -325,28 +616,203 @@ public:
         for_each(fun, 0);
     }
 
-    //allocates space to fit count elements
+    /**
+     * @brief Allocates space to fit count elements
+     *
+     * The elements are moved into the bigger bucket array incrementally by subsequent writes.
+     */
     void reserve(size_t count) {
         if (count < _upper_bound.load(std::memory_order_acquire))
             return;
-        std::lock_guard<mutex_type> l(_locks[0]);
+        std::lock_guard<mutex_type> l(_resize_lock);
+        resize(count);
+    }
+
+    /**
+     * @brief Frees the bucket arrays replaced by previous resizes unless an optimistic reader is running
+     *
+     * Only needed if optimistic_reads is enabled, otherwise replaced arrays are freed right away. Resizes and clear
+     * free them as well, this can be called after loading the map to release them right away.
+     *
+     * @return Whether all replaced bucket arrays were freed
+     */
+    bool release_retired() {
+        std::vector<bucket_vector> garbage;
+        release_retired(garbage, 0);
+        return _retired_buckets.empty();
+    }
+
+private:
+    /// Marks a lock without any old buckets left to move
+    static constexpr size_t MigrationDone = std::numeric_limits<size_t>::max();
+
+    /// Maximum number of old buckets a single write moves into the new bucket array
+    static constexpr size_t MigrationBatch = 8;
+
+    static_assert(ConcurrencyLevel > 0 && (ConcurrencyLevel & (ConcurrencyLevel - 1)) == 0,
+            "Concurrency level must be a power of two");
+    static_assert(InitialCapacity >= ConcurrencyLevel && (InitialCapacity & (InitialCapacity - 1)) == 0,
+            "Initial capacity must be a power of two and not smaller than the concurrency level");
+
+    /// Number of elements a bulk operation prefetches the bucket ahead
+    static constexpr size_t PrefetchDistance = 8;
+
+    template<typename Iter>
+    struct bulk_item {
+        size_t hash;
+        size_t index;
+        Iter iter;
+    };
+
+    std::pair<bool, mapped_type> lookup(size_t hash, const key_type &key) {
+        std::pair<bool, mapped_type> res;
+        if (tryOptimisticAt(hash, key, res, std::integral_constant<bool, optimistic_reads>())) {
+            return res;
+        }
+        std::lock_guard<mutex_type> l(getStripe(hash).lock);
+        return getBucket(hash).at(key);
+    }
+
+    template<typename ForwardIt, typename OutputIt>
+    OutputIt at_bulk(ForwardIt first, ForwardIt last, OutputIt out, std::false_type) {
+        std::vector<std::pair<bool, mapped_type>> results(std::distance(first, last));
+        bulk_exec<false>(first, last, [](ForwardIt i) -> const key_type & {
+            return *i;
+        }, [&results](Bucket &bucket, const bulk_item<ForwardIt> &item) {
+            results[item.index] = bucket.at(*item.iter);
+        });
+        return std::move(results.begin(), results.end(), out);
+    }
+
+    /**
+     * @brief Bulk lookup without locks - keys are looked up in order while prefetching the buckets ahead
+     */
+    template<typename ForwardIt, typename OutputIt>
+    OutputIt at_bulk(ForwardIt first, ForwardIt last, OutputIt out, std::true_type) {
+        std::vector<size_t> hashes;
+        hashes.reserve(std::distance(first, last));
+        for (auto i = first; i != last; ++i) {
+            hashes.push_back(hash_(*i));
+        }
+        for (size_t i = 0; i < PrefetchDistance && i < hashes.size(); ++i) {
+            prefetchOptimistic(hashes[i]);
+        }
+        size_t index = 0;
+        for (auto i = first; i != last; ++i, ++index) {
+            if (index + PrefetchDistance < hashes.size()) {
+                prefetchOptimistic(hashes[index + PrefetchDistance]);
+            }
+            *out = lookup(hashes[index], *i);
+            ++out;
+        }
+        return out;
+    }
+
+    void prefetchOptimistic(size_t hash) {
+        auto flag = _reader_flag.load(std::memory_order_acquire);
+        __builtin_prefetch(_reader_buckets.load(std::memory_order_acquire) + (hash & flag));
+    }
+
+    /**
+     * @brief Smallest bucket array size fitting count elements
+     */
+    static size_t capacityFor(size_t count) {
+        size_t capacity = InitialCapacity;
+        while (capacity * LoadFactor / 100 <= count) {
+            capacity *= 2;
+        }
+        return capacity;
+    }
+
+    /**
+     * @brief Invokes fun on the bucket of every key in the range while holding the lock of the key
+     *
+     * The keys are grouped by lock (stable counting sort) so every lock is acquired at most once, buckets are prefetched
+     * PrefetchDistance elements ahead. If Write is set the buckets are modified and optimistic readers are notified.
+     */
+    template<bool Write, typename ForwardIt, typename KeyFun, typename Fun>
+    void bulk_exec(ForwardIt first, ForwardIt last, const KeyFun &keyOf, const Fun &fun) {
+        std::vector<size_t> hashes;
+        hashes.reserve(std::distance(first, last));
+        std::array<size_t, ConcurrencyLevel + 1> offsets;
+        offsets.fill(0);
+        for (auto i = first; i != last; ++i) {
+            hashes.push_back(hash_(keyOf(i)));
+            ++offsets[hashes.back() % ConcurrencyLevel + 1];
+        }
+        for (size_t lock = 0; lock < ConcurrencyLevel; ++lock) {
+            offsets[lock + 1] += offsets[lock];
+        }
+
+        std::vector<bulk_item<ForwardIt>> items(hashes.size());
+        {
+            auto pos = offsets;
+            size_t index = 0;
+            for (auto i = first; i != last; ++i, ++index) {
+                auto &item = items[pos[hashes[index] % ConcurrencyLevel]++];
+                item.hash = hashes[index];
+                item.index = index;
+                item.iter = i;
+            }
+        }
+
+        for (size_t lock = 0; lock < ConcurrencyLevel; ++lock) {
+            auto begin = offsets[lock];
+            auto end = offsets[lock + 1];
+            if (begin == end) {
+                continue;
+            }
+            bucket_vector garbage(_buckets.get_allocator());
+            std::lock_guard<mutex_type> l(_stripes[lock].lock);
+            if (Write) {
+                write_section w(_stripes[lock].version);
+                migrate(lock, MigrationBatch, garbage);
+                bulk_process(items, begin, end, fun);
+            } else {
+                bulk_process(items, begin, end, fun);
+            }
+        }
+    }
+
+    template<typename Item, typename Fun>
+    void bulk_process(const std::vector<Item> &items, size_t begin, size_t end, const Fun &fun) {
+        for (auto i = begin; i < std::min(begin + PrefetchDistance, end); ++i) {
+            __builtin_prefetch(&getBucket(items[i].hash));
+        }
+        for (auto i = begin; i < end; ++i) {
+            if (i + PrefetchDistance < end) {
+                __builtin_prefetch(&getBucket(items[i + PrefetchDistance].hash));
+            }
+            fun(getBucket(items[i].hash), items[i]);
+        }
+    }
+
+    /**
+     * @brief Starts a resize if the table is full, unless another thread is already resizing
+     *
+     * The count of the stripe only serves as a trigger so writers do not have to read the counters of all other stripes
+     * on every insert. With skewed hashes a single stripe holds much more than its share, the table therefore only
+     * grows if the sum of all stripes exceeds the bound.
+     */
+    void grow(Stripe &stripe) {
+        auto count = stripe.count.load(std::memory_order_relaxed) * ConcurrencyLevel;
         if (count < _upper_bound.load(std::memory_order_acquire))
             return;
-        auto new_size = _buckets.size() * 2;
-        while (new_size *  LoadFactor / 100 < count) {
-            new_size *= 2;
-        }
-        return resize(new_size, 1);
+        std::unique_lock<mutex_type> l(_resize_lock, std::try_to_lock);
+        if (!l.owns_lock())
+            return;
+        resize(size());
     }
 
-private:
     template<typename Fun>
     void for_each(const Fun &fun, size_t lock) {
         if (lock < ConcurrencyLevel) {
-            std::lock_guard<mutex_type> l(_locks[lock]);
+            std::lock_guard<mutex_type> l(_stripes[lock].lock);
+            write_section w(_stripes[lock].version);
             for_each(fun, lock + 1);
             return;
         }
+        migrateAll();
 for (Bucket & b : _buckets) {
             b.for_each(fun);
         }
@@ -354,50 +820,266 @@ for (Bucket & b : _buckets) {
 
     void clear(size_t lock) {
         if (lock < ConcurrencyLevel) {
-            std::lock_guard<mutex_type> l(_locks[lock]);
+            std::lock_guard<mutex_type> l(_stripes[lock].lock);
+            write_section w(_stripes[lock].version);
             clear(lock + 1);
             return;
         }
+        migrateAll();
 for (Bucket & b : _buckets) {
             b.clear();
         }
+        for (auto &stripe : _stripes) {
+            stripe.count.store(0, std::memory_order_relaxed);
+        }
+        if (!readersActive()) {
+            _retired_buckets.clear();
+        }
     }
 
-    mutex_type &getMutex(size_t hash) {
-        return _locks[hash % ConcurrencyLevel];
+    void release_retired(std::vector<bucket_vector> &garbage, size_t lock) {
+        if (lock < ConcurrencyLevel) {
+            std::lock_guard<mutex_type> l(_stripes[lock].lock);
+            release_retired(garbage, lock + 1);
+            return;
+        }
+        if (!readersActive()) {
+            garbage.swap(_retired_buckets);
+        }
+    }
+
+    /**
+     * @brief Whether an optimistic reader might still access a bucket array that is no longer published
+     */
+    bool readersActive() {
+        // Pairs with the increment of read_section, the arrays were unpublished before
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        for (auto &readers : _readers) {
+            if (readers.count.load(std::memory_order_acquire) != 0) {
+                return true;
+            }
+        }
+        return false;
     }
 
+    Stripe &getStripe(size_t hash) {
+        return _stripes[hash % ConcurrencyLevel];
+    }
+
+    /**
+     * @brief The bucket currently holding the given hash
+     *
+     * As long as the old bucket of the hash has not been moved the element is still in the old bucket array. Must only
+     * be called while holding the lock of the hash.
+     */
     Bucket &getBucket(size_t hash) {
+        auto migrated = getStripe(hash).migrated.load(std::memory_order_relaxed);
+        if (migrated != MigrationDone) {
+            auto index = hash & old_bucket_flag;
+            if (index / ConcurrencyLevel >= migrated) {
+                return _old_buckets[index];
+            }
+        }
         return _buckets[hash & bucket_flag];
     }
 
-    void resize(size_t new_size, size_t lock_index) {
+    /**
+     * @brief Switches to a bigger bucket array fitting count elements
+     *
+     * Only swaps the bucket arrays, the elements are moved into the new buckets by later writes. Must only be called
+     * while holding the resize lock.
+     */
+    void resize(size_t count) {
+        if (count < _upper_bound.load(std::memory_order_acquire))
+            return;
+
+        // Move all elements left from the previous resize
+        for (size_t lock = 0; lock < ConcurrencyLevel; ++lock) {
+            bucket_vector garbage(_buckets.get_allocator());
+            std::lock_guard<mutex_type> l(_stripes[lock].lock);
+            write_section w(_stripes[lock].version);
+            migrate(lock, MigrationDone, garbage);
+        }
+
+        auto new_size = _buckets.size() * 2;
+        while (new_size *  LoadFactor / 100 < count) {
+            new_size *= 2;
+        }
+        // Allocate the new buckets before acquiring any bucket lock
+        bucket_vector new_buckets(new_size, _buckets.get_allocator());
+        swapBuckets(new_buckets, 0);
+    }
+
+    void swapBuckets(bucket_vector &new_buckets, size_t lock_index) {
         if (lock_index < ConcurrencyLevel) {
-            std::lock_guard<mutex_type> l(_locks[lock_index]);
-            return resize(new_size, lock_index + 1);
+            std::lock_guard<mutex_type> l(_stripes[lock_index].lock);
+            write_section w(_stripes[lock_index].version);
+            return swapBuckets(new_buckets, lock_index + 1);
         }
         //everything is locked
-        //move old buckets
-        std::vector<Bucket, typename allocator_type::template rebind<Bucket>::other> old_buckets(std::move(_buckets));
-        bucket_flag = ((size_t) - 1) % new_size;
-        _upper_bound.store(new_size *  LoadFactor / 100, std::memory_order_release);
-        _buckets.resize(new_size);
-for (Bucket & buk : old_buckets) {
-            bool done = false;
+        _old_buckets = std::move(_buckets);
+        old_bucket_flag = bucket_flag;
+        _buckets = std::move(new_buckets);
+        bucket_flag = ((size_t) - 1) % _buckets.size();
+        _upper_bound.store(_buckets.size() *  LoadFactor / 100, std::memory_order_release);
+        for (auto &stripe : _stripes) {
+            stripe.migrated.store(0, std::memory_order_relaxed);
+        }
+        _migrating.store(ConcurrencyLevel);
+
+        // Readers load the mask first, publishing the array before the mask keeps every index in bounds
+        _reader_old_buckets.store(_old_buckets.data(), std::memory_order_release);
+        _reader_old_flag.store(old_bucket_flag, std::memory_order_release);
+        _reader_buckets.store(_buckets.data(), std::memory_order_release);
+        _reader_flag.store(bucket_flag, std::memory_order_release);
+    }
+
+    /**
+     * @brief Moves up to count old buckets guarded by the given lock into the new bucket array
+     *
+     * Old buckets are moved in increasing order, i.e. the first migrated old buckets of the lock are empty. If
+     * this finishes the resize the old bucket array is handed over to garbage, the caller has to destroy it after
+     * releasing the lock. Must only be called while holding the lock.
+     */
+    void migrate(size_t lock, size_t count, bucket_vector &garbage) {
+        auto migrated = _stripes[lock].migrated.load(std::memory_order_relaxed);
+        if (migrated == MigrationDone) {
+            return;
+        }
+        auto total = _old_buckets.size() / ConcurrencyLevel;
+        auto end = (count < total - migrated ? migrated + count : total);
+        for (; migrated < end; ++migrated) {
+            Bucket &buk = _old_buckets[migrated * ConcurrencyLevel + lock];
 for (auto & el : buk.arr) {
                 if (el.state == ElemState::UNASSIGNED) {
-                    done = true;
                     break;
                 }
-                getBucket(hash_(el.key)).insertNoDuplicateCheck(std::move(el));
+                _buckets[hash_(el.key) & bucket_flag].insertNoDuplicateCheck(std::move(el));
+                el.state = ElemState::UNASSIGNED;
             }
-            if (done)
-                continue;
 for (auto & el : buk.overflow) {
-                getBucket(hash_(el.key)).insertNoDuplicateCheck(std::move(el));
+                _buckets[hash_(el.key) & bucket_flag].insertNoDuplicateCheck(std::move(el));
+            }
+            decltype(buk.overflow)().swap(buk.overflow);
+        }
+        if (migrated != total) {
+            _stripes[lock].migrated.store(migrated, std::memory_order_relaxed);
+            return;
+        }
+        _stripes[lock].migrated.store(MigrationDone, std::memory_order_relaxed);
+        if (_migrating.fetch_sub(1) == 1) {
+            // Nobody accesses the old buckets anymore (except for optimistic readers)
+            retire(garbage, std::integral_constant<bool, optimistic_reads>());
+        }
+    }
+
+    /**
+     * @brief Finishes a running resize - must only be called while holding all locks
+     */
+    void migrateAll() {
+        bucket_vector garbage(_buckets.get_allocator());
+        for (size_t lock = 0; lock < ConcurrencyLevel; ++lock) {
+            migrate(lock, MigrationDone, garbage);
+        }
+    }
+
+    void retire(bucket_vector &garbage, std::false_type) {
+        garbage.swap(_old_buckets);
+    }
+
+    void retire(bucket_vector &garbage, std::true_type) {
+        // Unpublish the array, readers loading the null pointer read from the new array
+        _reader_old_buckets.store(nullptr);
+        if (!readersActive()) {
+            garbage.swap(_old_buckets);
+            _retired_buckets.clear();
+            return;
+        }
+        // The overflow vectors were already released by migrate
+        _retired_buckets.emplace_back(std::move(_old_buckets));
+        _old_buckets.clear();
+    }
+
+    template<typename Res>
+    bool tryOptimisticAt(size_t, const key_type &, Res &, std::false_type) {
+        return false;
+    }
+
+    /**
+     * @brief Lock-free lookup validated with the version of the lock
+     *
+     * Only the inline element of the bucket is inspected, if the key is not there and the bucket has overflow elements
+     * the caller has to fall back to the locked lookup.
+     */
+    template<typename Res>
+    bool tryOptimisticAt(size_t hash, const key_type &key, Res &res, std::true_type) {
+        read_section r(_readers[hash % ConcurrencyLevel].count);
+        auto &version = getStripe(hash).version;
+        for (size_t i = 0; i < OptimisticRetries; ++i) {
+            auto before = version.load(std::memory_order_acquire);
+            if (before % 2 != 0) {
+                continue;
+            }
+
+            Bucket* bucket = nullptr;
+            auto migrated = getStripe(hash).migrated.load(std::memory_order_relaxed);
+            if (migrated != MigrationDone) {
+                auto flag = _reader_old_flag.load(std::memory_order_acquire);
+                auto index = hash & flag;
+                auto old = _reader_old_buckets.load();
+                if (old && index / ConcurrencyLevel >= migrated) {
+                    bucket = old + index;
+                }
+            }
+            if (!bucket) {
+                auto flag = _reader_flag.load(std::memory_order_acquire);
+                bucket = _reader_buckets.load() + (hash & flag);
+            }
+            auto &el = bucket->arr[0];
+
+            ElemState state;
+            typename std::aligned_storage<sizeof(key_type), alignof(key_type)>::type keyCopy;
+            memcpy(&state, &el.state, sizeof(state));
+            memcpy(&keyCopy, &el.key, sizeof(key_type));
+            memcpy(&res.second, &el.value, sizeof(mapped_type));
+            bool hasOverflow = !bucket->overflow.empty();
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (version.load(std::memory_order_relaxed) != before) {
+                continue;
+            }
+
+            if (state == ElemState::VALID && equal_(*reinterpret_cast<const key_type*>(&keyCopy), key)) {
+                res.first = true;
+                return true;
             }
+            if (hasOverflow) {
+                return false;
+            }
+            res = std::make_pair(false, mapped_type());
+            return true;
         }
+        return false;
     }
 };
 
+namespace pmr {
+
+/**
+ * @brief concurrent_map allocating its bucket array from a memory_resource
+ *
+ * The overflow lists of the buckets use the default resource.
+ */
+template <
+typename Key,
+         typename T,
+         typename Hash = std::hash<Key>,
+         typename KeyEqual = std::equal_to<Key>,
+         typename MutexType = std::mutex
+         >
+using concurrent_map = crossbow::concurrent_map<Key, T, Hash, KeyEqual,
+        polymorphic_allocator<std::pair<const Key, T>>, MutexType>;
+
+} // namespace pmr
+
 } // namespace crossbow
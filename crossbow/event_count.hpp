@@ -0,0 +1,107 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#pragma once
+
+#include <crossbow/non_copyable.hpp>
+
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <thread>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace crossbow {
+
+/**
+ * @brief Lets threads sleep until a condition guarded by lock-free code might have changed
+ *
+ * A waiter announces itself with prepare_wait, checks its condition once more and only then calls wait with the
+ * returned key. A notifier first makes its change visible and then calls notify_all. If no thread is waiting notify_all
+ * only costs a fence and a load, otherwise it wakes all waiters through a futex (on other platforms waiters yield).
+ */
+class event_count : non_copyable, non_movable {
+public:
+    event_count()
+        : mEpoch(0),
+          mWaiters(0) {
+    }
+
+    uint32_t prepare_wait() {
+        mWaiters.fetch_add(1, std::memory_order_seq_cst);
+        return mEpoch.load(std::memory_order_seq_cst);
+    }
+
+    void cancel_wait() {
+        mWaiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Sleeps until notify_all was called after prepare_wait returned key
+     */
+    void wait(uint32_t key) {
+        while (mEpoch.load(std::memory_order_acquire) == key) {
+#ifdef __linux__
+            syscall(SYS_futex, reinterpret_cast<uint32_t*>(&mEpoch), FUTEX_WAIT_PRIVATE, key, nullptr, nullptr, 0);
+#else
+            std::this_thread::yield();
+#endif
+        }
+        mWaiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void notify_all() {
+        notify(INT_MAX);
+    }
+
+    /**
+     * @brief Wakes up to count waiters
+     *
+     * Waiters that are not woken keep sleeping until the next notification, so this must only be used if every waiter
+     * that is woken and finds its condition unchanged will wait again.
+     */
+    void notify(int count) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (mWaiters.load(std::memory_order_relaxed) == 0) {
+            return;
+        }
+        mEpoch.fetch_add(1, std::memory_order_seq_cst);
+#ifdef __linux__
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&mEpoch), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+#else
+        (void) count;
+#endif
+    }
+
+private:
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "Futex word must be a plain 32 bit integer");
+
+    std::atomic<uint32_t> mEpoch;
+    std::atomic<uint32_t> mWaiters;
+};
+
+} // namespace crossbow
@@ -0,0 +1,241 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#pragma once
+
+#include <crossbow/bounded_stack.hpp>
+#include <crossbow/fixed_size_stack.hpp>
+#include <crossbow/non_copyable.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace crossbow {
+
+/**
+ * @brief Per-thread magazine caches in front of a shared stack of free IDs
+ *
+ * Every thread accessing the stack creates its own magazine_depot::cache. A cache holds two magazines (arrays of up to
+ * MagazineSize elements) and serves push and pop from them without any atomic operation. Only if both magazines are
+ * full (respectively empty) the cache exchanges a whole magazine with the depot, which keeps a lock-free list of full
+ * magazines. If the depot has no full magazine left elements are taken from the shared stack directly, if it has no
+ * space left they are returned to the shared stack.
+ *
+ * Elements cached by a thread are not available to other threads until the cache is destroyed. All caches have to be
+ * destroyed before the depot, the depot returns its magazines to the shared stack on destruction.
+ */
+template <class T, size_t MagazineSize = 32, class Stack = fixed_size_stack<T>>
+class magazine_depot : crossbow::non_copyable, crossbow::non_movable {
+    static_assert(MagazineSize > 0, "Magazines must not be empty");
+
+    typedef std::array<T, MagazineSize> magazine;
+
+public:
+    /**
+     * @brief Thread local cache - must only be used by one thread at a time
+     */
+    class cache : crossbow::non_copyable, crossbow::non_movable {
+    public:
+        explicit cache(magazine_depot& depot)
+            : mDepot(depot),
+              mMagazines(),
+              mLoaded(mMagazines.data()),
+              mLoadedSize(0),
+              mPrevious(mMagazines.data() + 1),
+              mPreviousSize(0),
+              mHits(0),
+              mMisses(0) {
+        }
+
+        ~cache() {
+            for (size_t i = 0; i < mLoadedSize; ++i) {
+                mDepot.mStack.push((*mLoaded)[i]);
+            }
+            for (size_t i = 0; i < mPreviousSize; ++i) {
+                mDepot.mStack.push((*mPrevious)[i]);
+            }
+            mDepot.mHits.fetch_add(mHits, std::memory_order_relaxed);
+            mDepot.mMisses.fetch_add(mMisses, std::memory_order_relaxed);
+        }
+
+        /**
+         * @return True if pop succeeded - result will be set to the popped element
+         */
+        bool pop(T& result) {
+            if (mLoadedSize == 0 && mPreviousSize != 0) {
+                swap();
+            }
+            if (mLoadedSize == 0) {
+                ++mMisses;
+                mLoadedSize = mDepot.fill(*mLoaded);
+                if (mLoadedSize == 0) {
+                    return false;
+                }
+            } else {
+                ++mHits;
+            }
+            result = (*mLoaded)[--mLoadedSize];
+            return true;
+        }
+
+        void push(T element) {
+            if (mLoadedSize == MagazineSize && mPreviousSize == 0) {
+                swap();
+            }
+            if (mLoadedSize == MagazineSize) {
+                ++mMisses;
+                mDepot.drain(*mLoaded);
+                mLoadedSize = 0;
+            } else {
+                ++mHits;
+            }
+            (*mLoaded)[mLoadedSize++] = element;
+        }
+
+        /**
+         * @brief Number of operations served from the magazines of this cache
+         */
+        uint64_t hits() const {
+            return mHits;
+        }
+
+        /**
+         * @brief Number of operations that had to exchange a magazine with the depot
+         */
+        uint64_t misses() const {
+            return mMisses;
+        }
+
+    private:
+        void swap() {
+            std::swap(mLoaded, mPrevious);
+            std::swap(mLoadedSize, mPreviousSize);
+        }
+
+        magazine_depot& mDepot;
+
+        std::array<magazine, 2> mMagazines;
+
+        /// Magazine push and pop operate on
+        magazine* mLoaded;
+        size_t mLoadedSize;
+
+        /// Magazine that is either full or empty
+        magazine* mPrevious;
+        size_t mPreviousSize;
+
+        uint64_t mHits;
+        uint64_t mMisses;
+    };
+
+    /**
+     * @param stack Shared stack the elements are taken from and returned to
+     * @param magazines Maximum number of full magazines kept in the depot
+     */
+    magazine_depot(Stack& stack, size_t magazines = 64)
+        : mStack(stack),
+          mMagazines(magazines),
+          mFull(magazines),
+          mEmpty(magazines),
+          mHits(0),
+          mMisses(0) {
+        for (uint32_t i = 0; i < magazines; ++i) {
+            mEmpty.push(i);
+        }
+    }
+
+    ~magazine_depot() {
+        uint32_t index;
+        while (mFull.pop(index)) {
+            for (auto& element : mMagazines[index]) {
+                mStack.push(element);
+            }
+        }
+    }
+
+    /**
+     * @brief Operations served by thread local magazines of all destroyed caches
+     */
+    uint64_t hits() const {
+        return mHits.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Magazine exchanges with the depot of all destroyed caches
+     */
+    uint64_t misses() const {
+        return mMisses.load(std::memory_order_relaxed);
+    }
+
+private:
+    /**
+     * @brief Fills the magazine with a full magazine from the depot or with elements from the shared stack
+     *
+     * @return Number of elements in the magazine
+     */
+    size_t fill(magazine& target) {
+        uint32_t index;
+        if (mFull.pop(index)) {
+            target = mMagazines[index];
+            mEmpty.push(index);
+            return MagazineSize;
+        }
+        size_t count = 0;
+        while (count < MagazineSize && mStack.pop(target[count])) {
+            ++count;
+        }
+        return count;
+    }
+
+    /**
+     * @brief Stores the full magazine in the depot or returns its elements to the shared stack
+     */
+    void drain(const magazine& source) {
+        uint32_t index;
+        if (mEmpty.pop(index)) {
+            mMagazines[index] = source;
+            mFull.push(index);
+            return;
+        }
+        for (auto& element : source) {
+            mStack.push(element);
+        }
+    }
+
+    Stack& mStack;
+
+    /// Contents of the magazines stored in the depot
+    std::vector<magazine> mMagazines;
+
+    /// Indexes of full respectively unused magazines
+    bounded_stack<uint32_t> mFull;
+    bounded_stack<uint32_t> mEmpty;
+
+    std::atomic<uint64_t> mHits;
+    std::atomic<uint64_t> mMisses;
+};
+
+} // namespace crossbow
@@ -0,0 +1,218 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <new>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(__has_include)
+#if __cplusplus >= 201703L && __has_include(<memory_resource>)
+#include <memory_resource>
+#define CROSSBOW_STD_PMR 1
+#endif
+#endif
+
+namespace crossbow {
+
+#ifdef CROSSBOW_STD_PMR
+
+using std::pmr::memory_resource;
+using std::pmr::polymorphic_allocator;
+using std::pmr::new_delete_resource;
+using std::pmr::get_default_resource;
+using std::pmr::set_default_resource;
+
+#else
+
+/**
+ * @brief Interface of a memory source that can be selected at runtime
+ *
+ * Same interface as std::pmr::memory_resource, which it becomes an alias of when compiling with C++17.
+ */
+class memory_resource {
+public:
+    virtual ~memory_resource() = default;
+
+    void* allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t)) {
+        return do_allocate(bytes, alignment);
+    }
+
+    void deallocate(void* p, std::size_t bytes, std::size_t alignment = alignof(std::max_align_t)) {
+        do_deallocate(p, bytes, alignment);
+    }
+
+    bool is_equal(const memory_resource& other) const noexcept {
+        return do_is_equal(other);
+    }
+
+private:
+    virtual void* do_allocate(std::size_t bytes, std::size_t alignment) = 0;
+
+    virtual void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) = 0;
+
+    virtual bool do_is_equal(const memory_resource& other) const noexcept = 0;
+};
+
+inline bool operator==(const memory_resource& lhs, const memory_resource& rhs) noexcept {
+    return &lhs == &rhs || lhs.is_equal(rhs);
+}
+
+inline bool operator!=(const memory_resource& lhs, const memory_resource& rhs) noexcept {
+    return !(lhs == rhs);
+}
+
+namespace impl {
+
+class new_delete_resource : public memory_resource {
+private:
+    virtual void* do_allocate(std::size_t bytes, std::size_t) override {
+        return ::operator new(bytes);
+    }
+
+    virtual void do_deallocate(void* p, std::size_t, std::size_t) override {
+        ::operator delete(p);
+    }
+
+    virtual bool do_is_equal(const memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+inline std::atomic<memory_resource*>& default_resource();
+
+} // namespace impl
+
+/**
+ * @brief Resource using the global operator new and delete
+ *
+ * Alignments beyond alignof(std::max_align_t) are not supported as C++11 has no aligned operator new.
+ */
+inline memory_resource* new_delete_resource() noexcept {
+    static impl::new_delete_resource resource;
+    return &resource;
+}
+
+namespace impl {
+
+inline std::atomic<memory_resource*>& default_resource() {
+    static std::atomic<memory_resource*> resource(crossbow::new_delete_resource());
+    return resource;
+}
+
+} // namespace impl
+
+/**
+ * @brief Resource used by default constructed polymorphic_allocators
+ */
+inline memory_resource* get_default_resource() noexcept {
+    return impl::default_resource().load(std::memory_order_acquire);
+}
+
+/**
+ * @brief Replaces the default resource, returns the previous one
+ */
+inline memory_resource* set_default_resource(memory_resource* resource) noexcept {
+    return impl::default_resource().exchange(resource ? resource : new_delete_resource(), std::memory_order_acq_rel);
+}
+
+/**
+ * @brief Allocator forwarding to a memory_resource
+ *
+ * Containers using different resources have the same type. Unlike std::pmr::polymorphic_allocator the resource is
+ * not passed on to the elements of a container.
+ */
+template <typename T>
+class polymorphic_allocator {
+public:
+    using value_type = T;
+
+    polymorphic_allocator() noexcept
+        : mResource(get_default_resource()) {
+    }
+
+    polymorphic_allocator(memory_resource* resource)
+        : mResource(resource) {
+    }
+
+    template <typename U>
+    polymorphic_allocator(const polymorphic_allocator<U>& other) noexcept
+        : mResource(other.resource()) {
+    }
+
+    polymorphic_allocator& operator=(const polymorphic_allocator&) = delete;
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(mResource->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n) {
+        mResource->deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    polymorphic_allocator select_on_container_copy_construction() const {
+        return polymorphic_allocator();
+    }
+
+    memory_resource* resource() const {
+        return mResource;
+    }
+
+private:
+    memory_resource* mResource;
+};
+
+template <typename T, typename U>
+inline bool operator==(const polymorphic_allocator<T>& lhs, const polymorphic_allocator<U>& rhs) noexcept {
+    return *lhs.resource() == *rhs.resource();
+}
+
+template <typename T, typename U>
+inline bool operator!=(const polymorphic_allocator<T>& lhs, const polymorphic_allocator<U>& rhs) noexcept {
+    return !(lhs == rhs);
+}
+
+#endif
+
+/**
+ * @brief Containers supported by the serializer allocating from a memory_resource
+ */
+namespace pmr {
+
+template <typename T>
+using vector = std::vector<T, polymorphic_allocator<T>>;
+
+template <typename Key, typename T, typename Compare = std::less<Key>>
+using map = std::map<Key, T, Compare, polymorphic_allocator<std::pair<const Key, T>>>;
+
+template <typename Key, typename T, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+using unordered_map = std::unordered_map<Key, T, Hash, KeyEqual, polymorphic_allocator<std::pair<const Key, T>>>;
+
+} // namespace pmr
+
+} // namespace crossbow
@@ -0,0 +1,334 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#pragma once
+
+#include <crossbow/alignment.hpp>
+#include <crossbow/event_count.hpp>
+#include <crossbow/non_copyable.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace crossbow {
+
+/**
+ * @brief Bounded lock-free queue supporting multiple producers and multiple consumers
+ *
+ * Ring buffer of QueueSize slots where every slot carries a sequence number telling whether it is free or filled for
+ * the current round (D. Vyukov's bounded MPMC queue). Producers and consumers only synchronize through a CAS on the
+ * tail respectively head position and the sequence number of their slot. Every slot is on its own cache line so
+ * neighbouring producers do not invalidate each other.
+ *
+ * write blocks while the queue is full and read_wait while the queue is empty, both yield a few times before they sleep
+ * on a futex. All other operations never block.
+ *
+ * The slots and positions are cache line aligned, heap allocated instances therefore have to be created with
+ * crossbow::aligned_new (operator new ignores extended alignment before C++17).
+ */
+template <typename T, size_t QueueSize>
+class mpmc_queue : crossbow::non_copyable, crossbow::non_movable {
+    static_assert(QueueSize >= 2 && (QueueSize & (QueueSize - 1)) == 0, "Queue size must be a power of two");
+
+    struct alignas(cache_line_size) Slot {
+        T* value() {
+            return reinterpret_cast<T*>(&storage);
+        }
+
+        std::atomic_size_t sequence;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+    };
+
+    /// Number of times a blocking operation yields before it goes to sleep
+    static constexpr size_t SpinCount = 16;
+
+public:
+    mpmc_queue()
+        : mHead(0),
+          mTail(0) {
+        for (size_t i = 0; i < QueueSize; ++i) {
+            mSlots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~mpmc_queue() {
+        auto tail = mTail.load();
+        for (auto pos = mHead.load(); pos != tail; ++pos) {
+            auto &slot = getSlot(pos);
+            if (slot.sequence.load() == pos + 1) {
+                slot.value()->~T();
+            }
+        }
+    }
+
+    /**
+     * @brief Enqueues an element constructed from the arguments, blocks while the queue is full
+     */
+    template <class... Args>
+    void write(Args&&... args) {
+        size_t pos;
+        auto slot = claimWrite(pos);
+        for (size_t i = 0; !slot && i < SpinCount; ++i) {
+            std::this_thread::yield();
+            slot = claimWrite(pos);
+        }
+        while (!slot) {
+            auto key = mNotFull.prepare_wait();
+            if ((slot = claimWrite(pos))) {
+                mNotFull.cancel_wait();
+                break;
+            }
+            mNotFull.wait(key);
+            slot = claimWrite(pos);
+        }
+        publish(*slot, pos, std::forward<Args>(args)...);
+        mNotEmpty.notify(1);
+    }
+
+    /**
+     * @brief Enqueues an element constructed from the arguments
+     *
+     * @return False if the queue is full (the arguments are left untouched)
+     */
+    template <class... Args>
+    bool try_write(Args&&... args) {
+        size_t pos;
+        auto slot = claimWrite(pos);
+        if (!slot) {
+            return false;
+        }
+        publish(*slot, pos, std::forward<Args>(args)...);
+        mNotEmpty.notify(1);
+        return true;
+    }
+
+    /**
+     * @brief Enqueues as many elements of the range as fit into the queue with a single CAS
+     *
+     * The elements are constructed from *first, use std::make_move_iterator to move them into the queue.
+     *
+     * @return Number of elements enqueued from the front of the range
+     */
+    template <typename Iter>
+    size_t write_bulk(Iter first, Iter last) {
+        auto max = static_cast<size_t>(std::distance(first, last));
+        if (max == 0) {
+            return 0;
+        }
+        auto pos = mTail.load(std::memory_order_relaxed);
+        size_t count;
+        while (true) {
+            count = countSlots(pos, 0, max);
+            if (count == 0) {
+                auto seq = getSlot(pos).sequence.load(std::memory_order_acquire);
+                if (static_cast<intptr_t>(seq - pos) < 0) {
+                    return 0;
+                }
+                pos = mTail.load(std::memory_order_relaxed);
+                continue;
+            }
+            if (mTail.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        for (size_t i = 0; i < count; ++i, ++first) {
+            publish(getSlot(pos + i), pos + i, *first);
+        }
+        mNotEmpty.notify(static_cast<int>(count));
+        return count;
+    }
+
+    /**
+     * @brief Dequeues the oldest element into out
+     *
+     * @return False if the queue is empty
+     */
+    bool read(T& out) {
+        size_t pos;
+        auto slot = claimRead(pos);
+        if (!slot) {
+            return false;
+        }
+        consume(*slot, pos, out);
+        mNotFull.notify(1);
+        return true;
+    }
+
+    /**
+     * @brief Dequeues the oldest element into out, blocks while the queue is empty
+     */
+    void read_wait(T& out) {
+        size_t pos;
+        auto slot = claimRead(pos);
+        for (size_t i = 0; !slot && i < SpinCount; ++i) {
+            std::this_thread::yield();
+            slot = claimRead(pos);
+        }
+        while (!slot) {
+            auto key = mNotEmpty.prepare_wait();
+            if ((slot = claimRead(pos))) {
+                mNotEmpty.cancel_wait();
+                break;
+            }
+            mNotEmpty.wait(key);
+            slot = claimRead(pos);
+        }
+        consume(*slot, pos, out);
+        mNotFull.notify(1);
+    }
+
+    /**
+     * @brief Dequeues up to std::distance(out, end) elements with a single CAS
+     *
+     * @return Number of elements written to the front of the output range
+     */
+    template <typename Iter>
+    size_t read_bulk(Iter out, Iter end) {
+        auto max = static_cast<size_t>(std::distance(out, end));
+        if (max == 0) {
+            return 0;
+        }
+        auto pos = mHead.load(std::memory_order_relaxed);
+        size_t count;
+        while (true) {
+            count = countSlots(pos, 1, max);
+            if (count == 0) {
+                auto seq = getSlot(pos).sequence.load(std::memory_order_acquire);
+                if (static_cast<intptr_t>(seq - (pos + 1)) < 0) {
+                    return 0;
+                }
+                pos = mHead.load(std::memory_order_relaxed);
+                continue;
+            }
+            if (mHead.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        for (size_t i = 0; i < count; ++i, ++out) {
+            consume(getSlot(pos + i), pos + i, *out);
+        }
+        mNotFull.notify(static_cast<int>(count));
+        return count;
+    }
+
+    /**
+     * @brief Approximate number of elements in the queue
+     */
+    size_t size() const {
+        auto head = mHead.load(std::memory_order_relaxed);
+        auto tail = mTail.load(std::memory_order_relaxed);
+        return (tail > head ? tail - head : 0);
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    static constexpr size_t capacity() {
+        return QueueSize;
+    }
+
+private:
+    Slot& getSlot(size_t pos) {
+        return mSlots[pos & (QueueSize - 1)];
+    }
+
+    /**
+     * @brief Number of consecutive slots starting at pos (at most max) whose sequence is their position plus offset
+     *
+     * With offset 0 these are free slots a producer can fill, with offset 1 filled slots a consumer can empty.
+     */
+    size_t countSlots(size_t pos, size_t offset, size_t max) {
+        size_t count = 0;
+        while (count < max && count < QueueSize
+                && getSlot(pos + count).sequence.load(std::memory_order_acquire) == pos + count + offset) {
+            ++count;
+        }
+        return count;
+    }
+
+    Slot* claimWrite(size_t& pos) {
+        pos = mTail.load(std::memory_order_relaxed);
+        while (true) {
+            auto& slot = getSlot(pos);
+            auto diff = static_cast<intptr_t>(slot.sequence.load(std::memory_order_acquire) - pos);
+            if (diff == 0) {
+                if (mTail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    return &slot;
+                }
+            } else if (diff < 0) {
+                return nullptr;
+            } else {
+                pos = mTail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    Slot* claimRead(size_t& pos) {
+        pos = mHead.load(std::memory_order_relaxed);
+        while (true) {
+            auto& slot = getSlot(pos);
+            auto diff = static_cast<intptr_t>(slot.sequence.load(std::memory_order_acquire) - (pos + 1));
+            if (diff == 0) {
+                if (mHead.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    return &slot;
+                }
+            } else if (diff < 0) {
+                return nullptr;
+            } else {
+                pos = mHead.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    template <class... Args>
+    void publish(Slot& slot, size_t pos, Args&&... args) {
+        new (slot.value()) T(std::forward<Args>(args)...);
+        slot.sequence.store(pos + 1, std::memory_order_release);
+    }
+
+    void consume(Slot& slot, size_t pos, T& out) {
+        out = std::move(*slot.value());
+        slot.value()->~T();
+        slot.sequence.store(pos + QueueSize, std::memory_order_release);
+    }
+
+    std::array<Slot, QueueSize> mSlots;
+
+    alignas(cache_line_size) std::atomic_size_t mHead;
+    alignas(cache_line_size) std::atomic_size_t mTail;
+
+    /// Producers waiting for a free slot
+    alignas(cache_line_size) event_count mNotFull;
+
+    /// Consumers waiting for an element
+    alignas(cache_line_size) event_count mNotEmpty;
+};
+
+} // namespace crossbow
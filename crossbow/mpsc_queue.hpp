@@ -0,0 +1,290 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#pragma once
+
+#include <crossbow/alignment.hpp>
+#include <crossbow/mpmc_queue.hpp>
+#include <crossbow/non_copyable.hpp>
+
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace crossbow {
+
+/**
+ * @brief Unbounded lock-free queue supporting multiple producers and a single consumer
+ *
+ * Elements are stored in a linked list of segments holding SegmentSize elements each. Producers claim a cell with a
+ * single fetch_add on the tail, which packs the pointer to the tail segment and the index of the next free cell into
+ * one word (user space pointers only use the lower 48 bits). Producers that find the tail segment full append a new
+ * segment, so enqueueing never blocks.
+ *
+ * Segments are recycled through a small pool once the consumer has read all elements and no producer can access them
+ * anymore. The latter is tracked with a split reference count: every producer that obtained a full segment from the
+ * tail holds a reference that is handed over to the segment when the tail moves on.
+ *
+ * The tail is cache line aligned, heap allocated instances therefore have to be created with
+ * crossbow::aligned_new (operator new ignores extended alignment before C++17).
+ */
+template <typename T, size_t SegmentSize = 256>
+class mpsc_queue : crossbow::non_copyable, crossbow::non_movable {
+    static_assert(SegmentSize > 0 && SegmentSize < (1u << 15), "Segment size must fit into the tail index");
+
+    static constexpr unsigned IndexShift = 48;
+    static constexpr uint64_t PointerMask = (1ull << IndexShift) - 1;
+    static constexpr uint64_t IndexIncrement = 1ull << IndexShift;
+
+    /// Reference held by the tail respectively the consumer
+    static constexpr int64_t OwnerRef = 1ll << 32;
+
+    /// Maximum number of free segments kept for reuse
+    static constexpr size_t PoolSize = 16;
+
+    struct Cell {
+        Cell()
+            : ready(false) {
+        }
+
+        T* value() {
+            return reinterpret_cast<T*>(&storage);
+        }
+
+        std::atomic<bool> ready;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+    };
+
+    struct Segment {
+        Segment()
+            : next(nullptr),
+              refs(2 * OwnerRef) {
+        }
+
+        std::array<Cell, SegmentSize> cells;
+        std::atomic<Segment*> next;
+
+        // Owner references of tail and consumer plus the references of producers that found the segment full
+        std::atomic<int64_t> refs;
+    };
+
+public:
+    mpsc_queue()
+        : mHead(new Segment()),
+          mHeadIndex(0),
+          mTail(pack(mHead)) {
+    }
+
+    ~mpsc_queue() {
+        auto segment = mHead;
+        auto index = mHeadIndex;
+        while (segment) {
+            for (; index < SegmentSize; ++index) {
+                auto& cell = segment->cells[index];
+                if (cell.ready.load(std::memory_order_relaxed)) {
+                    cell.value()->~T();
+                }
+            }
+            auto next = segment->next.load(std::memory_order_relaxed);
+            delete segment;
+            segment = next;
+            index = 0;
+        }
+        Segment* pooled;
+        while (mPool.read(pooled)) {
+            delete pooled;
+        }
+    }
+
+    /**
+     * @brief Constructs a new element in place at the end of the queue
+     *
+     * Can be called concurrently from any number of threads, never blocks.
+     */
+    template <class... Args>
+    void emplace(Args&&... args) {
+        while (true) {
+            auto tail = mTail.fetch_add(IndexIncrement, std::memory_order_acq_rel);
+            auto segment = segmentOf(tail);
+            auto index = indexOf(tail);
+            if (index < SegmentSize) {
+                auto& cell = segment->cells[index];
+                new (cell.value()) T(std::forward<Args>(args)...);
+                cell.ready.store(true, std::memory_order_release);
+                return;
+            }
+            advance(segment);
+        }
+    }
+
+    /**
+     * @brief Dequeues the oldest element into out
+     *
+     * Must only be called from the consumer thread.
+     *
+     * @return False if the queue is empty
+     */
+    bool read(T& out) {
+        auto cell = headCell();
+        if (!cell) {
+            return false;
+        }
+        consume(*cell, out);
+        return true;
+    }
+
+    /**
+     * @brief Dequeues up to std::distance(out, end) elements into the output range
+     *
+     * Must only be called from the consumer thread.
+     *
+     * @return Number of elements written to the front of the output range
+     */
+    template <typename Iter>
+    size_t read_bulk(Iter out, Iter end) {
+        size_t count = 0;
+        for (; out != end; ++out, ++count) {
+            auto cell = headCell();
+            if (!cell) {
+                break;
+            }
+            consume(*cell, *out);
+        }
+        return count;
+    }
+
+    /**
+     * @brief Whether the queue is empty, must only be called from the consumer thread
+     */
+    bool empty() {
+        return headCell() == nullptr;
+    }
+
+private:
+    static uint64_t pack(Segment* segment) {
+        assert((reinterpret_cast<uint64_t>(segment) & ~PointerMask) == 0);
+        return reinterpret_cast<uint64_t>(segment);
+    }
+
+    static Segment* segmentOf(uint64_t tail) {
+        return reinterpret_cast<Segment*>(tail & PointerMask);
+    }
+
+    static size_t indexOf(uint64_t tail) {
+        return tail >> IndexShift;
+    }
+
+    /**
+     * @brief Moves the tail from the full segment to its successor and releases the reference of the caller
+     */
+    void advance(Segment* segment) {
+        auto next = segment->next.load(std::memory_order_acquire);
+        if (!next) {
+            auto fresh = allocateSegment();
+            if (segment->next.compare_exchange_strong(next, fresh, std::memory_order_acq_rel)) {
+                next = fresh;
+            } else {
+                recycle(fresh);
+            }
+        }
+
+        // The segment can not be recycled before the tail moved on, so the tail pointing to it can not be an ABA
+        auto tail = mTail.load(std::memory_order_relaxed);
+        while (segmentOf(tail) == segment) {
+            if (mTail.compare_exchange_weak(tail, pack(next), std::memory_order_acq_rel)) {
+                // Hand over the references of all producers that found the segment full
+                release(segment, static_cast<int64_t>(indexOf(tail) - SegmentSize) - OwnerRef);
+                break;
+            }
+        }
+        release(segment, -1);
+    }
+
+    /**
+     * @brief The cell holding the oldest element or nullptr if the queue is empty
+     */
+    Cell* headCell() {
+        if (mHeadIndex == SegmentSize) {
+            auto next = mHead->next.load(std::memory_order_acquire);
+            if (!next) {
+                return nullptr;
+            }
+            auto old = mHead;
+            mHead = next;
+            mHeadIndex = 0;
+            release(old, -OwnerRef);
+        }
+        auto& cell = mHead->cells[mHeadIndex];
+        if (!cell.ready.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return &cell;
+    }
+
+    template <typename U>
+    void consume(Cell& cell, U& out) {
+        out = std::move(*cell.value());
+        cell.value()->~T();
+        cell.ready.store(false, std::memory_order_relaxed);
+        ++mHeadIndex;
+    }
+
+    void release(Segment* segment, int64_t refs) {
+        if (segment->refs.fetch_add(refs, std::memory_order_acq_rel) + refs == 0) {
+            recycle(segment);
+        }
+    }
+
+    Segment* allocateSegment() {
+        Segment* segment;
+        if (mPool.read(segment)) {
+            return segment;
+        }
+        return new Segment();
+    }
+
+    void recycle(Segment* segment) {
+        segment->next.store(nullptr, std::memory_order_relaxed);
+        segment->refs.store(2 * OwnerRef, std::memory_order_relaxed);
+        if (!mPool.try_write(segment)) {
+            delete segment;
+        }
+    }
+
+    /// Segment and index of the next element to read, only accessed by the consumer
+    Segment* mHead;
+    size_t mHeadIndex;
+
+    /// Pointer to the tail segment (lower 48 bits) and index of the next free cell in it (upper 16 bits)
+    alignas(cache_line_size) std::atomic<uint64_t> mTail;
+
+    /// Free segments ready for reuse
+    mpmc_queue<Segment*, PoolSize> mPool;
+};
+
+} // namespace crossbow
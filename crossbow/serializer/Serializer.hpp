@@ -321,6 +321,60 @@ struct size_policy<Archiver, std::tuple<T...> >
     }
 };
 
+/**
+ * @brief Whether the serialize policy of T writes exactly the bytes reported by its size policy directly at pos
+ *
+ * Single pass archives reserve that many bytes before invoking the policy of a flat type. All other types must only
+ * write through nested ar & calls. Specialize this when adding a policy that writes raw bytes for a non POD type.
+ */
+template<typename T>
+struct is_flat_serializable
+        : std::integral_constant<bool, std::is_pod<T>::value && !implements_serializable<T>()> {};
+
+/**
+ * @brief Whether the serialized form of T is a plain copy of its object representation
+ *
+ * Contiguous ranges of such types are serialized and deserialized with a single memcpy. Bools are excluded as their
+ * deserialize policy normalizes the stored byte.
+ */
+template<typename T>
+struct is_bitwise_serializable
+        : std::integral_constant<bool, std::is_pod<T>::value
+                && is_flat_serializable<T>::value
+                && !has_visit<T>::value
+                && !std::is_same<T, bool>::value> {};
+
+/**
+ * @brief Serialized size of T if it is known at compile time, 0 otherwise
+ *
+ * Known for PODs handled by the default policies and for pairs and tuples composed of them.
+ */
+template<typename T, typename = void>
+struct static_serialized_size : std::integral_constant<std::size_t, 0> {};
+
+template<typename T>
+struct static_serialized_size<T, typename std::enable_if<std::is_pod<T>::value
+        && is_flat_serializable<T>::value
+        && !has_visit<T>::value>::type>
+        : std::integral_constant<std::size_t, sizeof(T)> {};
+
+template<typename U, typename V>
+struct static_serialized_size<std::pair<U, V>>
+        : std::integral_constant<std::size_t,
+                (static_serialized_size<U>::value == 0 || static_serialized_size<V>::value == 0)
+                        ? 0
+                        : static_serialized_size<U>::value + static_serialized_size<V>::value> {};
+
+template<>
+struct static_serialized_size<std::tuple<>> : std::integral_constant<std::size_t, 0> {};
+
+template<typename Head>
+struct static_serialized_size<std::tuple<Head>> : static_serialized_size<Head> {};
+
+template<typename Head, typename Next, typename... Tail>
+struct static_serialized_size<std::tuple<Head, Next, Tail...>>
+        : static_serialized_size<std::pair<Head, std::tuple<Next, Tail...>>> {};
+
 struct sizer {
     std::size_t size;
     sizer() : size(0) {}
@@ -420,17 +474,22 @@ const uint8_t* deserialize(T& out, const uint8_t* buffer)
 
 template<typename T>
 std::size_t serialize(std::unique_ptr<uint8_t[]>& res, const T& obj) {
-    sizer s;
-    s & obj;
-    serializer ser(s.size);
+    // Types with a size known at compile time do not need the sizing pass
+    std::size_t size = static_serialized_size<T>::value;
+    if (size == 0) {
+        sizer s;
+        s & obj;
+        size = s.size;
+    }
+    serializer ser(size);
     ser & obj;
     res = std::move(ser.buffer);
-    assert(ser.pos == res.get() + s.size);
+    assert(ser.pos == res.get() + size);
 //#ifndef NDEBUG
 //    T* t;
 //    assert(deserialize(t, res.get()) == res.get() + s.size);
 //#endif
-    return s.size;
+    return size;
 }
 
 } // namespace crossbow
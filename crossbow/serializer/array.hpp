@@ -0,0 +1,100 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#pragma once
+#include "Serializer.hpp"
+#include <array>
+
+namespace crossbow {
+
+template<typename Archiver, typename T, std::size_t N>
+struct serialize_policy<Archiver, std::array<T, N>>
+{
+    template<class I = T>
+    typename std::enable_if<is_bitwise_serializable<I>::value, uint8_t*>::type
+    operator() (Archiver& ar, const std::array<T, N>& v, uint8_t* pos) const {
+        memcpy(pos, v.data(), N * sizeof(T));
+        return pos + N * sizeof(T);
+    }
+
+    template<class I = T>
+    typename std::enable_if<!is_bitwise_serializable<I>::value, uint8_t*>::type
+    operator() (Archiver& ar, const std::array<T, N>& v, uint8_t* pos) const {
+        for (auto& e : v) {
+            ar & e;
+        }
+        return ar.pos;
+    }
+};
+
+template<typename Archiver, typename T, std::size_t N>
+struct deserialize_policy<Archiver, std::array<T, N>>
+{
+    template<class I = T>
+    typename std::enable_if<is_bitwise_serializable<I>::value, const uint8_t*>::type
+    operator() (Archiver& ar, std::array<T, N>& out, const uint8_t* ptr) const
+    {
+        memcpy(out.data(), ptr, N * sizeof(T));
+        return ptr + N * sizeof(T);
+    }
+
+    template<class I = T>
+    typename std::enable_if<!is_bitwise_serializable<I>::value, const uint8_t*>::type
+    operator() (Archiver& ar, std::array<T, N>& out, const uint8_t* ptr) const
+    {
+        for (auto& e : out) {
+            ar & e;
+        }
+        return ar.pos;
+    }
+};
+
+template<typename Archiver, typename T, std::size_t N>
+struct size_policy<Archiver, std::array<T, N>>
+{
+    template<class I = T>
+    typename std::enable_if<is_bitwise_serializable<I>::value, std::size_t>::type
+    operator() (Archiver& ar, const std::array<T, N>& obj) const
+    {
+        return N * sizeof(T);
+    }
+
+    template<class I = T>
+    typename std::enable_if<!is_bitwise_serializable<I>::value, std::size_t>::type
+    operator() (Archiver& ar, const std::array<T, N>& obj) const
+    {
+        for (auto& e : obj) {
+            ar & e;
+        }
+        return 0;
+    }
+};
+
+template<typename T, std::size_t N>
+struct is_flat_serializable<std::array<T, N>> : is_bitwise_serializable<T> {};
+
+template<typename T, std::size_t N>
+struct static_serialized_size<std::array<T, N>, typename std::enable_if<
+        !(std::is_pod<std::array<T, N>>::value && is_bitwise_serializable<T>::value)>::type>
+        : std::integral_constant<std::size_t, N * static_serialized_size<T>::value> {};
+
+} // namespace crossbow
@@ -0,0 +1,283 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#pragma once
+#include "Serializer.hpp"
+#include "serialized_view.hpp"
+
+#include <crossbow/byte_buffer.hpp>
+#include <crossbow/string.hpp>
+
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace crossbow {
+
+/**
+ * @brief Deserializer validating the input against the end of the buffer
+ *
+ * Every read and every length prefix is checked against the remaining bytes before the data is touched. Instead of
+ * throwing, the deserializer enters a failed state on the first violation: it stops reading, all further operations
+ * are no-ops and failed() returns true. Objects deserialized up to this point are left in a valid but unspecified
+ * state.
+ *
+ * The checks cover PODs, strings, vectors, maps and the serialized views, all other types are deserialized through
+ * their policies and must only read through nested ar & calls.
+ */
+class checked_deserializer {
+public:
+    const uint8_t* pos;
+
+    checked_deserializer(const uint8_t* buffer, std::size_t length)
+            : pos(buffer),
+              mEnd(buffer + length),
+              mFailed(false) {
+    }
+
+    template<typename T>
+    checked_deserializer& operator& (T& obj) {
+        using kind = std::integral_constant<int, has_visit<T>::value ? 0
+                : (static_serialized_size<T>::value != 0 ? 1 : 2)>;
+        read(obj, kind());
+        return *this;
+    }
+
+    template<class Char, class Traits, class Allocator>
+    checked_deserializer& operator& (std::basic_string<Char, Traits, Allocator>& str) {
+        readString(str);
+        return *this;
+    }
+
+    template<class Char, class Traits, class Allocator>
+    checked_deserializer& operator& (crossbow::basic_string<Char, Traits, Allocator>& str) {
+        readString(str);
+        return *this;
+    }
+
+    checked_deserializer& operator& (serialized_string_view& str) {
+        std::uint32_t count;
+        if (readLength(count, 1)) {
+            str = serialized_string_view(reinterpret_cast<const char*>(pos), count);
+            pos += count;
+        }
+        return *this;
+    }
+
+    template<typename T>
+    checked_deserializer& operator& (serialized_span<T>& span) {
+        std::size_t count;
+        if (readLength(count, sizeof(T))) {
+            span = serialized_span<T>(pos, count);
+            pos += count * sizeof(T);
+        }
+        return *this;
+    }
+
+    template<typename T, typename Allocator>
+    checked_deserializer& operator& (std::vector<T, Allocator>& v) {
+        readVector(v, std::integral_constant<bool, is_bitwise_serializable<T>::value>());
+        return *this;
+    }
+
+    template<class Key, class Value, class Predicate, class Allocator>
+    checked_deserializer& operator& (std::map<Key, Value, Predicate, Allocator>& map) {
+        readMap(map);
+        return *this;
+    }
+
+    template<class Key, class Value, class Predicate, class Allocator>
+    checked_deserializer& operator& (std::multimap<Key, Value, Predicate, Allocator>& map) {
+        readMap(map);
+        return *this;
+    }
+
+    template<class Key, class Value, class Hash, class Predicate, class Allocator>
+    checked_deserializer& operator& (std::unordered_map<Key, Value, Hash, Predicate, Allocator>& map) {
+        readMap(map);
+        return *this;
+    }
+
+    bool failed() const {
+        return mFailed;
+    }
+
+    const uint8_t* end() const {
+        return mEnd;
+    }
+
+private:
+    /**
+     * @brief Smallest number of bytes an element of type T occupies in the serialized form
+     */
+    template<typename T>
+    static constexpr std::size_t min_size() {
+        return static_serialized_size<T>::value == 0 ? 1 : static_serialized_size<T>::value;
+    }
+
+    bool check(std::size_t length) {
+        if (static_cast<std::size_t>(mEnd - pos) >= length) {
+            return true;
+        }
+        fail();
+        return false;
+    }
+
+    /**
+     * @brief Moves pos to the end so every following read fails its length check
+     */
+    void fail() {
+        mFailed = true;
+        pos = mEnd;
+    }
+
+    /**
+     * @brief Reads a length prefix and checks that count elements of the given size follow it
+     */
+    template<typename Length>
+    bool readLength(Length& count, std::size_t elementSize) {
+        if (!check(sizeof(Length))) {
+            return false;
+        }
+        memcpy(&count, pos, sizeof(Length));
+        pos += sizeof(Length);
+        if (static_cast<std::size_t>(count) > static_cast<std::size_t>(mEnd - pos) / elementSize) {
+            fail();
+            return false;
+        }
+        return true;
+    }
+
+    template<typename T>
+    void read(T& obj, std::integral_constant<int, 0>) {
+        obj.visit(*this);
+    }
+
+    template<typename T>
+    void read(T& obj, std::integral_constant<int, 1>) {
+        if (!check(static_serialized_size<T>::value)) {
+            return;
+        }
+        deserializer des(pos);
+        des & obj;
+        pos = des.pos;
+    }
+
+    template<typename T>
+    void read(T& obj, std::integral_constant<int, 2>) {
+        if (!mFailed) {
+            deserialize_policy<checked_deserializer, T> des;
+            pos = des(*this, obj, pos);
+        }
+    }
+
+    template<typename String>
+    void readString(String& str) {
+        using Char = typename String::value_type;
+        std::uint32_t count;
+        if (readLength(count, sizeof(Char))) {
+            str.assign(reinterpret_cast<const Char*>(pos), count);
+            pos += count * sizeof(Char);
+        }
+    }
+
+    template<typename Vector>
+    void readVector(Vector& v, std::true_type) {
+        using T = typename Vector::value_type;
+        std::size_t count;
+        if (readLength(count, sizeof(T)) && count != 0) {
+            auto offset = v.size();
+            v.resize(offset + count);
+            memcpy(v.data() + offset, pos, count * sizeof(T));
+            pos += count * sizeof(T);
+        }
+    }
+
+    template<typename Vector>
+    void readVector(Vector& v, std::false_type) {
+        using T = typename Vector::value_type;
+        std::size_t count;
+        if (!readLength(count, min_size<T>())) {
+            return;
+        }
+        v.reserve(v.size() + count);
+        for (std::size_t i = 0; i < count && !mFailed; ++i) {
+            T obj;
+            *this & obj;
+            v.emplace_back(std::move(obj));
+        }
+    }
+
+    template<typename Map>
+    void readMap(Map& map) {
+        using Key = typename Map::key_type;
+        using Value = typename Map::mapped_type;
+        std::size_t count;
+        if (!readLength(count, min_size<Key>() + min_size<Value>())) {
+            return;
+        }
+        for (std::size_t i = 0; i < count && !mFailed; ++i) {
+            Key key;
+            Value value;
+            *this & key;
+            *this & value;
+            if (!mFailed) {
+                map.emplace(std::move(key), std::move(value));
+            }
+        }
+    }
+
+    const uint8_t* mEnd;
+    bool mFailed;
+};
+
+/**
+ * @brief Deserializes the object from the first length bytes of the buffer
+ *
+ * @return Pointer behind the consumed bytes or null if the buffer does not contain a valid object
+ */
+template<typename T>
+const uint8_t* checked_deserialize(T& out, const uint8_t* buffer, std::size_t length) {
+    checked_deserializer des(buffer, length);
+    des & out;
+    return des.failed() ? nullptr : des.pos;
+}
+
+/**
+ * @brief Deserializes the object from the reader and advances it past the consumed bytes
+ *
+ * @return False if the reader does not contain a valid object, the reader is not advanced in this case
+ */
+template<typename T>
+bool deserialize(buffer_reader& reader, T& out) {
+    auto buffer = reinterpret_cast<const uint8_t*>(reader.data());
+    checked_deserializer des(buffer, static_cast<std::size_t>(reader.end() - reader.data()));
+    des & out;
+    if (des.failed()) {
+        return false;
+    }
+    reader.advance(static_cast<std::size_t>(des.pos - buffer));
+    return true;
+}
+
+} // namespace crossbow
@@ -0,0 +1,490 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#pragma once
+#include "Serializer.hpp"
+#include "serialized_view.hpp"
+
+#include <crossbow/string.hpp>
+
+#include <string>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace crossbow {
+namespace impl {
+
+/**
+ * @brief Whether T is written as a LEB128 varint by the compact archives
+ *
+ * Covers integers and enums wider than a byte, signed values are zigzag encoded first.
+ */
+template<typename T>
+struct is_varint : std::integral_constant<bool, (std::is_integral<T>::value || std::is_enum<T>::value)
+        && !std::is_same<T, bool>::value
+        && (sizeof(T) > 1)> {};
+
+template<typename T, bool = std::is_enum<T>::value>
+struct varint_value {
+    using type = T;
+};
+
+template<typename T>
+struct varint_value<T, true> {
+    using type = typename std::underlying_type<T>::type;
+};
+
+template<typename T>
+typename std::enable_if<std::is_signed<typename varint_value<T>::type>::value, uint64_t>::type
+to_varint(T value) {
+    auto v = static_cast<int64_t>(value);
+    return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+template<typename T>
+typename std::enable_if<!std::is_signed<typename varint_value<T>::type>::value, uint64_t>::type
+to_varint(T value) {
+    return static_cast<uint64_t>(value);
+}
+
+template<typename T>
+typename std::enable_if<std::is_signed<typename varint_value<T>::type>::value, T>::type
+from_varint(uint64_t v) {
+    return static_cast<T>(static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 0x1u));
+}
+
+template<typename T>
+typename std::enable_if<!std::is_signed<typename varint_value<T>::type>::value, T>::type
+from_varint(uint64_t v) {
+    return static_cast<T>(v);
+}
+
+inline std::size_t varint_size(uint64_t v) {
+    return static_cast<std::size_t>(63 - __builtin_clzll(v | 1)) / 7 + 1;
+}
+
+inline uint8_t* write_varint(uint8_t* pos, uint64_t v) {
+    while (v >= 0x80u) {
+        *pos++ = static_cast<uint8_t>(v) | 0x80u;
+        v >>= 7;
+    }
+    *pos++ = static_cast<uint8_t>(v);
+    return pos;
+}
+
+inline const uint8_t* read_varint(const uint8_t* pos, uint64_t& v) {
+    if (*pos < 0x80u) {
+        v = *pos;
+        return pos + 1;
+    }
+    v = 0;
+    unsigned shift = 0;
+    do {
+        v |= static_cast<uint64_t>(*pos & 0x7fu) << shift;
+        shift += 7;
+    } while (*pos++ >= 0x80u);
+    return pos;
+}
+
+/**
+ * @brief Decodes count varints starting at pos into out
+ *
+ * Uses SSE2 to find the last byte of every value in a window of 64 bytes at once. A window of 64 single byte values
+ * is converted without any branches, otherwise the values ending in the window are decoded one after the other by
+ * gathering the 7 bit groups of an unaligned 8 byte load. The last bytes before end and platforms without SSE2 use the
+ * scalar decoder.
+ */
+template<typename T>
+const uint8_t* read_varints(const uint8_t* pos, const uint8_t* end, T* out, std::size_t count) {
+    std::size_t i = 0;
+#ifdef __SSE2__
+    constexpr std::ptrdiff_t WINDOW = 64;
+    while (count - i >= WINDOW && end - pos >= WINDOW + 8) {
+        uint64_t continuation = 0;
+        for (std::ptrdiff_t j = 0; j < WINDOW; j += 16) {
+            auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos + j));
+            continuation |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(bytes))) << j;
+        }
+        if (continuation == 0) {
+            for (std::ptrdiff_t j = 0; j < WINDOW; ++j) {
+                out[i + j] = from_varint<T>(pos[j]);
+            }
+            pos += WINDOW;
+            i += WINDOW;
+            continue;
+        }
+
+        auto ends = ~continuation;
+        if (ends == 0) {
+            break;
+        }
+        // Value boundaries only depend on the mask, not on the previously decoded value
+        std::size_t start = 0;
+        do {
+            auto stop = static_cast<std::size_t>(__builtin_ctzll(ends)) + 1;
+            auto length = stop - start;
+            uint64_t v;
+            if (length <= sizeof(uint64_t)) {
+                memcpy(&v, pos + start, sizeof(v));
+                v &= (~uint64_t(0) >> (64 - 8 * length)) & 0x7f7f7f7f7f7f7f7full;
+                v = (v & 0x007f007f007f007full) | ((v & 0x7f007f007f007f00ull) >> 1);
+                v = (v & 0x00003fff00003fffull) | ((v & 0x3fff00003fff0000ull) >> 2);
+                v = (v & 0x000000000fffffffull) | ((v & 0x0fffffff00000000ull) >> 4);
+            } else {
+                read_varint(pos + start, v);
+            }
+            out[i++] = from_varint<T>(v);
+            start = stop;
+            ends &= ends - 1;
+        } while (ends != 0);
+        pos += start;
+    }
+#endif
+    for (; i < count; ++i) {
+        uint64_t v;
+        pos = read_varint(pos, v);
+        out[i] = from_varint<T>(v);
+    }
+    return pos;
+}
+
+} // namespace impl
+
+/**
+ * @brief Sizer for the compact format written by the compact_serializer
+ */
+struct compact_sizer {
+    std::size_t size;
+    compact_sizer() : size(0) {}
+
+    template<typename T>
+    compact_sizer& operator& (const T& obj) {
+        using kind = std::integral_constant<int, has_visit<T>::value ? 0 : (impl::is_varint<T>::value ? 1 : 2)>;
+        add(obj, kind());
+        return *this;
+    }
+
+    template<class Char, class Traits, class Allocator>
+    compact_sizer& operator& (const std::basic_string<Char, Traits, Allocator>& str) {
+        size += impl::varint_size(str.size()) + str.size() * sizeof(Char);
+        return *this;
+    }
+
+    template<class Char, class Traits, class Allocator>
+    compact_sizer& operator& (const crossbow::basic_string<Char, Traits, Allocator>& str) {
+        size += impl::varint_size(str.size()) + str.size() * sizeof(Char);
+        return *this;
+    }
+
+    compact_sizer& operator& (const serialized_string_view& str) {
+        size += impl::varint_size(str.size()) + str.size();
+        return *this;
+    }
+
+    template<typename T>
+    compact_sizer& operator& (const serialized_span<T>& span) {
+        static_assert(!impl::is_varint<T>::value, "Integers are varint encoded and can not be viewed in place");
+        size += impl::varint_size(span.size()) + span.size() * sizeof(T);
+        return *this;
+    }
+
+    template<typename T, typename Allocator>
+    compact_sizer& operator& (const std::vector<T, Allocator>& v) {
+        size += impl::varint_size(v.size());
+        addRange(v, std::integral_constant<int, impl::is_varint<T>::value ? 1
+                : (is_bitwise_serializable<T>::value ? 2 : 0)>());
+        return *this;
+    }
+
+private:
+    template<typename T>
+    void add(const T& o, std::integral_constant<int, 0>) {
+        auto& obj = reinterpret_cast<const serializable<T>&>(o);
+        obj.visit(*this);
+    }
+
+    template<typename T>
+    void add(const T& obj, std::integral_constant<int, 1>) {
+        size += impl::varint_size(impl::to_varint(obj));
+    }
+
+    template<typename T>
+    void add(const T& obj, std::integral_constant<int, 2>) {
+        size_policy<compact_sizer, T> p;
+        size += p(*this, obj);
+    }
+
+    template<typename Vector>
+    void addRange(const Vector& v, std::integral_constant<int, 0>) {
+        for (const auto& e : v) {
+            *this & e;
+        }
+    }
+
+    template<typename Vector>
+    void addRange(const Vector& v, std::integral_constant<int, 1>) {
+        for (auto e : v) {
+            size += impl::varint_size(impl::to_varint(e));
+        }
+    }
+
+    template<typename Vector>
+    void addRange(const Vector& v, std::integral_constant<int, 2>) {
+        size += v.size() * sizeof(typename Vector::value_type);
+    }
+};
+
+/**
+ * @brief Serializer writing integers and lengths as LEB128 varints
+ *
+ * Integers and enums wider than a byte are written as varints (signed ones zigzag encoded), this includes the length
+ * prefixes of strings and containers. Other PODs, std::array and vectors of non integer PODs are copied as they are.
+ * The buffer has to be at least as large as computed by the compact_sizer.
+ */
+struct compact_serializer {
+    uint8_t* buffer;
+    uint8_t* pos;
+
+    compact_serializer(uint8_t* b) : buffer(b), pos(b) {}
+
+    template<typename T>
+    compact_serializer& operator& (const T& obj) {
+        using kind = std::integral_constant<int, has_visit<T>::value ? 0 : (impl::is_varint<T>::value ? 1 : 2)>;
+        write(obj, kind());
+        return *this;
+    }
+
+    template<class Char, class Traits, class Allocator>
+    compact_serializer& operator& (const std::basic_string<Char, Traits, Allocator>& str) {
+        writeBytes(str.data(), str.size(), sizeof(Char));
+        return *this;
+    }
+
+    template<class Char, class Traits, class Allocator>
+    compact_serializer& operator& (const crossbow::basic_string<Char, Traits, Allocator>& str) {
+        writeBytes(str.data(), str.size(), sizeof(Char));
+        return *this;
+    }
+
+    compact_serializer& operator& (const serialized_string_view& str) {
+        writeBytes(str.data(), str.size(), 1);
+        return *this;
+    }
+
+    template<typename T>
+    compact_serializer& operator& (const serialized_span<T>& span) {
+        static_assert(!impl::is_varint<T>::value, "Integers are varint encoded and can not be viewed in place");
+        writeBytes(span.data(), span.size(), sizeof(T));
+        return *this;
+    }
+
+    template<typename T, typename Allocator>
+    compact_serializer& operator& (const std::vector<T, Allocator>& v) {
+        pos = impl::write_varint(pos, v.size());
+        writeRange(v, std::integral_constant<int, impl::is_varint<T>::value ? 1
+                : (is_bitwise_serializable<T>::value ? 2 : 0)>());
+        return *this;
+    }
+
+private:
+    void writeBytes(const void* data, std::size_t count, std::size_t elementSize) {
+        pos = impl::write_varint(pos, count);
+        if (count != 0) {
+            memcpy(pos, data, count * elementSize);
+            pos += count * elementSize;
+        }
+    }
+
+    template<typename T>
+    void write(const T& o, std::integral_constant<int, 0>) {
+        auto& obj = reinterpret_cast<const serializable<T>&>(o);
+        obj.visit(*this);
+    }
+
+    template<typename T>
+    void write(const T& obj, std::integral_constant<int, 1>) {
+        pos = impl::write_varint(pos, impl::to_varint(obj));
+    }
+
+    template<typename T>
+    void write(const T& obj, std::integral_constant<int, 2>) {
+        serialize_policy<compact_serializer, T> ser;
+        pos = ser(*this, obj, pos);
+    }
+
+    template<typename Vector>
+    void writeRange(const Vector& v, std::integral_constant<int, 0>) {
+        for (const auto& e : v) {
+            *this & e;
+        }
+    }
+
+    template<typename Vector>
+    void writeRange(const Vector& v, std::integral_constant<int, 1>) {
+        for (auto e : v) {
+            pos = impl::write_varint(pos, impl::to_varint(e));
+        }
+    }
+
+    template<typename Vector>
+    void writeRange(const Vector& v, std::integral_constant<int, 2>) {
+        if (!v.empty()) {
+            memcpy(pos, v.data(), v.size() * sizeof(typename Vector::value_type));
+            pos += v.size() * sizeof(typename Vector::value_type);
+        }
+    }
+};
+
+/**
+ * @brief Deserializer for the compact format written by the compact_serializer
+ *
+ * Needs the end of the buffer to decode vectors of integers in batches, it does not check the input against it.
+ */
+struct compact_deserializer {
+    const uint8_t* pos;
+    const uint8_t* end;
+
+    compact_deserializer(const uint8_t* buffer, std::size_t length) : pos(buffer), end(buffer + length) {}
+
+    template<typename T>
+    compact_deserializer& operator& (T& obj) {
+        using kind = std::integral_constant<int, has_visit<T>::value ? 0 : (impl::is_varint<T>::value ? 1 : 2)>;
+        read(obj, kind());
+        return *this;
+    }
+
+    template<class Char, class Traits, class Allocator>
+    compact_deserializer& operator& (std::basic_string<Char, Traits, Allocator>& str) {
+        auto count = readLength();
+        str.assign(reinterpret_cast<const Char*>(pos), count);
+        pos += count * sizeof(Char);
+        return *this;
+    }
+
+    template<class Char, class Traits, class Allocator>
+    compact_deserializer& operator& (crossbow::basic_string<Char, Traits, Allocator>& str) {
+        auto count = readLength();
+        str.assign(reinterpret_cast<const Char*>(pos), count);
+        pos += count * sizeof(Char);
+        return *this;
+    }
+
+    compact_deserializer& operator& (serialized_string_view& str) {
+        auto count = readLength();
+        str = serialized_string_view(reinterpret_cast<const char*>(pos), count);
+        pos += count;
+        return *this;
+    }
+
+    template<typename T>
+    compact_deserializer& operator& (serialized_span<T>& span) {
+        static_assert(!impl::is_varint<T>::value, "Integers are varint encoded and can not be viewed in place");
+        auto count = readLength();
+        span = serialized_span<T>(pos, count);
+        pos += count * sizeof(T);
+        return *this;
+    }
+
+    template<typename T, typename Allocator>
+    compact_deserializer& operator& (std::vector<T, Allocator>& v) {
+        readRange(v, readLength(), std::integral_constant<int, impl::is_varint<T>::value ? 1
+                : (is_bitwise_serializable<T>::value ? 2 : 0)>());
+        return *this;
+    }
+
+private:
+    std::size_t readLength() {
+        uint64_t count;
+        pos = impl::read_varint(pos, count);
+        return static_cast<std::size_t>(count);
+    }
+
+    template<typename T>
+    void read(T& obj, std::integral_constant<int, 0>) {
+        obj.visit(*this);
+    }
+
+    template<typename T>
+    void read(T& obj, std::integral_constant<int, 1>) {
+        uint64_t v;
+        pos = impl::read_varint(pos, v);
+        obj = impl::from_varint<T>(v);
+    }
+
+    template<typename T>
+    void read(T& obj, std::integral_constant<int, 2>) {
+        deserialize_policy<compact_deserializer, T> des;
+        pos = des(*this, obj, pos);
+    }
+
+    template<typename Vector>
+    void readRange(Vector& v, std::size_t count, std::integral_constant<int, 0>) {
+        v.reserve(v.size() + count);
+        for (std::size_t i = 0; i < count; ++i) {
+            typename Vector::value_type obj;
+            *this & obj;
+            v.emplace_back(std::move(obj));
+        }
+    }
+
+    template<typename Vector>
+    void readRange(Vector& v, std::size_t count, std::integral_constant<int, 1>) {
+        if (count != 0) {
+            auto offset = v.size();
+            v.resize(offset + count);
+            pos = impl::read_varints(pos, end, v.data() + offset, count);
+        }
+    }
+
+    template<typename Vector>
+    void readRange(Vector& v, std::size_t count, std::integral_constant<int, 2>) {
+        if (count != 0) {
+            auto offset = v.size();
+            v.resize(offset + count);
+            memcpy(v.data() + offset, pos, count * sizeof(typename Vector::value_type));
+            pos += count * sizeof(typename Vector::value_type);
+        }
+    }
+};
+
+template<typename T>
+std::size_t compact_serialize(std::unique_ptr<uint8_t[]>& res, const T& obj) {
+    compact_sizer s;
+    s & obj;
+    res.reset(new uint8_t[s.size]);
+    compact_serializer ser(res.get());
+    ser & obj;
+    assert(ser.pos == res.get() + s.size);
+    return s.size;
+}
+
+template<typename T>
+const uint8_t* compact_deserialize(T& out, const uint8_t* buffer, std::size_t length) {
+    compact_deserializer des(buffer, length);
+    des & out;
+    return des.pos;
+}
+
+} // namespace crossbow
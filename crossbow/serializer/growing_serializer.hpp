@@ -0,0 +1,230 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#pragma once
+#include "Serializer.hpp"
+
+#include <crossbow/byte_buffer.hpp>
+
+#include <algorithm>
+
+namespace crossbow {
+namespace impl {
+
+/**
+ * @brief Common dispatch for archives serializing in a single pass without a preceding sizer pass
+ *
+ * Before every raw write the archive asks the derived class to reserve the required space through
+ * reserve(length). Types with a compile time size reserve once for the whole value, flat types reserve what their
+ * size policy reports and all other types are serialized element by element through nested ar & calls.
+ */
+template<typename Archiver>
+class single_pass_archive {
+public:
+    uint8_t* pos;
+
+    template<typename T>
+    Archiver& operator& (const T& obj) {
+        using kind = std::integral_constant<int, has_visit<T>::value ? 0
+                : (static_serialized_size<T>::value != 0 ? 1
+                : (is_flat_serializable<T>::value ? 2 : 3))>;
+        write(obj, kind());
+        return self();
+    }
+
+protected:
+    single_pass_archive(uint8_t* p) : pos(p) {}
+
+private:
+    Archiver& self() {
+        return static_cast<Archiver&>(*this);
+    }
+
+    template<typename T>
+    void write(const T& o, std::integral_constant<int, 0>) {
+        auto& obj = reinterpret_cast<const serializable<T>&>(o);
+        obj.visit(self());
+    }
+
+    template<typename T>
+    void write(const T& obj, std::integral_constant<int, 1>) {
+        if (!self().reserve(static_serialized_size<T>::value)) {
+            return;
+        }
+        serializer_into_array ser(pos);
+        ser & obj;
+        pos = ser.pos;
+    }
+
+    template<typename T>
+    void write(const T& obj, std::integral_constant<int, 2>) {
+        sizer s;
+        size_policy<sizer, T> size;
+        if (!self().reserve(size(s, obj))) {
+            return;
+        }
+        serialize_policy<Archiver, T> ser;
+        pos = ser(self(), obj, pos);
+    }
+
+    template<typename T>
+    void write(const T& obj, std::integral_constant<int, 3>) {
+        serialize_policy<Archiver, T> ser;
+        pos = ser(self(), obj, pos);
+    }
+};
+
+} // namespace impl
+
+/**
+ * @brief Serializer writing into a buffer that grows on demand
+ *
+ * In contrast to the serializer this does not require the size of the object to be known in advance, the object is
+ * traversed only once. The buffer is doubled whenever the remaining space is not large enough. Buffers can be handed
+ * in and taken out again so they can be reused across messages.
+ */
+class growing_serializer : public impl::single_pass_archive<growing_serializer> {
+public:
+    static constexpr std::size_t DEFAULT_CAPACITY = 256;
+
+    explicit growing_serializer(std::size_t capacity = DEFAULT_CAPACITY)
+            : growing_serializer(std::unique_ptr<uint8_t[]>(new uint8_t[capacity]), capacity) {
+    }
+
+    growing_serializer(std::unique_ptr<uint8_t[]> buffer, std::size_t capacity)
+            : single_pass_archive(buffer.get()),
+              mBuffer(std::move(buffer)),
+              mEnd(mBuffer.get() + capacity) {
+    }
+
+    /**
+     * @brief Makes sure at least length bytes can be written at pos
+     */
+    bool reserve(std::size_t length) {
+        if (static_cast<std::size_t>(mEnd - pos) < length) {
+            grow(length);
+        }
+        return true;
+    }
+
+    uint8_t* data() {
+        return mBuffer.get();
+    }
+
+    const uint8_t* data() const {
+        return mBuffer.get();
+    }
+
+    /**
+     * @brief Number of bytes written so far
+     */
+    std::size_t size() const {
+        return static_cast<std::size_t>(pos - mBuffer.get());
+    }
+
+    std::size_t capacity() const {
+        return static_cast<std::size_t>(mEnd - mBuffer.get());
+    }
+
+    /**
+     * @brief Discards the written bytes but keeps the buffer
+     */
+    void clear() {
+        pos = mBuffer.get();
+    }
+
+    /**
+     * @brief Takes the buffer out of the serializer
+     *
+     * The serializer is empty afterwards and allocates a new buffer on the next write.
+     */
+    std::unique_ptr<uint8_t[]> release() {
+        pos = nullptr;
+        mEnd = nullptr;
+        return std::move(mBuffer);
+    }
+
+private:
+    void grow(std::size_t length) {
+        auto used = size();
+        auto capacity = std::max(std::max(2 * this->capacity(), used + length), std::size_t(DEFAULT_CAPACITY));
+        std::unique_ptr<uint8_t[]> buffer(new uint8_t[capacity]);
+        if (used != 0) {
+            memcpy(buffer.get(), mBuffer.get(), used);
+        }
+        mBuffer = std::move(buffer);
+        pos = mBuffer.get() + used;
+        mEnd = mBuffer.get() + capacity;
+    }
+
+    std::unique_ptr<uint8_t[]> mBuffer;
+    uint8_t* mEnd;
+};
+
+/**
+ * @brief Serializer writing into the remaining space of a buffer_writer
+ *
+ * Serialization stops writing as soon as the object does not fit into the buffer anymore, failed() reports whether
+ * this happened.
+ */
+class writer_serializer : public impl::single_pass_archive<writer_serializer> {
+public:
+    explicit writer_serializer(buffer_writer& writer)
+            : single_pass_archive(reinterpret_cast<uint8_t*>(writer.data())),
+              mEnd(reinterpret_cast<const uint8_t*>(writer.end())),
+              mFailed(false) {
+    }
+
+    bool reserve(std::size_t length) {
+        if (mFailed || static_cast<std::size_t>(mEnd - pos) < length) {
+            mFailed = true;
+            return false;
+        }
+        return true;
+    }
+
+    bool failed() const {
+        return mFailed;
+    }
+
+private:
+    const uint8_t* mEnd;
+    bool mFailed;
+};
+
+/**
+ * @brief Serializes the object directly into the writer and advances it past the written bytes
+ *
+ * @return False if the object did not fit into the writer, the writer is not advanced in this case
+ */
+template<typename T>
+bool serialize(buffer_writer& writer, const T& obj) {
+    writer_serializer ser(writer);
+    ser & obj;
+    if (ser.failed()) {
+        return false;
+    }
+    writer.advance(static_cast<std::size_t>(ser.pos - reinterpret_cast<uint8_t*>(writer.data())));
+    return true;
+}
+
+} // namespace crossbow
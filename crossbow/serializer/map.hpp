@@ -64,7 +64,7 @@ struct size_policy<Archiver, std::map<Key, Value, Predicate, Allocator>>
 {
     using type = std::map<Key, Value, Predicate, Allocator>;
     std::size_t operator() (Archiver& ar, const type& map) const {
-        std::size_t s;
+        std::size_t s = map.size();
         ar & s;
         for (auto& e : map) {
             ar & e.first;
@@ -112,7 +112,7 @@ struct size_policy<Archiver, std::multimap<Key, Value, Predicate, Allocator>>
 {
     using type = std::multimap<Key, Value, Predicate, Allocator>;
     std::size_t operator() (Archiver& ar, const type& multimap) const {
-        std::size_t s;
+        std::size_t s = multimap.size();
         ar & s;
         for (auto& e : multimap) {
             ar & e.first;
@@ -0,0 +1,334 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#pragma once
+#include "Serializer.hpp"
+
+#include <iterator>
+#include <string>
+
+namespace crossbow {
+
+/**
+ * @brief Read only view of a serialized string pointing into the serialized buffer
+ *
+ * Has the same serialized format as std::string and crossbow::string. Deserializing into a view does not copy or
+ * allocate, the view is only valid as long as the buffer it was deserialized from.
+ */
+class serialized_string_view {
+public:
+    serialized_string_view()
+            : mData(nullptr),
+              mSize(0) {
+    }
+
+    serialized_string_view(const char* data, std::size_t size)
+            : mData(data),
+              mSize(size) {
+    }
+
+    template<class Traits, class Allocator>
+    serialized_string_view(const std::basic_string<char, Traits, Allocator>& str)
+            : mData(str.data()),
+              mSize(str.size()) {
+    }
+
+    const char* data() const {
+        return mData;
+    }
+
+    std::size_t size() const {
+        return mSize;
+    }
+
+    bool empty() const {
+        return mSize == 0;
+    }
+
+    const char* begin() const {
+        return mData;
+    }
+
+    const char* end() const {
+        return mData + mSize;
+    }
+
+    char operator[](std::size_t i) const {
+        return mData[i];
+    }
+
+    std::string str() const {
+        return std::string(mData, mSize);
+    }
+
+    bool operator==(const serialized_string_view& other) const {
+        return mSize == other.mSize && (mSize == 0 || memcmp(mData, other.mData, mSize) == 0);
+    }
+
+    bool operator!=(const serialized_string_view& other) const {
+        return !(*this == other);
+    }
+
+private:
+    const char* mData;
+    std::size_t mSize;
+};
+
+/**
+ * @brief Read only view of a serialized vector of trivially copyable elements pointing into the serialized buffer
+ *
+ * Has the same serialized format as std::vector<T>. Elements in the serialized buffer are not aligned, they are
+ * therefore returned by value.
+ */
+template<typename T>
+class serialized_span {
+    static_assert(is_bitwise_serializable<T>::value, "Only trivially copyable types can be viewed in place");
+public:
+    class iterator {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = T;
+
+        explicit iterator(const uint8_t* pos = nullptr)
+                : mPos(pos) {
+        }
+
+        T operator*() const {
+            T value;
+            memcpy(&value, mPos, sizeof(T));
+            return value;
+        }
+
+        T operator[](std::ptrdiff_t i) const {
+            return *(*this + i);
+        }
+
+        iterator& operator++() {
+            mPos += sizeof(T);
+            return *this;
+        }
+
+        iterator operator++(int) {
+            auto res = *this;
+            mPos += sizeof(T);
+            return res;
+        }
+
+        iterator& operator--() {
+            mPos -= sizeof(T);
+            return *this;
+        }
+
+        iterator operator--(int) {
+            auto res = *this;
+            mPos -= sizeof(T);
+            return res;
+        }
+
+        iterator& operator+=(std::ptrdiff_t n) {
+            mPos += n * static_cast<std::ptrdiff_t>(sizeof(T));
+            return *this;
+        }
+
+        iterator& operator-=(std::ptrdiff_t n) {
+            mPos -= n * static_cast<std::ptrdiff_t>(sizeof(T));
+            return *this;
+        }
+
+        iterator operator+(std::ptrdiff_t n) const {
+            return iterator(mPos + n * static_cast<std::ptrdiff_t>(sizeof(T)));
+        }
+
+        iterator operator-(std::ptrdiff_t n) const {
+            return iterator(mPos - n * static_cast<std::ptrdiff_t>(sizeof(T)));
+        }
+
+        std::ptrdiff_t operator-(const iterator& other) const {
+            return (mPos - other.mPos) / static_cast<std::ptrdiff_t>(sizeof(T));
+        }
+
+        bool operator==(const iterator& other) const {
+            return mPos == other.mPos;
+        }
+
+        bool operator!=(const iterator& other) const {
+            return mPos != other.mPos;
+        }
+
+        bool operator<(const iterator& other) const {
+            return mPos < other.mPos;
+        }
+
+        bool operator>(const iterator& other) const {
+            return mPos > other.mPos;
+        }
+
+        bool operator<=(const iterator& other) const {
+            return mPos <= other.mPos;
+        }
+
+        bool operator>=(const iterator& other) const {
+            return mPos >= other.mPos;
+        }
+
+    private:
+        const uint8_t* mPos;
+    };
+
+    serialized_span()
+            : mData(nullptr),
+              mSize(0) {
+    }
+
+    /**
+     * @brief Views size elements starting at the (possibly unaligned) data pointer
+     */
+    serialized_span(const void* data, std::size_t size)
+            : mData(reinterpret_cast<const uint8_t*>(data)),
+              mSize(size) {
+    }
+
+    /**
+     * @brief Pointer to the (possibly unaligned) first element
+     */
+    const uint8_t* data() const {
+        return mData;
+    }
+
+    std::size_t size() const {
+        return mSize;
+    }
+
+    bool empty() const {
+        return mSize == 0;
+    }
+
+    iterator begin() const {
+        return iterator(mData);
+    }
+
+    iterator end() const {
+        return iterator(mData + mSize * sizeof(T));
+    }
+
+    T operator[](std::size_t i) const {
+        T value;
+        memcpy(&value, mData + i * sizeof(T), sizeof(T));
+        return value;
+    }
+
+    /**
+     * @brief Copies all elements into the (aligned) destination
+     */
+    void copy(T* out) const {
+        if (mSize != 0) {
+            memcpy(out, mData, mSize * sizeof(T));
+        }
+    }
+
+private:
+    const uint8_t* mData;
+    std::size_t mSize;
+};
+
+template<typename Archiver>
+struct serialize_policy<Archiver, serialized_string_view>
+{
+    uint8_t* operator() (Archiver&, const serialized_string_view& obj, uint8_t* pos) const
+    {
+        uint32_t len = uint32_t(obj.size());
+        memcpy(pos, &len, sizeof(std::uint32_t));
+        pos += sizeof(std::uint32_t);
+        if (len != 0) {
+            memcpy(pos, obj.data(), len);
+        }
+        return pos + len;
+    }
+};
+
+template<typename Archiver>
+struct deserialize_policy<Archiver, serialized_string_view>
+{
+    const uint8_t* operator() (Archiver&, serialized_string_view& out, const uint8_t* ptr) const
+    {
+        std::uint32_t s;
+        memcpy(&s, ptr, sizeof(s));
+        out = serialized_string_view(reinterpret_cast<const char*>(ptr + sizeof(s)), s);
+        return ptr + sizeof(s) + s;
+    }
+};
+
+template<typename Archiver>
+struct size_policy<Archiver, serialized_string_view>
+{
+    std::size_t operator() (Archiver&, const serialized_string_view& obj) const
+    {
+        return sizeof(uint32_t) + obj.size();
+    }
+};
+
+template<>
+struct is_flat_serializable<serialized_string_view> : std::true_type {};
+
+template<typename Archiver, typename T>
+struct serialize_policy<Archiver, serialized_span<T>>
+{
+    uint8_t* operator() (Archiver&, const serialized_span<T>& obj, uint8_t* pos) const
+    {
+        std::size_t s = obj.size();
+        memcpy(pos, &s, sizeof(s));
+        pos += sizeof(s);
+        if (s != 0) {
+            memcpy(pos, obj.data(), s * sizeof(T));
+        }
+        return pos + s * sizeof(T);
+    }
+};
+
+template<typename Archiver, typename T>
+struct deserialize_policy<Archiver, serialized_span<T>>
+{
+    const uint8_t* operator() (Archiver&, serialized_span<T>& out, const uint8_t* ptr) const
+    {
+        std::size_t s;
+        memcpy(&s, ptr, sizeof(s));
+        out = serialized_span<T>(ptr + sizeof(s), s);
+        return ptr + sizeof(s) + s * sizeof(T);
+    }
+};
+
+template<typename Archiver, typename T>
+struct size_policy<Archiver, serialized_span<T>>
+{
+    std::size_t operator() (Archiver&, const serialized_span<T>& obj) const
+    {
+        return sizeof(std::size_t) + obj.size() * sizeof(T);
+    }
+};
+
+template<typename T>
+struct is_flat_serializable<serialized_span<T>> : std::true_type {};
+
+} // namespace crossbow
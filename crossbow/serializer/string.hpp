@@ -35,8 +35,8 @@ struct serialize_policy<Archiver, std::basic_string<Char, Traits, Allocator>>
         uint32_t len = uint32_t(obj.size());
         memcpy(pos, &len, sizeof(std::uint32_t));
         pos += sizeof(std::uint32_t);
-        memcpy(pos, obj.data(), len);
-        return pos + len;
+        memcpy(pos, obj.data(), len * sizeof(Char));
+        return pos + len * sizeof(Char);
     }
 };
 
@@ -47,8 +47,8 @@ struct deserialize_policy<Archiver, std::basic_string<Char, Traits, Allocator>>
     const uint8_t* operator() (Archiver&, type& out, const uint8_t* ptr) const
     {
         const std::uint32_t s = *reinterpret_cast<const std::uint32_t*>(ptr);
-        out = std::string(reinterpret_cast<const char*>(ptr + sizeof(std::uint32_t)), s);
-        return ptr + sizeof(s) + s;
+        out.assign(reinterpret_cast<const Char*>(ptr + sizeof(std::uint32_t)), s);
+        return ptr + sizeof(s) + s * sizeof(Char);
     }
 };
 
@@ -58,9 +58,12 @@ struct size_policy<Archiver, std::basic_string<Char, Traits, Allocator>>
     using type = std::basic_string<Char, Traits, Allocator>;
     std::size_t operator() (Archiver& ar, const type& obj) const
     {
-        return sizeof(uint32_t) + obj.size();
+        return sizeof(uint32_t) + obj.size() * sizeof(Char);
     }
 };
 
+template<class Char, class Traits, class Allocator>
+struct is_flat_serializable<std::basic_string<Char, Traits, Allocator>> : std::true_type {};
+
 } // namespace crossbow
 
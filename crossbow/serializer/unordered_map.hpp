@@ -64,7 +64,7 @@ struct size_policy<Archiver, std::unordered_map<Key, Value, Hash, Predicate, All
 {
     using type = std::unordered_map<Key, Value, Hash, Predicate, Allocator>;
     std::size_t operator() (Archiver& ar, const type& map) const {
-        std::size_t s;
+        std::size_t s = map.size();
         ar & s;
         for (auto& e : map) {
             ar & e.first;
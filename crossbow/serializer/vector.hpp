@@ -29,10 +29,23 @@ namespace crossbow {
 template<typename Archiver, typename T, typename Allocator>
 struct serialize_policy<Archiver, std::vector<T, Allocator>>
 {
-    uint8_t* operator() (Archiver& ar, const std::vector<T, Allocator>& v, uint8_t* pos) const {
+    template<class I = T>
+    typename std::enable_if<is_bitwise_serializable<I>::value, uint8_t*>::type
+    operator() (Archiver& ar, const std::vector<T, Allocator>& v, uint8_t* pos) const {
         std::size_t s = v.size();
         ar & s;
-        for (auto& e : v) {
+        if (s != 0) {
+            memcpy(ar.pos, v.data(), s * sizeof(T));
+        }
+        return ar.pos + s * sizeof(T);
+    }
+
+    template<class I = T>
+    typename std::enable_if<!is_bitwise_serializable<I>::value, uint8_t*>::type
+    operator() (Archiver& ar, const std::vector<T, Allocator>& v, uint8_t* pos) const {
+        std::size_t s = v.size();
+        ar & s;
+        for (const auto& e : v) {
             ar & e;
         }
         return ar.pos;
@@ -42,15 +55,31 @@ struct serialize_policy<Archiver, std::vector<T, Allocator>>
 template<typename Archiver, typename T, typename Allocator>
 struct deserialize_policy<Archiver, std::vector<T, Allocator>>
 {
-    const uint8_t* operator() (Archiver& ar, std::vector<T, Allocator>& out, const uint8_t* ptr) const
+    template<class I = T>
+    typename std::enable_if<is_bitwise_serializable<I>::value, const uint8_t*>::type
+    operator() (Archiver& ar, std::vector<T, Allocator>& out, const uint8_t* ptr) const
+    {
+        const std::size_t s = *reinterpret_cast<const std::size_t*>(ptr);
+        ptr += sizeof(s);
+        if (s != 0) {
+            auto offset = out.size();
+            out.resize(offset + s);
+            memcpy(out.data() + offset, ptr, s * sizeof(T));
+        }
+        return ptr + s * sizeof(T);
+    }
+
+    template<class I = T>
+    typename std::enable_if<!is_bitwise_serializable<I>::value, const uint8_t*>::type
+    operator() (Archiver& ar, std::vector<T, Allocator>& out, const uint8_t* ptr) const
     {
         const std::size_t s = *reinterpret_cast<const std::size_t*>(ptr);
         ar.pos = ptr + sizeof(s);
-        out.reserve(s);
+        out.reserve(out.size() + s);
         for (std::size_t i = 0; i < s; ++i) {
             T obj;
             ar & obj;
-            out.push_back(obj);
+            out.emplace_back(std::move(obj));
         }
         return ar.pos;
     }
@@ -59,15 +88,27 @@ struct deserialize_policy<Archiver, std::vector<T, Allocator>>
 template<typename Archiver, typename T, typename Allocator>
 struct size_policy<Archiver, std::vector<T, Allocator>>
 {
-    std::size_t operator() (Archiver& ar, const std::vector<T, Allocator>& obj) const
+    template<class I = T>
+    typename std::enable_if<is_bitwise_serializable<I>::value, std::size_t>::type
+    operator() (Archiver& ar, const std::vector<T, Allocator>& obj) const
     {
-        std::size_t s;
+        return sizeof(std::size_t) + obj.size() * sizeof(T);
+    }
+
+    template<class I = T>
+    typename std::enable_if<!is_bitwise_serializable<I>::value, std::size_t>::type
+    operator() (Archiver& ar, const std::vector<T, Allocator>& obj) const
+    {
+        std::size_t s = obj.size();
         ar & s;
-        for (auto& e : obj) {
+        for (const auto& e : obj) {
             ar & e;
         }
         return 0;
     }
 };
 
+template<typename T, typename Allocator>
+struct is_flat_serializable<std::vector<T, Allocator>> : is_bitwise_serializable<T> {};
+
 } // namespace crossbow
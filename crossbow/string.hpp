@@ -31,6 +31,8 @@
 #include <type_traits>
 #include <memory>
 
+#include <crossbow/memory_resource.hpp>
+
 namespace crossbow {
 
 template<class Char, class Traits = std::char_traits<Char>, class Allocator = std::allocator<Char> >
@@ -134,6 +136,18 @@ private: // Helpers
     inline const_pointer get_ptr() const {
         return const_cast<basic_string<Char, Traits, Allocator>*>(this)->get_ptr();
     }
+
+    // Allocators that cannot be assigned (like polymorphic_allocator) stay with the string
+    inline bool assign_allocator(const allocator_type &a, std::true_type) {
+        alloc = a;
+        return true;
+    }
+    inline bool assign_allocator(const allocator_type &a, std::false_type) {
+        return alloc == a;
+    }
+    inline bool assign_allocator(const allocator_type &a) {
+        return assign_allocator(a, std::is_copy_assignable<allocator_type>());
+    }
 public: // Helpers
     bool __invariants() const {
         return size() <= capacity();
@@ -243,7 +257,7 @@ for (auto & a : other.arr) {
 
     ~basic_string() {
         if (arr[0] == nullchar) {
-            alloc.deallocate(get_ptr(), capacity());
+            alloc.deallocate(get_ptr(), capacity() + 1);
             arr[0] = 0;
         }
     }
@@ -257,9 +271,13 @@ for (auto & a : other.arr) {
     }
     basic_string &operator=(basic_string && str) noexcept(std::is_nothrow_move_assignable<allocator_type>::value) {
         if (arr[0] == nullchar) {
-            alloc.deallocate(get_ptr(), size());
+            alloc.deallocate(get_ptr(), capacity() + 1);
+            arr[0] = 0;
+        }
+        if (!assign_allocator(str.alloc)) {
+            // The memory of str belongs to a different allocator
+            return assign(str.c_str(), str.size());
         }
-        alloc = std::move(str.alloc);
         arr = str.arr;
 for (auto & a : str.arr) {
             a = '\0';
@@ -292,7 +310,7 @@ for (auto & a : str.arr) {
 
     // Compatibility with std::string
     basic_string &operator= (std::basic_string<Char, traits_type, allocator_type> &o) {
-        alloc = o.get_allocator();
+        assign_allocator(o.get_allocator());
         return assign(o.c_str(), o.size());
     }
 
@@ -402,7 +420,7 @@ public: // Capacity
         return size() == 0;
     }
     size_type max_size() const {
-        return alloc.max_size() - 1;
+        return std::allocator_traits<allocator_type>::max_size(alloc) - 1;
     }
     size_type capacity() const {
         if (arr[0] != nullchar)
@@ -418,13 +436,13 @@ public: // Capacity
             auto ptr = get_ptr();
             arr[0] = (unsigned char)(s);
             std::copy(ptr, ptr + s, arr.begin() + 1);
-            alloc.deallocate(ptr, c);
+            alloc.deallocate(ptr, c + 1);
             arr[1 + s] = '\0';
         } else {
             auto nptr = alloc.allocate(s + 1);
             std::copy(begin(), end(), nptr);
             nptr[s] = '\0';
-            alloc.deallocate(get_ptr(), c);
+            alloc.deallocate(get_ptr(), c + 1);
             set_ptr(nptr);
             set_capacity(s);
         }
@@ -444,7 +462,7 @@ public: // Capacity
             arr[0] = nullchar;
             set_size(sz);
         } else {
-            alloc.deallocate(ptr, get_capacity());
+            alloc.deallocate(ptr, get_capacity() + 1);
         }
         set_capacity(new_cap);
         set_ptr(nptr);
@@ -1244,6 +1262,16 @@ bool operator>=(const std::basic_string<CharT, Traits, Alloc> &lhs, const basic_
 using string = basic_string<char>;
 using wstring = basic_string<wchar_t>;
 
+namespace pmr {
+
+template<class Char, class Traits = std::char_traits<Char> >
+using basic_string = crossbow::basic_string<Char, Traits, polymorphic_allocator<Char> >;
+
+using string = basic_string<char>;
+using wstring = basic_string<wchar_t>;
+
+} // namespace pmr
+
 template<class CharT, class Traits, class Allocator>
 size_t hash_value(const crossbow::basic_string<CharT, Traits, Allocator> &str) {
     constexpr size_t FNV_offset_basis = 14695981039346656037ul;
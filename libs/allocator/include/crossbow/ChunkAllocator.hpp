@@ -21,25 +21,58 @@
  *     Lucas Braun <braunl@inf.ethz.ch>
  */
 #pragma once
+#include <crossbow/alignment.hpp>
+#include <crossbow/memory_policy.hpp>
+#include <crossbow/memory_resource.hpp>
+
+#include <array>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 #include <limits>
 
 namespace crossbow {
 
+class ChunkCache;
+
 /*!
  * \brief Memory allocator used by the parser stage to allocate temporary objects
+ *
+ * Memory is handed out by bumping a pointer through a list of chunks. reset() rewinds the pool while keeping its
+ * chunks, so a pool reused across requests stops allocating once it has grown to the size of the largest request.
+ * Pools constructed from a ChunkCache take their chunks from the cache and return them on destruction. Chunks are
+ * allocated according to the memory_policy of the pool (or the cache), the chunk size is rounded up to its page size.
  */
 class ChunkMemoryPool {
 public:
     static constexpr std::size_t DEFAULT_SIZE = 1 * 1024 * 1024; // 1MB
 
-    ChunkMemoryPool(size_t chunkSize = DEFAULT_SIZE);
+    static constexpr std::size_t DEFAULT_ALIGNMENT = 8;
+
+    /*!
+     * \brief Pool of the calling thread backed by ChunkCache::global()
+     */
+    static ChunkMemoryPool& local();
+
+    ChunkMemoryPool(size_t chunkSize = DEFAULT_SIZE, const memory_policy& policy = memory_policy());
+
+    explicit ChunkMemoryPool(ChunkCache& cache);
+
+    /*!
+     * \brief Pool serving allocations from the caller provided buffer before allocating any chunk
+     *
+     * The buffer has to outlive the pool and is reused after reset(), see inline_arena.
+     */
+    ChunkMemoryPool(char* buffer, std::size_t size, ChunkCache& cache);
+
+    ChunkMemoryPool(char* buffer, std::size_t size, size_t chunkSize = DEFAULT_SIZE,
+            const memory_policy& policy = memory_policy());
 
     // Disable copy constructor and assignment
     ChunkMemoryPool(const ChunkMemoryPool&) = delete;
@@ -47,20 +80,219 @@ public:
 
     ~ChunkMemoryPool();
 
-    void* allocate(std::size_t size);
+    void* allocate(std::size_t size, std::size_t alignment = DEFAULT_ALIGNMENT) {
+        auto p = crossbow::align(mCurrent, alignment);
+        if (static_cast<std::size_t>(mEnd - mCurrent) < size + static_cast<std::size_t>(p - mCurrent)) {
+            return allocateSlow(size, alignment);
+        }
+        mCurrent = p + size;
+        return p;
+    }
+
+    /*!
+     * \brief Releases all allocations at once
+     *
+     * The first keepChunks chunks are kept for subsequent allocations, the remaining chunks and all oversized
+     * allocations are returned to the cache (or freed if the pool has no cache). Pools with an inline buffer start
+     * allocating from the buffer again.
+     */
+    void reset(std::size_t keepChunks = std::numeric_limits<std::size_t>::max());
 
     size_t chunkSize() const { return mChunkSize; }
 
+    /*!
+     * \brief Number of bytes in chunks and oversized allocations currently owned by the pool
+     */
+    size_t reserved() const;
+
 private:
-    void appendNewChunk();
+    /// Value of mIndex while allocating from the inline buffer
+    static constexpr std::size_t INLINE_INDEX = std::numeric_limits<std::size_t>::max();
+
+    void* allocateSlow(std::size_t size, std::size_t alignment);
+
+    void nextChunk();
+
+    char* acquireBlock(std::size_t size);
+
+    void releaseBlock(char* block, std::size_t size);
 
 private:
+    memory_policy mPolicy;
     std::size_t mChunkSize;
+    ChunkCache* mCache;
+
+    char* mInline = nullptr;
+    std::size_t mInlineSize = 0;
 
     char* mCurrent;
     char* mEnd;
 
+    /// Index of the chunk mCurrent points into
+    std::size_t mIndex;
     std::vector<char*> mChunks;
+
+    /// Oversized allocations together with their block size
+    std::vector<std::pair<char*, std::size_t>> mLarge;
+};
+
+/*!
+ * \brief Thread-safe cache of free chunks shared between ChunkMemoryPools
+ *
+ * Blocks are kept in size classes of chunkSize << i, oversized allocations of a pool are rounded up to the next
+ * class so they can be reused by later requests. Blocks larger than the largest class are not cached. Once the
+ * cache holds capacity bytes further blocks are freed instead.
+ */
+class ChunkCache {
+public:
+    static constexpr std::size_t NUM_CLASSES = 8;
+
+    static constexpr std::size_t DEFAULT_CAPACITY = 64 * 1024 * 1024; // 64MB
+
+    /*!
+     * \brief Cache of ChunkMemoryPool::DEFAULT_SIZE chunks backing ChunkMemoryPool::local()
+     */
+    static ChunkCache& global();
+
+    explicit ChunkCache(std::size_t chunkSize = ChunkMemoryPool::DEFAULT_SIZE,
+            std::size_t capacity = DEFAULT_CAPACITY, const memory_policy& policy = memory_policy());
+
+    ChunkCache(const ChunkCache&) = delete;
+    void operator =(const ChunkCache&) = delete;
+
+    ~ChunkCache();
+
+    std::size_t chunkSize() const { return mChunkSize; }
+
+    const memory_policy& policy() const { return mPolicy; }
+
+    /*!
+     * \brief Size of the block that is used for an allocation of size bytes
+     */
+    std::size_t blockSize(std::size_t size) const;
+
+    /*!
+     * \brief Returns a block of blockSize(size) bytes
+     */
+    char* acquire(std::size_t size);
+
+    /*!
+     * \brief Returns a block of blockSize(size) bytes to the cache
+     */
+    void release(char* block, std::size_t size);
+
+    /*!
+     * \brief Number of bytes in free blocks held by the cache
+     */
+    std::size_t cached() const;
+
+private:
+    std::size_t sizeClass(std::size_t size) const;
+
+    memory_policy mPolicy;
+    std::size_t mChunkSize;
+    std::size_t mCapacity;
+
+    mutable std::mutex mMutex;
+    std::size_t mCached;
+    std::array<std::vector<char*>, NUM_CLASSES> mBlocks;
+};
+
+namespace impl {
+
+template <std::size_t N>
+struct inline_buffer {
+    alignas(std::max_align_t) char mBuffer[N];
+};
+
+} // namespace impl
+
+/*!
+ * \brief Monotonic arena for short lived scopes like a request handler
+ *
+ * Allocations are served from an inline buffer of N bytes first (on the stack if the arena lives there), overflow is
+ * allocated in chunks from a ChunkCache. Everything is released when the arena goes out of scope. The arena is a
+ * ChunkMemoryPool, so it can be used with ChunkAllocator, ChunkObject and ChunkMemoryResource:
+ *
+ *     crossbow::inline_arena<4096> arena;
+ *     std::vector<int, crossbow::ChunkAllocator<int>> vec(crossbow::ChunkAllocator<int>(&arena));
+ */
+template <std::size_t N>
+class inline_arena : private impl::inline_buffer<N>, public ChunkMemoryPool {
+public:
+    inline_arena()
+        : ChunkMemoryPool(this->mBuffer, N, ChunkCache::global()) {
+    }
+
+    explicit inline_arena(ChunkCache& cache)
+        : ChunkMemoryPool(this->mBuffer, N, cache) {
+    }
+
+    /*!
+     * \brief Whether the allocation lies within the inline buffer
+     */
+    bool isInline(const void* ptr) const {
+        auto p = static_cast<const char*>(ptr);
+        return p >= this->mBuffer && p < this->mBuffer + N;
+    }
+};
+
+/*!
+ * \brief memory_resource allocating from a ChunkMemoryPool
+ *
+ * Deallocation does nothing, the memory is released with the pool. Containers using the resource have the same type
+ * as containers using any other resource (see crossbow::pmr).
+ */
+class ChunkMemoryResource : public memory_resource {
+public:
+    explicit ChunkMemoryResource(ChunkMemoryPool& pool)
+        : mPool(pool) {
+    }
+
+    ChunkMemoryPool& pool() { return mPool; }
+
+private:
+    virtual void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        return mPool.allocate(bytes, alignment);
+    }
+
+    virtual void do_deallocate(void*, std::size_t, std::size_t) override {
+        // Do nothing
+    }
+
+    virtual bool do_is_equal(const memory_resource& other) const noexcept override {
+        auto o = dynamic_cast<const ChunkMemoryResource*>(&other);
+        return o && &o->mPool == &mPool;
+    }
+
+    ChunkMemoryPool& mPool;
+};
+
+/*!
+ * \brief Scope of a request allocating from ChunkMemoryPool::local()
+ *
+ * The thread-local pool is reset once the outermost scope of the thread ends, so everything allocated within a
+ * request has to be dead by then.
+ */
+class ChunkPoolScope {
+public:
+    ChunkPoolScope();
+
+    ChunkPoolScope(const ChunkPoolScope&) = delete;
+    void operator =(const ChunkPoolScope&) = delete;
+
+    ~ChunkPoolScope();
+
+    ChunkMemoryPool& pool() { return mPool; }
+
+    /*!
+     * \brief Resource allocating from the thread-local pool
+     */
+    memory_resource* resource() { return &mResource; }
+
+private:
+    ChunkMemoryPool& mPool;
+    ChunkMemoryResource mResource;
 };
 
 /*!
@@ -142,7 +374,7 @@ ChunkAllocator<T>::ChunkAllocator(const ChunkAllocator<U>& other) {
 
 template <class T>
 T* ChunkAllocator<T>::allocate(std::size_t n) {
-    auto p = m_pool->allocate(sizeof(T) * n);
+    auto p = m_pool->allocate(sizeof(T) * n, alignof(T));
     return static_cast<T*>(p);
 }
 
@@ -22,7 +22,11 @@
  */
 #pragma once
 
+#include <crossbow/memory_resource.hpp>
+
+#include <array>
 #include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <functional>
 #include <type_traits>
@@ -32,7 +36,68 @@ namespace crossbow {
 
 class allocator {
 public:
-    static void init();
+    /**
+     * @brief Source of the memory handed out by allocator::malloc
+     */
+    enum class backend {
+        /// Every allocation is served by ::malloc
+        system,
+
+        /// Small allocations are served by the crossbow::slab_allocator, larger ones by ::malloc
+        slab,
+    };
+
+    /**
+     * @brief Snapshot of the reclamation counters
+     *
+     * Objects count as retired once the retiring thread flushed them from its private buffer to the epoch lists, so a
+     * snapshot may miss the last few objects retired by every thread. Byte counts include the allocation header and
+     * the padding of the memory backend.
+     */
+    struct stats {
+        /// Current epoch which is also the number of epoch advances since init
+        uint64_t epoch;
+
+        /// Time since the epoch advanced the last time
+        std::chrono::nanoseconds since_advance;
+
+        uint64_t retired_objects;
+        uint64_t retired_bytes;
+        uint64_t reclaimed_objects;
+        uint64_t reclaimed_bytes;
+
+        /// Retired but not yet reclaimed bytes
+        uint64_t pending_bytes;
+
+        /// Objects waiting in the epoch lists, the first entry belongs to the current epoch, the next to its predecessor
+        std::array<uint64_t, 3> pending_objects;
+
+        /// Objects past their grace period waiting to be reclaimed
+        uint64_t expired_objects;
+
+        /// Number of threads inside a guard
+        uint64_t active_guards;
+
+        /// Time since the beginning of the epoch announced by the oldest guard
+        std::chrono::nanoseconds oldest_guard_age;
+    };
+
+    static void init(backend source = backend::system);
+
+    /**
+     * @brief Reads the current reclamation counters
+     *
+     * Takes time linear in the number of threads that ever held a guard, guards and retirement are not blocked.
+     */
+    static stats snapshot();
+
+    /**
+     * @brief Registers a callback invoked when more than threshold bytes are retired but not yet reclaimed
+     *
+     * The callback runs on the thread whose retirement crossed the threshold and is invoked again only after the
+     * pending bytes dropped below the threshold in between. A threshold of 0 disables the callback.
+     */
+    static void set_pending_callback(std::size_t threshold, std::function<void(const stats&)> callback);
 
     static void destroy();
 
@@ -40,11 +105,62 @@ public:
 
     static void* malloc(std::size_t size, std::size_t align);
 
-    static void free(void* ptr, std::function<void()> destruct = []() { });
-    static void free_in_order(void* ptr, std::function<void()> destruct = []() { });
+    /**
+     * @brief memory_resource allocating epoch managed memory
+     *
+     * Deallocated memory is released like allocator::free, so containers using the resource may be read by other
+     * threads holding a guard while they are modified.
+     */
+    static memory_resource* resource();
+
+    /**
+     * @brief Callback invoked with its argument once a retired pointer is no longer reachable by any guard
+     */
+    using destructor = void (*)(void*);
+
+    /**
+     * @brief Size of the header prepended to every allocation
+     */
+    static std::size_t header_size();
+
+    static void free(void* ptr);
+    static void free_in_order(void* ptr);
+
+    /**
+     * @brief Retires the pointer and invokes destruct(arg) before the memory is released
+     *
+     * The callback is stored directly in the allocation header, retiring does not allocate.
+     */
+    static void free(void* ptr, destructor destruct, void* arg);
+    static void free_in_order(void* ptr, destructor destruct, void* arg);
+
+    /**
+     * @brief Retires the pointer and invokes an arbitrary callback before the memory is released
+     *
+     * Slow path: The callback is moved to the heap, prefer the destructor overloads where possible.
+     */
+    static void free(void* ptr, std::function<void()> destruct);
+    static void free_in_order(void* ptr, std::function<void()> destruct);
 
     static void free_now(void* ptr);
 
+    /**
+     * @brief Starts a background thread reclaiming expired objects
+     *
+     * By default expired objects are reclaimed in bounded chunks whenever a guard is released. With the background
+     * reclaimer running guards only advance the epoch and all destructors are invoked from the reclaimer thread.
+     */
+    static void start_reclaimer();
+
+    /**
+     * @brief Stops the background reclaimer, reclamation falls back to the releasing guards
+     */
+    static void stop_reclaimer();
+
+    static void invoke(destructor fun, void* arg) {
+        allocator::free(allocator::malloc(0), fun, arg);
+    }
+
     static void invoke(std::function<void()> fun) {
         allocator::free(allocator::malloc(0), std::move(fun));
     }
@@ -66,9 +182,7 @@ public:
             return;
         }
 
-        allocator::free(ptr, [ptr] () {
-            ptr->~T();
-        });
+        allocator::free(ptr, &allocator::destruct_object<T>, ptr);
     }
 
     template <typename T>
@@ -77,9 +191,7 @@ public:
             return;
         }
 
-        allocator::free_in_order(ptr, [ptr] () {
-            ptr->~T();
-        });
+        allocator::free_in_order(ptr, &allocator::destruct_object<T>, ptr);
     }
 
     template <typename T>
@@ -97,7 +209,10 @@ public:
     ~allocator();
 
 private:
-    std::atomic<uint64_t>* cnt_;
+    template <typename T>
+    static void destruct_object(void* ptr) {
+        static_cast<T*>(ptr)->~T();
+    }
 };
 
 } // namespace crossbow
@@ -0,0 +1,130 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#pragma once
+
+#include <crossbow/allocator.hpp>
+
+#include <cstddef>
+#include <utility>
+
+namespace crossbow {
+
+/**
+ * @brief Owning pointer whose object is destroyed through the epoch based crossbow::allocator
+ *
+ * Like std::unique_ptr there is exactly one owner. When the owner releases the object it is handed to
+ * allocator::destroy, so the object stays alive until every thread that held a crossbow::allocator guard at that time
+ * has released it. This allows readers to access the object through a raw pointer without copying it:
+ *
+ *     crossbow::allocator _;
+ *     auto value = map.get(key); // stays valid until _ goes out of scope
+ *
+ * The object has to be allocated with allocator::construct (e.g. through make_epoch_ptr).
+ */
+template <typename T>
+class epoch_ptr {
+public:
+    typedef T element_type;
+    typedef T* pointer;
+
+    epoch_ptr() noexcept
+        : mPtr(nullptr) {
+    }
+
+    explicit epoch_ptr(pointer ptr) noexcept
+        : mPtr(ptr) {
+    }
+
+    epoch_ptr(std::nullptr_t) noexcept
+        : mPtr(nullptr) {
+    }
+
+    ~epoch_ptr() {
+        allocator::destroy(mPtr);
+    }
+
+    epoch_ptr(const epoch_ptr&) = delete;
+    epoch_ptr& operator=(const epoch_ptr&) = delete;
+
+    epoch_ptr(epoch_ptr&& other) noexcept
+        : mPtr(other.mPtr) {
+        other.mPtr = nullptr;
+    }
+
+    epoch_ptr& operator=(epoch_ptr&& other) {
+        reset(other.release());
+        return *this;
+    }
+
+    epoch_ptr& operator=(std::nullptr_t) {
+        reset();
+        return *this;
+    }
+
+    pointer get() const noexcept {
+        return mPtr;
+    }
+
+    T& operator*() const {
+        return *mPtr;
+    }
+
+    pointer operator->() const noexcept {
+        return mPtr;
+    }
+
+    explicit operator bool() const noexcept {
+        return mPtr != nullptr;
+    }
+
+    /**
+     * @brief Gives up ownership without destroying the object
+     */
+    pointer release() noexcept {
+        auto ptr = mPtr;
+        mPtr = nullptr;
+        return ptr;
+    }
+
+    /**
+     * @brief Replaces the owned object, the old object is destroyed once all current epochs have ended
+     */
+    void reset(pointer ptr = nullptr) {
+        auto old = mPtr;
+        mPtr = ptr;
+        allocator::destroy(old);
+    }
+
+private:
+    pointer mPtr;
+};
+
+/**
+ * @brief Constructs an object with allocator::construct and wraps it into an epoch_ptr
+ */
+template <typename T, typename... Args>
+epoch_ptr<T> make_epoch_ptr(Args&&... args) {
+    return epoch_ptr<T>(allocator::construct<T>(std::forward<Args>(args)...));
+}
+
+} // namespace crossbow
@@ -0,0 +1,191 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace crossbow {
+
+namespace impl {
+
+/**
+ * @brief Hazard slot owned by at most one hazard_pointer at a time
+ */
+struct alignas(64) hazard_record {
+    hazard_record()
+        : hazard(nullptr),
+          used(true),
+          next(nullptr) {
+    }
+
+    std::atomic<const void*> hazard;
+    std::atomic<bool> used;
+    hazard_record* next;
+};
+
+struct retired_block;
+
+} // namespace impl
+
+/**
+ * @brief Hazard pointer based reclamation domain
+ *
+ * Alternative to the epoch based crossbow::allocator for readers that hold on to objects for a long time: A reader
+ * only protects the objects it currently references, so a slow reader keeps at most a few objects alive instead of
+ * stalling the reclamation of everything retired in the meantime. Both schemes can be used side by side as long as
+ * every object is retired through exactly one of them.
+ *
+ * Retired objects are buffered per thread and handed to the domain in batches. Once the number of retired objects
+ * exceeds the threshold the retiring thread scans all hazard slots and reclaims every object that is not protected,
+ * so the number of unreclaimed objects stays bounded by the threshold plus the number of hazard slots.
+ *
+ * A domain must outlive all threads retiring objects into it.
+ */
+class hazard_domain {
+public:
+    using deleter = void (*)(void*);
+
+    static constexpr std::size_t default_threshold = 1024;
+
+    /**
+     * @brief Domain used by hazard_pointers that are not given a domain
+     */
+    static hazard_domain& global();
+
+    explicit hazard_domain(std::size_t threshold = default_threshold);
+
+    hazard_domain(const hazard_domain&) = delete;
+    hazard_domain& operator=(const hazard_domain&) = delete;
+
+    /**
+     * @brief Reclaims all retired objects, no hazard pointer of the domain may be in use anymore
+     */
+    ~hazard_domain();
+
+    /**
+     * @brief Retires the object, del(ptr) is invoked once no hazard pointer protects it anymore
+     */
+    void retire(void* ptr, deleter del);
+
+    template <typename T>
+    void retire(T* ptr) {
+        retire(ptr, &hazard_domain::delete_object<T>);
+    }
+
+    /**
+     * @brief Hands the retired objects buffered by the calling thread to the domain and reclaims all unprotected
+     * objects
+     */
+    void scan();
+
+    /**
+     * @brief Number of retired but not yet reclaimed objects handed to the domain
+     */
+    std::size_t pending() const {
+        return mPending.load(std::memory_order_relaxed);
+    }
+
+private:
+    friend class hazard_pointer;
+
+    template <typename T>
+    static void delete_object(void* ptr) {
+        delete static_cast<T*>(ptr);
+    }
+
+    impl::hazard_record* acquire();
+
+    void release(impl::hazard_record* record);
+
+    void push(impl::retired_block* block);
+
+    /**
+     * @brief Adds the block to the retired objects, returns the number of pending objects
+     */
+    std::size_t link(impl::retired_block* block);
+
+    void reclaim();
+
+    std::size_t mThreshold;
+    std::atomic<impl::hazard_record*> mRecords;
+    std::atomic<impl::retired_block*> mRetired;
+    std::atomic<std::size_t> mPending;
+};
+
+/**
+ * @brief Owner of a hazard slot
+ *
+ * Protects at most one object at a time:
+ *
+ *     crossbow::hazard_pointer hp;
+ *     auto node = hp.protect(head); // stays valid until hp protects another object or is destroyed
+ */
+class hazard_pointer {
+public:
+    explicit hazard_pointer(hazard_domain& domain = hazard_domain::global())
+        : mDomain(domain),
+          mRecord(domain.acquire()) {
+    }
+
+    hazard_pointer(const hazard_pointer&) = delete;
+    hazard_pointer& operator=(const hazard_pointer&) = delete;
+
+    ~hazard_pointer() {
+        mDomain.release(mRecord);
+    }
+
+    /**
+     * @brief Loads the pointer from src and protects it from being reclaimed
+     */
+    template <typename T>
+    T* protect(const std::atomic<T*>& src) {
+        auto ptr = src.load(std::memory_order_relaxed);
+        while (true) {
+            mRecord->hazard.store(ptr);
+            auto current = src.load(std::memory_order_acquire);
+            if (current == ptr) {
+                return ptr;
+            }
+            ptr = current;
+        }
+    }
+
+    /**
+     * @brief Protects a pointer the caller knows to be not yet retired
+     */
+    void reset(const void* ptr = nullptr) {
+        if (ptr) {
+            mRecord->hazard.store(ptr);
+        } else {
+            mRecord->hazard.store(nullptr, std::memory_order_release);
+        }
+    }
+
+private:
+    hazard_domain& mDomain;
+    impl::hazard_record* mRecord;
+};
+
+} // namespace crossbow
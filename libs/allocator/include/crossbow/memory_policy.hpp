@@ -0,0 +1,84 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#pragma once
+
+#include <cstddef>
+#include <system_error>
+
+namespace crossbow {
+
+/**
+ * @brief Placement of large memory blocks like pool chunks or registered buffers
+ *
+ * With page_size::heap blocks are allocated with new char[] and all other settings are ignored. Otherwise blocks are
+ * mapped with mmap and their size is rounded up to a multiple of the page size. If no huge pages of the requested
+ * size are available the next smaller huge page size is tried before falling back to standard pages with
+ * transparent huge pages requested via madvise.
+ */
+struct memory_policy {
+    enum class page_size {
+        heap,
+        standard,
+        huge_2m,
+        huge_1g,
+    };
+
+    memory_policy() = default;
+
+    explicit memory_policy(page_size p, int node = -1, bool touch = false)
+        : pages(p),
+          numa_node(node),
+          prefault(touch) {
+    }
+
+    page_size pages = page_size::heap;
+
+    /// NUMA node the pages are bound to, -1 to use the default policy of the thread (ignored without NUMA support)
+    int numa_node = -1;
+
+    /// Whether all pages are faulted in before the block is returned
+    bool prefault = false;
+
+    /**
+     * @brief Size of the block used for an allocation of length bytes
+     */
+    std::size_t block_size(std::size_t length) const;
+
+    /**
+     * @brief Allocates a block of block_size(length) bytes
+     *
+     * @param used Set to the page size the block was actually mapped with
+     *
+     * @exception std::system_error In case mapping the memory or binding it to the NUMA node failed
+     */
+    void* allocate(std::size_t length, page_size* used = nullptr) const;
+
+    /**
+     * @brief Releases a block returned by allocate(length)
+     *
+     * @return The error in case unmapping the block failed
+     */
+    std::error_code deallocate(void* ptr, std::size_t length) const;
+};
+
+} // namespace crossbow
@@ -0,0 +1,81 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace crossbow {
+
+/**
+ * @brief Size class allocator for small objects
+ *
+ * Memory is carved from 64 KiB slabs which only contain blocks of a single size class. Every thread caches freed blocks
+ * in a private free list per size class and exchanges them in batches with an arena. There is one arena per NUMA node
+ * and threads allocate from the arena of the node they were first scheduled on, so the slabs are touched and thus
+ * placed on the local node.
+ *
+ * Slabs are never returned to the operating system.
+ */
+class slab_allocator {
+public:
+    /// Size and alignment of a slab
+    static constexpr std::size_t slab_size = 64 * 1024;
+
+    /// Largest block size served from slabs
+    static constexpr std::size_t max_size = 8 * 1024;
+
+    /// Number of distinct size classes
+    static constexpr std::size_t num_classes = 32;
+
+    /**
+     * @brief Allocates a block of at least size bytes aligned to 16 bytes
+     *
+     * The size must not exceed max_size.
+     */
+    static void* allocate(std::size_t size);
+
+    /**
+     * @brief Returns a block to the free list of the calling thread
+     *
+     * The block may be released by another thread than the one that allocated it.
+     */
+    static void deallocate(void* ptr);
+
+    /**
+     * @brief Size of the blocks handed out for allocations of size bytes
+     */
+    static std::size_t block_size(std::size_t size);
+
+    /**
+     * @brief Size of the block ptr points to
+     */
+    static std::size_t usable_size(void* ptr);
+
+    /**
+     * @brief Total number of bytes reserved for slabs
+     */
+    static std::size_t reserved();
+};
+
+} // namespace crossbow
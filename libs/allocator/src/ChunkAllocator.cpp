@@ -25,42 +25,231 @@
 
 #include <crossbow/alignment.hpp>
 
+#include <algorithm>
 #include <cstdlib>
 
 namespace crossbow {
 
-ChunkMemoryPool::ChunkMemoryPool(size_t chunkSize)
-    : mChunkSize(chunkSize)
-    , mCurrent{new char[mChunkSize]}
+constexpr std::size_t ChunkMemoryPool::DEFAULT_SIZE;
+constexpr std::size_t ChunkMemoryPool::DEFAULT_ALIGNMENT;
+constexpr std::size_t ChunkMemoryPool::INLINE_INDEX;
+constexpr std::size_t ChunkCache::NUM_CLASSES;
+constexpr std::size_t ChunkCache::DEFAULT_CAPACITY;
+
+namespace {
+
+/**
+ * @brief Number of ChunkPoolScopes alive on this thread
+ */
+thread_local std::size_t scope_depth = 0;
+
+} // anonymous namespace
+
+ChunkMemoryPool& ChunkMemoryPool::local() {
+    thread_local ChunkMemoryPool pool(ChunkCache::global());
+    return pool;
+}
+
+ChunkMemoryPool::ChunkMemoryPool(size_t chunkSize, const memory_policy& policy)
+    : mPolicy(policy)
+    , mChunkSize(mPolicy.block_size(chunkSize))
+    , mCache(nullptr)
+    , mCurrent{acquireBlock(mChunkSize)}
     , mEnd{mCurrent + mChunkSize}
+    , mIndex(0)
     , mChunks({mCurrent})
 {
 }
 
+ChunkMemoryPool::ChunkMemoryPool(ChunkCache& cache)
+    : mPolicy(cache.policy())
+    , mChunkSize(cache.chunkSize())
+    , mCache(&cache)
+    , mCurrent{acquireBlock(mChunkSize)}
+    , mEnd{mCurrent + mChunkSize}
+    , mIndex(0)
+    , mChunks({mCurrent})
+{
+}
+
+ChunkMemoryPool::ChunkMemoryPool(char* buffer, std::size_t size, ChunkCache& cache)
+    : mPolicy(cache.policy())
+    , mChunkSize(cache.chunkSize())
+    , mCache(&cache)
+    , mInline(buffer)
+    , mInlineSize(size)
+    , mCurrent(buffer)
+    , mEnd(buffer + size)
+    , mIndex(INLINE_INDEX)
+{
+}
+
+ChunkMemoryPool::ChunkMemoryPool(char* buffer, std::size_t size, size_t chunkSize, const memory_policy& policy)
+    : mPolicy(policy)
+    , mChunkSize(mPolicy.block_size(chunkSize))
+    , mCache(nullptr)
+    , mInline(buffer)
+    , mInlineSize(size)
+    , mCurrent(buffer)
+    , mEnd(buffer + size)
+    , mIndex(INLINE_INDEX)
+{
+}
+
 ChunkMemoryPool::~ChunkMemoryPool() {
+    for (auto& l : mLarge) {
+        releaseBlock(l.first, l.second);
+    }
     for (auto c : mChunks) {
-        delete[] c;
+        releaseBlock(c, mChunkSize);
     }
 }
 
-void* ChunkMemoryPool::allocate(std::size_t size) {
-    if ((mCurrent + size) > mEnd) {
-        if (size > mChunkSize) { 
-            auto res = new char[size];
-            mChunks.push_back(res);
-            return res;
-        }
-        appendNewChunk();
+void ChunkMemoryPool::reset(std::size_t keepChunks) {
+    for (auto& l : mLarge) {
+        releaseBlock(l.first, l.second);
+    }
+    mLarge.clear();
+
+    if (!mInline) {
+        keepChunks = std::max(keepChunks, std::size_t(1));
+    }
+    while (mChunks.size() > keepChunks) {
+        releaseBlock(mChunks.back(), mChunkSize);
+        mChunks.pop_back();
+    }
+    if (mInline) {
+        mIndex = INLINE_INDEX;
+        mCurrent = mInline;
+        mEnd = mInline + mInlineSize;
+    } else {
+        mIndex = 0;
+        mCurrent = mChunks.front();
+        mEnd = mCurrent + mChunkSize;
+    }
+}
+
+size_t ChunkMemoryPool::reserved() const {
+    auto result = mChunks.size() * mChunkSize;
+    for (auto& l : mLarge) {
+        result += l.second;
+    }
+    return result;
+}
+
+void* ChunkMemoryPool::allocateSlow(std::size_t size, std::size_t alignment) {
+    // Blocks are at least aligned like new char[], larger alignments are satisfied by padding
+    auto padding = (alignment > alignof(std::max_align_t) ? alignment : 0);
+    if (size + padding > mChunkSize) {
+        auto blockSize = (mCache ? mCache->blockSize(size + padding) : size + padding);
+        auto block = acquireBlock(blockSize);
+        mLarge.emplace_back(block, blockSize);
+        return crossbow::align(block, alignment);
     }
-    auto p = mCurrent;
-    mCurrent = crossbow::align(mCurrent + size, 8u);
+
+    nextChunk();
+    auto p = crossbow::align(mCurrent, alignment);
+    mCurrent = p + size;
     return p;
 }
 
-void ChunkMemoryPool::appendNewChunk() {
-    mCurrent = new char[mChunkSize];
+void ChunkMemoryPool::nextChunk() {
+    mIndex = (mIndex == INLINE_INDEX ? 0 : mIndex + 1);
+    if (mIndex == mChunks.size()) {
+        mChunks.push_back(acquireBlock(mChunkSize));
+    }
+    mCurrent = mChunks[mIndex];
     mEnd = mCurrent + mChunkSize;
-    mChunks.push_back(mCurrent);
+}
+
+char* ChunkMemoryPool::acquireBlock(std::size_t size) {
+    return static_cast<char*>(mCache ? mCache->acquire(size) : mPolicy.allocate(size));
+}
+
+void ChunkMemoryPool::releaseBlock(char* block, std::size_t size) {
+    if (mCache) {
+        mCache->release(block, size);
+    } else {
+        mPolicy.deallocate(block, size);
+    }
+}
+
+ChunkCache& ChunkCache::global() {
+    static ChunkCache cache;
+    return cache;
+}
+
+ChunkCache::ChunkCache(std::size_t chunkSize, std::size_t capacity, const memory_policy& policy)
+    : mPolicy(policy),
+      mChunkSize(mPolicy.block_size(chunkSize)),
+      mCapacity(capacity),
+      mCached(0) {
+}
+
+ChunkCache::~ChunkCache() {
+    for (std::size_t i = 0; i < NUM_CLASSES; ++i) {
+        for (auto block : mBlocks[i]) {
+            mPolicy.deallocate(block, mChunkSize << i);
+        }
+    }
+}
+
+std::size_t ChunkCache::sizeClass(std::size_t size) const {
+    std::size_t i = 0;
+    while (i < NUM_CLASSES && (mChunkSize << i) < size) {
+        ++i;
+    }
+    return i;
+}
+
+std::size_t ChunkCache::blockSize(std::size_t size) const {
+    auto i = sizeClass(size);
+    return (i == NUM_CLASSES ? size : mChunkSize << i);
+}
+
+char* ChunkCache::acquire(std::size_t size) {
+    auto i = sizeClass(size);
+    if (i != NUM_CLASSES) {
+        std::lock_guard<std::mutex> _(mMutex);
+        auto& blocks = mBlocks[i];
+        if (!blocks.empty()) {
+            auto block = blocks.back();
+            blocks.pop_back();
+            mCached -= (mChunkSize << i);
+            return block;
+        }
+    }
+    return static_cast<char*>(mPolicy.allocate(blockSize(size)));
+}
+
+void ChunkCache::release(char* block, std::size_t size) {
+    auto i = sizeClass(size);
+    if (i != NUM_CLASSES) {
+        std::lock_guard<std::mutex> _(mMutex);
+        if (mCached + (mChunkSize << i) <= mCapacity) {
+            mBlocks[i].push_back(block);
+            mCached += (mChunkSize << i);
+            return;
+        }
+    }
+    mPolicy.deallocate(block, blockSize(size));
+}
+
+std::size_t ChunkCache::cached() const {
+    std::lock_guard<std::mutex> _(mMutex);
+    return mCached;
+}
+
+ChunkPoolScope::ChunkPoolScope()
+    : mPool(ChunkMemoryPool::local()),
+      mResource(mPool) {
+    ++scope_depth;
+}
+
+ChunkPoolScope::~ChunkPoolScope() {
+    if (--scope_depth == 0) {
+        mPool.reset();
+    }
 }
 
 ChunkObject::~ChunkObject() = default;
@@ -21,31 +21,131 @@
  *     Lucas Braun <braunl@inf.ethz.ch>
  */
 #include <crossbow/allocator.hpp>
+#include <crossbow/slab_allocator.hpp>
+
+#include <crossbow/alignment.hpp>
 
 #include <array>
+#include <chrono>
+#include <condition_variable>
 #include <cstdlib>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <thread>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
 
 namespace {
 
 constexpr size_t NUM_LISTS = 64;
 
+/// Number of retired pointers buffered by a thread before they are appended to the shared lists
+constexpr size_t RETIRE_BATCH = 64;
+
+/// Maximum number of pointers reclaimed on every guard exit
+constexpr size_t RECLAIM_CHUNK = 1024;
+
+/// Number of epoch slots inspected on every guard exit while trying to advance the epoch
+constexpr size_t SCAN_STEP = 8;
+
+crossbow::allocator::backend memory_source = crossbow::allocator::backend::system;
+
+/// Set in the base pointer of allocations served by the slab allocator
+constexpr uintptr_t SLAB_TAG = 0x1;
+
+void* allocateMemory(size_t size) {
+    if (memory_source == crossbow::allocator::backend::slab && size <= crossbow::slab_allocator::max_size) {
+        auto res = crossbow::slab_allocator::allocate(size);
+        return (res ? reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(res) | SLAB_TAG) : nullptr);
+    }
+    return ::malloc(size);
+}
+
+void releaseMemory(void* ptr) {
+    auto p = reinterpret_cast<uintptr_t>(ptr);
+    if (p & SLAB_TAG) {
+        crossbow::slab_allocator::deallocate(reinterpret_cast<void*>(p & ~SLAB_TAG));
+    } else {
+        ::free(ptr);
+    }
+}
+
+size_t usableSize(void* ptr) {
+    auto p = reinterpret_cast<uintptr_t>(ptr);
+    if (p & SLAB_TAG) {
+        return crossbow::slab_allocator::usable_size(reinterpret_cast<void*>(p & ~SLAB_TAG));
+    }
+#ifdef __GLIBC__
+    return malloc_usable_size(ptr);
+#else
+    return 0;
+#endif
+}
+
+int64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+alignas(crossbow::cache_line_size) std::atomic<uint64_t> retired_objects(0);
+std::atomic<uint64_t> retired_bytes(0);
+alignas(crossbow::cache_line_size) std::atomic<uint64_t> reclaimed_objects(0);
+std::atomic<uint64_t> reclaimed_bytes(0);
+
+/**
+ * @brief Bytes retired but not reclaimed yet
+ *
+ * The reclaimed bytes have to be loaded before the retired bytes. Objects retired in the meantime can still be
+ * reclaimed before the retired bytes are loaded, the difference is therefore clamped instead of wrapping around.
+ */
+uint64_t pendingBytes(uint64_t retired, uint64_t reclaimed) {
+    return retired - std::min(retired, reclaimed);
+}
+
+/// Start time of epoch e is stored in epoch_started[e % 4]
+std::array<std::atomic<int64_t>, 4> epoch_started;
+
+std::atomic<size_t> pending_threshold(0);
+std::atomic<bool> pending_armed(true);
+std::mutex pending_mutex;
+std::function<void(const crossbow::allocator::stats&)> pending_callback;
+
+void invokeFunction(void* arg) {
+    auto fun = static_cast<std::function<void()>*>(arg);
+    (*fun)();
+    delete fun;
+}
+
 struct lists {
+    /**
+     * @brief Header prepended to every allocation
+     *
+     * The size is kept a multiple of 16 so that allocations keep the alignment guarantee of ::malloc.
+     */
     struct node {
         std::atomic<node*> next;
         void* const ptr;
-        std::function<void()> destruct;
+        crossbow::allocator::destructor destruct;
+        void* arg;
 
         node(void* p)
             : next(reinterpret_cast<node*>(0x1))
             , ptr(p)
+            , destruct(nullptr)
+            , arg(nullptr)
         {
         }
 
         ~node() {
-            destruct();
+            if (destruct) {
+                destruct(arg);
+            }
         }
 
-        bool own(decltype(node::destruct) destruct) {
+        bool own(crossbow::allocator::destructor destruct, void* arg) {
             while (true) {
                 auto n = next.load();
                 if (reinterpret_cast<node*>(0x1) != n) {
@@ -53,96 +153,617 @@ struct lists {
                 }
                 if (next.compare_exchange_strong(n, nullptr)) {
                     this->destruct = destruct;
+                    this->arg = arg;
                     return true;
                 }
             }
         }
+
+        static node* from(void* ptr) {
+            return reinterpret_cast<node*>(reinterpret_cast<uint8_t*>(ptr) - sizeof(node));
+        }
+
+        size_t bytes() const {
+            return usableSize(ptr);
+        }
+
+        /**
+         * @brief Invokes the callback of every node in the chain and releases the memory
+         *
+         * Returns the number of bytes released.
+         */
+        static size_t destruct_chain(node* head) {
+            size_t bytes = 0;
+            while (head) {
+                auto next = head->next.load(std::memory_order_relaxed);
+                auto ptr = head->ptr;
+                bytes += head->bytes();
+                head->~node();
+                releaseMemory(ptr);
+                head = next;
+            }
+            return bytes;
+        }
+
+        /**
+         * @brief Reverses the chain in place and returns the new head
+         */
+        static node* reverse_chain(node* head, node*& tail, size_t& count) {
+            node* res = nullptr;
+            tail = head;
+            while (head) {
+                auto next = head->next.load(std::memory_order_relaxed);
+                head->next.store(res, std::memory_order_relaxed);
+                res = head;
+                head = next;
+                ++count;
+            }
+            return res;
+        }
     };
+    static_assert(sizeof(node) % 16 == 0, "Node header breaks malloc alignment");
 
+    /**
+     * @brief Lock-free list of retired nodes with the most recently retired node at the head
+     */
     struct list {
         list()
-            : head_(reinterpret_cast<node*>(0x0)) {
+            : head_(nullptr) {
         }
 
         ~list() {
-            destruct(head_.load());
-        }
-
-        // TODO change direction of list
-        void destruct(node* node) {
-            if (node == nullptr) return;
-            destruct(node->next);
-            auto ptr = node->ptr;
-            node->~node();
-            ::free(ptr);
+            node* tail;
+            size_t count = 0;
+            node::destruct_chain(node::reverse_chain(head_.load(), tail, count));
         }
 
         std::atomic<node*> head_;
 
-        void append(uint8_t* ptr, decltype(node::destruct) destruct) {
-            ptr -= sizeof(node);
-            auto nd = reinterpret_cast<node*>(ptr);
-            if (!nd->own(destruct)) return;
+        /**
+         * @brief Prepends the chain first to last to the list
+         */
+        void append(node* first, node* last) {
+            auto head = head_.load();
             do {
-                node* head = head_.load();
-                nd->next = head;
-                if (head_.compare_exchange_strong(head, nd)) return;
-            } while (true);
+                last->next.store(head, std::memory_order_relaxed);
+            } while (!head_.compare_exchange_weak(head, first));
         }
     };
 
+    lists()
+        : size_(0) {
+    }
+
     std::array<list, NUM_LISTS> lists_;
 
-    void append(uint8_t* ptr, uint64_t mycnt, decltype(node::destruct) destruct) {
-        lists_[mycnt % NUM_LISTS].append(ptr, destruct);
+    /// Number of nodes in all lists
+    std::atomic<size_t> size_;
+};
+
+/**
+ * @brief Queue of expired nodes waiting to be reclaimed in retirement order
+ *
+ * Nodes are destroyed in bounded chunks so that a single guard never pays for the reclamation of a whole epoch. Only
+ * one thread reclaims at a time, destructors retiring further objects do not recurse into the reclamation.
+ */
+class reclaim_queue {
+public:
+    reclaim_queue()
+        : mHead(nullptr),
+          mTail(nullptr),
+          mSize(0) {
+        mLock.clear();
+        mReclaiming.clear();
+    }
+
+    size_t size() const {
+        return mSize.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Moves all nodes from the expired lists into the queue
+     */
+    void push(lists& expired) {
+        for (auto& l : expired.lists_) {
+            node_type* tail;
+            size_t count = 0;
+            auto head = node_type::reverse_chain(l.head_.exchange(nullptr), tail, count);
+            if (!head) {
+                continue;
+            }
+            expired.size_.fetch_sub(count, std::memory_order_relaxed);
+
+            lock();
+            if (mTail) {
+                mTail->next.store(head, std::memory_order_relaxed);
+            } else {
+                mHead = head;
+            }
+            mTail = tail;
+            mSize.fetch_add(count, std::memory_order_relaxed);
+            unlock();
+        }
+    }
+
+    /**
+     * @brief Reclaims at most max nodes
+     *
+     * Returns immediately when another reclamation is already in progress.
+     */
+    void reclaim(size_t max) {
+        if (mSize.load(std::memory_order_relaxed) == 0 || mReclaiming.test_and_set(std::memory_order_acquire)) {
+            return;
+        }
+        while (max > 0) {
+            size_t count = 0;
+            auto chunk = pop(std::min(max, RECLAIM_CHUNK), count);
+            if (!chunk) {
+                break;
+            }
+            reclaimed_bytes.fetch_add(node_type::destruct_chain(chunk), std::memory_order_relaxed);
+            reclaimed_objects.fetch_add(count, std::memory_order_relaxed);
+            max -= std::min(max, RECLAIM_CHUNK);
+        }
+        mReclaiming.clear(std::memory_order_release);
+
+        auto threshold = pending_threshold.load(std::memory_order_relaxed);
+        if (threshold != 0 && !pending_armed.load(std::memory_order_relaxed)) {
+            auto reclaimed = reclaimed_bytes.load();
+            if (pendingBytes(retired_bytes.load(), reclaimed) < threshold) {
+                pending_armed.store(true);
+            }
+        }
+    }
+
+private:
+    using node_type = lists::node;
+
+    void lock() {
+        while (mLock.test_and_set(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+    }
+
+    void unlock() {
+        mLock.clear(std::memory_order_release);
+    }
+
+    /**
+     * @brief Detaches up to max nodes from the front of the queue
+     */
+    node_type* pop(size_t max, size_t& count) {
+        lock();
+        auto head = mHead;
+        if (!head) {
+            unlock();
+            return nullptr;
+        }
+        auto last = head;
+        count = 1;
+        for (; count < max && last->next.load(std::memory_order_relaxed); ++count) {
+            last = last->next.load(std::memory_order_relaxed);
+        }
+        mHead = last->next.load(std::memory_order_relaxed);
+        if (!mHead) {
+            mTail = nullptr;
+        }
+        last->next.store(nullptr, std::memory_order_relaxed);
+        mSize.fetch_sub(count, std::memory_order_relaxed);
+        unlock();
+        return head;
+    }
+
+    std::atomic_flag mLock;
+    std::atomic_flag mReclaiming;
+    node_type* mHead;
+    node_type* mTail;
+    std::atomic<size_t> mSize;
+};
+
+/**
+ * @brief Optional thread reclaiming expired nodes in the background
+ */
+class reclaimer {
+public:
+    reclaimer(reclaim_queue& queue)
+        : mQueue(queue),
+          mRunning(false) {
+    }
+
+    bool running() const {
+        return mRunning.load(std::memory_order_relaxed);
     }
+
+    void start();
+
+    void stop();
+
+    void notify() {
+        mWait.notify_one();
+    }
+
+private:
+    void run();
+
+    reclaim_queue& mQueue;
+    std::atomic<bool> mRunning;
+    std::mutex mMutex;
+    std::condition_variable mWait;
+    std::thread mThread;
 };
 
-std::atomic<std::atomic<uint64_t>*> active_cnt;
-std::atomic<std::atomic<uint64_t>*> old_cnt;
-std::atomic<std::atomic<uint64_t>*> oldest_cnt;
-std::atomic<lists*> active_list;
-std::atomic<lists*> old_list;
-std::atomic<lists*> oldest_list;
+/**
+ * @brief Epoch announcement of a thread
+ *
+ * Every slot lives on its own cache line and is only written by the thread owning it. Slots are never freed, the slot
+ * of an exited thread is reused by the next thread registering.
+ */
+struct alignas(crossbow::cache_line_size) epoch_slot {
+    epoch_slot()
+        : announce(0),
+          used(true),
+          next(nullptr) {
+    }
+
+    /// (epoch << 1) | 1 while the thread is inside a guard, 0 otherwise
+    std::atomic<uint64_t> announce;
+    std::atomic<bool> used;
+    epoch_slot* next;
+};
+
+/**
+ * @brief State of the calling thread
+ *
+ * Trivially destructible so that guards keep working while the thread local objects are destroyed.
+ */
+struct thread_state {
+    epoch_slot* slot;
+    uint64_t depth;
+
+    /// Epoch (plus one) the scan of the epoch slots was started for
+    uint64_t scanEpoch;
+    epoch_slot* scanPos;
+
+    /// Set once the thread local retire buffer was destroyed, guards entered afterwards release their slot again
+    bool exited;
+};
+
+alignas(crossbow::cache_line_size) std::atomic<uint64_t> global_epoch(0);
+std::atomic<epoch_slot*> epoch_slots(nullptr);
+
+/// Nodes retired in epoch e are appended to epoch_lists[e % 3]
+std::array<lists*, 3> epoch_lists;
+
+thread_local thread_state local_state;
+
+std::atomic<size_t> next_list(0);
+reclaim_queue expired_nodes;
+reclaimer background_reclaimer(expired_nodes);
+
+epoch_slot* acquireSlot() {
+    for (auto slot = epoch_slots.load(); slot; slot = slot->next) {
+        bool used = false;
+        if (!slot->used.load(std::memory_order_relaxed) && slot->used.compare_exchange_strong(used, true)) {
+            return slot;
+        }
+    }
+    // Plain new does not respect the cache line alignment before C++17
+    auto slot = new (::aligned_alloc(crossbow::cache_line_size, sizeof(epoch_slot))) epoch_slot();
+    auto head = epoch_slots.load();
+    do {
+        slot->next = head;
+    } while (!epoch_slots.compare_exchange_weak(head, slot));
+    return slot;
 }
 
-namespace crossbow {
+void registerThread();
+
+void enter() {
+    auto& state = local_state;
+    if (state.depth++ != 0) {
+        return;
+    }
+    if (!state.slot) {
+        state.slot = acquireSlot();
+        if (!state.exited) {
+            registerThread();
+        }
+    }
+    state.slot->announce.store((global_epoch.load(std::memory_order_acquire) << 1) | 0x1u);
+}
 
-void allocator::init() {
-    active_cnt.store(new std::atomic<uint64_t>(1));
-    old_cnt.store(new std::atomic<uint64_t>(0));
-    oldest_cnt.store(new std::atomic<uint64_t>(0));
+/**
+ * @brief Leaves the critical section, returns true if this was the outermost guard of the thread
+ */
+bool leave() {
+    auto& state = local_state;
+    if (--state.depth != 0) {
+        return false;
+    }
+    state.slot->announce.store(0, std::memory_order_release);
+    if (state.exited) {
+        state.slot->used.store(false);
+        state.slot = nullptr;
+    }
+    return true;
+}
 
-    active_list.store(new lists());
-    old_list.store(new lists());
-    oldest_list.store(new lists());
+/**
+ * @brief Tries to advance the global epoch
+ *
+ * The epoch can advance from e to e + 1 once every thread inside a guard announced e. The slots are scanned
+ * incrementally, at most steps slots per call. The thread advancing the epoch moves the nodes retired in e - 1 to the
+ * reclamation queue, none of the threads in e can still reference them.
+ *
+ * Has to be called inside a guard: its announcement keeps the epoch from advancing again before the list is moved,
+ * otherwise nodes retired in e + 2 would be appended to the list while it is moved and reclaimed too early.
+ */
+void advance(thread_state& state, size_t steps) {
+    auto epoch = global_epoch.load();
+    if (state.scanEpoch != epoch + 1) {
+        state.scanEpoch = epoch + 1;
+        state.scanPos = epoch_slots.load();
+    }
+    for (; state.scanPos && steps > 0; --steps) {
+        auto announce = state.scanPos->announce.load();
+        if ((announce & 0x1u) && (announce >> 1) != epoch) {
+            return;
+        }
+        state.scanPos = state.scanPos->next;
+    }
+    if (state.scanPos || !global_epoch.compare_exchange_strong(epoch, epoch + 1)) {
+        return;
+    }
+    epoch_started[(epoch + 1) % epoch_started.size()].store(now(), std::memory_order_relaxed);
+
+    expired_nodes.push(*epoch_lists[(epoch + 2) % 3]);
+    if (background_reclaimer.running()) {
+        background_reclaimer.notify();
+    }
+}
+
+void tryAdvance(thread_state& state, size_t steps) {
+    enter();
+    advance(state, steps);
+    leave();
+}
+
+bool hasRetired() {
+    for (auto l : epoch_lists) {
+        if (l->size_.load(std::memory_order_relaxed) != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Accounts for retired objects and invokes the pending callback when crossing the threshold
+ */
+void retired(size_t count, size_t bytes) {
+    retired_objects.fetch_add(count, std::memory_order_relaxed);
+    auto reclaimed = reclaimed_bytes.load();
+    auto pending = pendingBytes(retired_bytes.fetch_add(bytes) + bytes, reclaimed);
+    auto threshold = pending_threshold.load(std::memory_order_relaxed);
+    if (threshold == 0 || pending <= threshold || !pending_armed.load(std::memory_order_relaxed)
+            || !pending_armed.exchange(false)) {
+        return;
+    }
+    std::function<void(const crossbow::allocator::stats&)> callback;
+    {
+        std::unique_lock<std::mutex> _(pending_mutex);
+        callback = pending_callback;
+    }
+    if (callback) {
+        callback(crossbow::allocator::snapshot());
+    }
+}
+
+/**
+ * @brief Thread local buffer of retired nodes
+ *
+ * Retired nodes are collected in a private chain and appended to one of the shared lists with a single CAS once the
+ * buffer is full or the epoch advanced. Appending to a list of a later epoch than the one active during retirement
+ * only delays the reclamation.
+ */
+class retire_buffer {
+public:
+    retire_buffer()
+        : mIndex(next_list.fetch_add(1) % NUM_LISTS),
+          mHead(nullptr),
+          mTail(nullptr),
+          mCount(0),
+          mBytes(0),
+          mEpoch(0),
+          mExited(false) {
+    }
+
+    /**
+     * @brief Flushes the remaining nodes and releases the epoch slot of the exiting thread
+     *
+     * Destructors of thread local objects running afterwards may still retire objects, they are appended directly and
+     * every guard they enter acquires a slot that is released again when the guard is left.
+     */
+    ~retire_buffer() {
+        flush();
+        mExited = true;
+        auto& state = local_state;
+        state.exited = true;
+        if (state.slot && state.depth == 0) {
+            state.slot->used.store(false);
+            state.slot = nullptr;
+        }
+    }
+
+    bool empty() const {
+        return mHead == nullptr;
+    }
+
+    void push(lists::node* nd) {
+        if (!mHead) {
+            mTail = nd;
+            mEpoch = global_epoch.load(std::memory_order_relaxed);
+        }
+        nd->next.store(mHead, std::memory_order_relaxed);
+        mHead = nd;
+        mBytes += nd->bytes();
+        if (++mCount == RETIRE_BATCH || mExited) {
+            flush();
+            if (!background_reclaimer.running()) {
+                expired_nodes.reclaim(2 * RETIRE_BATCH);
+            }
+        }
+    }
+
+    /**
+     * @brief Flushes the buffer in case the epoch advanced since the first node was buffered
+     */
+    void flush_expired() {
+        if (mHead && mEpoch != global_epoch.load(std::memory_order_relaxed)) {
+            flush();
+        }
+    }
+
+    void flush() {
+        if (!mHead) {
+            return;
+        }
+        enter();
+        auto& l = *epoch_lists[global_epoch.load() % 3];
+        l.size_.fetch_add(mCount, std::memory_order_relaxed);
+        retired(mCount, mBytes);
+        l.lists_[mIndex].append(mHead, mTail);
+        leave();
+        mHead = nullptr;
+        mTail = nullptr;
+        mCount = 0;
+        mBytes = 0;
+    }
+
+private:
+    size_t mIndex;
+    lists::node* mHead;
+    lists::node* mTail;
+    size_t mCount;
+    size_t mBytes;
+    uint64_t mEpoch;
+    bool mExited;
+};
+
+thread_local retire_buffer local_buffer;
+
+void appendInOrder(lists::node* nd) {
+    enter();
+    auto& l = *epoch_lists[global_epoch.load() % 3];
+    l.size_.fetch_add(1, std::memory_order_relaxed);
+    retired(1, nd->bytes());
+    l.lists_[0].append(nd, nd);
+    leave();
+}
+
+void registerThread() {
+    // Constructs the buffer whose destructor releases the slot
+    static_cast<void>(local_buffer.empty());
+}
+
+void reclaimer::start() {
+    if (mRunning.exchange(true)) {
+        return;
+    }
+    mThread = std::thread(&reclaimer::run, this);
+}
+
+void reclaimer::stop() {
+    {
+        std::unique_lock<std::mutex> _(mMutex);
+        if (!mRunning.exchange(false)) {
+            return;
+        }
+    }
+    mWait.notify_one();
+    mThread.join();
+}
+
+void reclaimer::run() {
+    while (running()) {
+        tryAdvance(local_state, std::numeric_limits<size_t>::max());
+        mQueue.reclaim(std::numeric_limits<size_t>::max());
+
+        // Objects retired by destructors are buffered by this thread
+        local_buffer.flush();
+
+        std::unique_lock<std::mutex> lock(mMutex);
+        if (running() && mQueue.size() == 0) {
+            mWait.wait_for(lock, std::chrono::milliseconds(10));
+        }
+    }
+}
+
+class epoch_resource : public crossbow::memory_resource {
+private:
+    virtual void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        auto ptr = (alignment <= alignof(std::max_align_t)
+                ? crossbow::allocator::malloc(bytes)
+                : crossbow::allocator::malloc(bytes, alignment));
+        if (!ptr) {
+            throw std::bad_alloc();
+        }
+        return ptr;
+    }
+
+    virtual void do_deallocate(void* ptr, std::size_t, std::size_t) override {
+        crossbow::allocator::free(ptr);
+    }
+
+    virtual bool do_is_equal(const crossbow::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+}
+
+namespace crossbow {
+
+void allocator::init(backend source) {
+    memory_source = source;
+    epoch_started[0].store(now());
+    for (auto& l : epoch_lists) {
+        l = new lists();
+    }
     atexit(&destroy);
 }
 
 void allocator::destroy() {
-    delete oldest_list.load();
-    delete old_list.load();
-    delete active_list.load();
+    background_reclaimer.stop();
 
-    delete oldest_cnt.load();
-    delete old_cnt.load();
-    delete active_cnt.load();
+    // Reclaim everything oldest first
+    auto epoch = global_epoch.load();
+    for (uint64_t i = 1; i <= 3; ++i) {
+        expired_nodes.push(*epoch_lists[(epoch + i) % 3]);
+    }
+    expired_nodes.reclaim(std::numeric_limits<size_t>::max());
+    for (auto l : epoch_lists) {
+        delete l;
+    }
 }
 
 void* allocator::malloc(std::size_t size) {
-    uint8_t* res = reinterpret_cast<uint8_t*>(::malloc(size + sizeof(lists::node)));
-    if (!res) {
+    auto base = allocateMemory(size + sizeof(lists::node));
+    if (!base) {
         return nullptr;
     }
 
-    new(res) lists::node(res);
+    auto res = reinterpret_cast<uint8_t*>(reinterpret_cast<uintptr_t>(base) & ~SLAB_TAG);
+    new(res) lists::node(base);
     return res + sizeof(lists::node);
 }
 
 void* allocator::malloc(std::size_t size, std::size_t align) {
     size_t nodePadding = ((sizeof(lists::node) % align != 0) ? (align - (sizeof(lists::node) % align)) : 0);
 
-    uint8_t* res = reinterpret_cast<uint8_t*>(::aligned_alloc(align, size + sizeof(lists::node) + nodePadding));
+    // The size passed to aligned_alloc has to be a multiple of the alignment
+    auto total = crossbow::align(size + sizeof(lists::node) + nodePadding, align);
+    uint8_t* res = reinterpret_cast<uint8_t*>(::aligned_alloc(align, total));
     if (!res) {
         return nullptr;
     }
@@ -151,53 +772,125 @@ void* allocator::malloc(std::size_t size, std::size_t align) {
     return res + sizeof(lists::node) + nodePadding;
 }
 
+memory_resource* allocator::resource() {
+    static epoch_resource resource;
+    return &resource;
+}
+
+std::size_t allocator::header_size() {
+    return sizeof(lists::node);
+}
+
+void allocator::free(void* ptr) {
+    allocator::free(ptr, nullptr, nullptr);
+}
+
+void allocator::free_in_order(void* ptr) {
+    allocator::free_in_order(ptr, nullptr, nullptr);
+}
+
+void allocator::free(void* ptr, destructor destruct, void* arg) {
+    auto nd = lists::node::from(ptr);
+    if (nd->own(destruct, arg)) {
+        local_buffer.push(nd);
+    }
+}
+
+void allocator::free_in_order(void* ptr, destructor destruct, void* arg) {
+    auto nd = lists::node::from(ptr);
+    if (nd->own(destruct, arg)) {
+        appendInOrder(nd);
+    }
+}
+
 void allocator::free(void* ptr, std::function<void()> destruct) {
-    unsigned long long int t;
-    __asm__ volatile (".byte 0x0f, 0x31" : "=A" (t));
-    active_list.load()->append(reinterpret_cast<uint8_t*>(ptr), t, destruct);
+    auto nd = lists::node::from(ptr);
+    auto fun = new std::function<void()>(std::move(destruct));
+    if (nd->own(&invokeFunction, fun)) {
+        local_buffer.push(nd);
+    } else {
+        delete fun;
+    }
 }
 
 void allocator::free_in_order(void* ptr, std::function<void()> destruct) {
-    active_list.load()->append(reinterpret_cast<uint8_t*>(ptr), 0, destruct);
+    auto nd = lists::node::from(ptr);
+    auto fun = new std::function<void()>(std::move(destruct));
+    if (nd->own(&invokeFunction, fun)) {
+        appendInOrder(nd);
+    } else {
+        delete fun;
+    }
 }
 
 void allocator::free_now(void* ptr) {
-    uint8_t* res = reinterpret_cast<uint8_t*>(ptr);
-    res -= sizeof(lists::node);
-    auto nd = reinterpret_cast<lists::node*>(res);
-    ::free(nd->ptr);
+    releaseMemory(lists::node::from(ptr)->ptr);
 }
 
-allocator::allocator() {
-    do {
-        cnt_ = active_cnt.load();
-        auto my_cnt_ = cnt_->load();
-        if (my_cnt_ % 2 && cnt_->compare_exchange_strong(my_cnt_, my_cnt_ + 2)) {
-            return;
+allocator::stats allocator::snapshot() {
+    stats res;
+    auto time = now();
+    res.epoch = global_epoch.load();
+    res.since_advance = std::chrono::nanoseconds(time - epoch_started[res.epoch % epoch_started.size()].load());
+    res.reclaimed_objects = reclaimed_objects.load();
+    res.reclaimed_bytes = reclaimed_bytes.load();
+    res.retired_objects = retired_objects.load();
+    res.retired_bytes = retired_bytes.load();
+    res.pending_bytes = pendingBytes(res.retired_bytes, res.reclaimed_bytes);
+    for (uint64_t i = 0; i < res.pending_objects.size(); ++i) {
+        res.pending_objects[i] = epoch_lists[(res.epoch + 3 - i) % 3]->size_.load();
+    }
+    res.expired_objects = expired_nodes.size();
+
+    res.active_guards = 0;
+    auto oldest = res.epoch;
+    for (auto slot = epoch_slots.load(); slot; slot = slot->next) {
+        auto announce = slot->announce.load();
+        if (announce & 0x1u) {
+            ++res.active_guards;
+            oldest = std::min(oldest, announce >> 1);
         }
-    } while (true);
+    }
+    if (res.active_guards == 0) {
+        res.oldest_guard_age = std::chrono::nanoseconds(0);
+    } else {
+        // Guards cannot lag more than two epochs behind
+        oldest = std::max(oldest, res.epoch - std::min<uint64_t>(res.epoch, epoch_started.size() - 1));
+        res.oldest_guard_age = std::chrono::nanoseconds(time - epoch_started[oldest % epoch_started.size()].load());
+    }
+    return res;
+}
+
+void allocator::set_pending_callback(std::size_t threshold, std::function<void(const stats&)> callback) {
+    std::unique_lock<std::mutex> _(pending_mutex);
+    pending_callback = std::move(callback);
+    pending_armed.store(true);
+    pending_threshold.store(threshold);
+}
+
+void allocator::start_reclaimer() {
+    background_reclaimer.start();
+}
+
+void allocator::stop_reclaimer() {
+    background_reclaimer.stop();
+}
+
+allocator::allocator() {
+    enter();
 }
 
 allocator::~allocator() {
-    cnt_->fetch_sub(2);
-    auto& oldcnt = *(old_cnt.load());
-    auto& oldestcnt = *(oldest_cnt.load());
-    auto& ac = *(active_cnt.load());
-    uint64_t oac = ac.load();
-    if (oldestcnt.load() == 0 && oldcnt.load() == 0 && oac % 2 == 1) {
-        if (!ac.compare_exchange_strong(oac, oac - 1)) {
-            return;
-        }
-        auto activecnt = active_cnt.load();
-        active_cnt.store(oldest_cnt.load());
-        oldest_cnt.store(old_cnt.load());
-        old_cnt.store(activecnt);
-        auto todelete = oldest_list.load();
-        oldest_list.store(old_list.load());
-        old_list.store(active_list.load());
-        active_list.store(new lists());
-        active_cnt.load()->fetch_add(1);
-        delete todelete;
+    local_buffer.flush_expired();
+    if (!leave()) {
+        return;
+    }
+
+    if (!local_buffer.empty() || hasRetired()) {
+        tryAdvance(local_state, SCAN_STEP);
+    }
+    if (!background_reclaimer.running()) {
+        expired_nodes.reclaim(RECLAIM_CHUNK);
     }
 }
 
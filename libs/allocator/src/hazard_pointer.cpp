@@ -0,0 +1,268 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/hazard_pointer.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+namespace crossbow {
+namespace impl {
+
+/**
+ * @brief Batch of retired objects
+ */
+struct retired_block {
+    static constexpr size_t capacity = 64;
+
+    struct entry {
+        void* ptr;
+        hazard_domain::deleter del;
+    };
+
+    retired_block()
+        : next(nullptr),
+          size(0) {
+    }
+
+    retired_block* next;
+    size_t size;
+    entry entries[capacity];
+};
+
+} // namespace impl
+
+namespace {
+
+/**
+ * @brief Thread local buffer collecting the objects retired into one domain
+ *
+ * Retiring into another domain hands the buffered objects to the previous domain first.
+ */
+class hazard_buffer {
+public:
+    hazard_buffer()
+        : mDomain(nullptr),
+          mBlock(nullptr) {
+    }
+
+    ~hazard_buffer() {
+        flush();
+    }
+
+    hazard_domain* domain() const {
+        return mDomain;
+    }
+
+    /**
+     * @brief Buffers the object, returns a full block the caller has to hand to the domain
+     */
+    impl::retired_block* push(hazard_domain& domain, void* ptr, hazard_domain::deleter del) {
+        if (mDomain != &domain) {
+            flush();
+            mDomain = &domain;
+        }
+        if (!mBlock) {
+            mBlock = new impl::retired_block();
+        }
+        mBlock->entries[mBlock->size++] = impl::retired_block::entry{ptr, del};
+        if (mBlock->size < impl::retired_block::capacity) {
+            return nullptr;
+        }
+        auto block = mBlock;
+        mBlock = nullptr;
+        return block;
+    }
+
+    impl::retired_block* take() {
+        auto block = mBlock;
+        mBlock = nullptr;
+        return block;
+    }
+
+    void flush() {
+        if (mBlock) {
+            mDomain->scan();
+        }
+    }
+
+private:
+    hazard_domain* mDomain;
+    impl::retired_block* mBlock;
+};
+
+thread_local hazard_buffer tBuffer;
+
+} // anonymous namespace
+
+constexpr std::size_t hazard_domain::default_threshold;
+
+hazard_domain& hazard_domain::global() {
+    static hazard_domain instance;
+    return instance;
+}
+
+hazard_domain::hazard_domain(std::size_t threshold)
+    : mThreshold(threshold),
+      mRecords(nullptr),
+      mRetired(nullptr),
+      mPending(0) {
+}
+
+hazard_domain::~hazard_domain() {
+    if (tBuffer.domain() == this) {
+        if (auto block = tBuffer.take()) {
+            block->next = mRetired.load();
+            mRetired.store(block);
+        }
+    }
+
+    auto block = mRetired.exchange(nullptr);
+    while (block) {
+        for (size_t i = 0; i < block->size; ++i) {
+            block->entries[i].del(block->entries[i].ptr);
+        }
+        auto next = block->next;
+        delete block;
+        block = next;
+    }
+
+    auto record = mRecords.exchange(nullptr);
+    while (record) {
+        auto next = record->next;
+        record->~hazard_record();
+        ::free(record);
+        record = next;
+    }
+}
+
+void hazard_domain::retire(void* ptr, deleter del) {
+    if (auto block = tBuffer.push(*this, ptr, del)) {
+        push(block);
+    }
+}
+
+void hazard_domain::scan() {
+    if (tBuffer.domain() == this) {
+        if (auto block = tBuffer.take()) {
+            link(block);
+        }
+    }
+    reclaim();
+}
+
+impl::hazard_record* hazard_domain::acquire() {
+    for (auto record = mRecords.load(); record; record = record->next) {
+        bool used = false;
+        if (!record->used.load(std::memory_order_relaxed) && record->used.compare_exchange_strong(used, true)) {
+            return record;
+        }
+    }
+
+    // Plain new does not respect the cache line alignment before C++17
+    auto record = new (::aligned_alloc(alignof(impl::hazard_record), sizeof(impl::hazard_record)))
+            impl::hazard_record();
+    auto head = mRecords.load();
+    do {
+        record->next = head;
+    } while (!mRecords.compare_exchange_weak(head, record));
+    return record;
+}
+
+void hazard_domain::release(impl::hazard_record* record) {
+    record->hazard.store(nullptr, std::memory_order_release);
+    record->used.store(false, std::memory_order_release);
+}
+
+void hazard_domain::push(impl::retired_block* block) {
+    if (link(block) >= mThreshold) {
+        reclaim();
+    }
+}
+
+std::size_t hazard_domain::link(impl::retired_block* block) {
+    auto pending = mPending.fetch_add(block->size) + block->size;
+    auto head = mRetired.load();
+    do {
+        block->next = head;
+    } while (!mRetired.compare_exchange_weak(head, block));
+    return pending;
+}
+
+void hazard_domain::reclaim() {
+    // Concurrent scans work on disjoint sets of retired objects
+    auto block = mRetired.exchange(nullptr);
+    if (!block) {
+        return;
+    }
+
+    // Pairs with the store in hazard_pointer::protect: Either the reader sees the object unlinked or we see its hazard
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::vector<const void*> hazards;
+    for (auto record = mRecords.load(); record; record = record->next) {
+        if (auto hazard = record->hazard.load()) {
+            hazards.push_back(hazard);
+        }
+    }
+    std::sort(hazards.begin(), hazards.end());
+
+    size_t reclaimed = 0;
+    impl::retired_block* first = nullptr;
+    impl::retired_block* last = nullptr;
+    while (block) {
+        auto next = block->next;
+        size_t kept = 0;
+        for (size_t i = 0; i < block->size; ++i) {
+            auto& entry = block->entries[i];
+            if (std::binary_search(hazards.begin(), hazards.end(), entry.ptr)) {
+                block->entries[kept++] = entry;
+            } else {
+                entry.del(entry.ptr);
+                ++reclaimed;
+            }
+        }
+        block->size = kept;
+        if (kept == 0) {
+            delete block;
+        } else {
+            block->next = first;
+            first = block;
+            if (!last) {
+                last = block;
+            }
+        }
+        block = next;
+    }
+
+    // Protected objects are checked again by the next scan
+    if (first) {
+        auto head = mRetired.load();
+        do {
+            last->next = head;
+        } while (!mRetired.compare_exchange_weak(head, first));
+    }
+    mPending.fetch_sub(reclaimed);
+}
+
+} // namespace crossbow
@@ -0,0 +1,173 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/memory_policy.hpp>
+
+#include <crossbow/alignment.hpp>
+
+#include <cerrno>
+#include <cstdint>
+#include <system_error>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+namespace crossbow {
+namespace {
+
+constexpr std::size_t STANDARD_PAGE = 4096;
+constexpr std::size_t HUGE_PAGE_2M = 2 * 1024 * 1024;
+constexpr std::size_t HUGE_PAGE_1G = 1024 * 1024 * 1024;
+
+/// Mode passed to mbind, see numaif.h
+constexpr int BIND_MODE = 2;
+
+std::size_t pageBytes(memory_policy::page_size pages) {
+    switch (pages) {
+    case memory_policy::page_size::huge_2m:
+        return HUGE_PAGE_2M;
+    case memory_policy::page_size::huge_1g:
+        return HUGE_PAGE_1G;
+    default:
+        return STANDARD_PAGE;
+    }
+}
+
+void* mapPages(std::size_t length, memory_policy::page_size pages) {
+    auto flags = MAP_ANONYMOUS | MAP_PRIVATE;
+#if defined(MAP_HUGETLB) && defined(MAP_HUGE_SHIFT)
+    // The logarithm of the huge page size is encoded in the flags
+    if (pages == memory_policy::page_size::huge_2m) {
+        flags |= MAP_HUGETLB | (21 << MAP_HUGE_SHIFT);
+    } else if (pages == memory_policy::page_size::huge_1g) {
+        flags |= MAP_HUGETLB | (30 << MAP_HUGE_SHIFT);
+    }
+#else
+    if (pages != memory_policy::page_size::standard) {
+        return MAP_FAILED;
+    }
+#endif
+    return mmap(nullptr, length, PROT_READ | PROT_WRITE, flags, -1, 0);
+}
+
+/**
+ * @brief Maps standard pages aligned to 2 MiB so transparent huge pages can back the whole block
+ */
+void* mapTransparent(std::size_t length) {
+    auto data = mapPages(length + HUGE_PAGE_2M, memory_policy::page_size::standard);
+    if (data == MAP_FAILED) {
+        return data;
+    }
+    auto begin = reinterpret_cast<uintptr_t>(data);
+    auto aligned = crossbow::align(begin, HUGE_PAGE_2M);
+    if (aligned != begin) {
+        munmap(data, aligned - begin);
+    }
+    munmap(reinterpret_cast<void*>(aligned + length), begin + HUGE_PAGE_2M - aligned);
+#ifdef MADV_HUGEPAGE
+    madvise(reinterpret_cast<void*>(aligned), length, MADV_HUGEPAGE);
+#endif
+    return reinterpret_cast<void*>(aligned);
+}
+
+void bindNode(void* ptr, std::size_t length, int node) {
+#ifdef __linux__
+    constexpr std::size_t maskBits = 8 * sizeof(unsigned long);
+    unsigned long mask[4] = {};
+    if (node < 0 || static_cast<std::size_t>(node) >= 4 * maskBits) {
+        throw std::system_error(EINVAL, std::generic_category());
+    }
+    mask[node / maskBits] = 1ul << (node % maskBits);
+    // Kernels built without NUMA support do not implement mbind, all memory is local there
+    if (syscall(SYS_mbind, ptr, length, BIND_MODE, mask, 4 * maskBits, 0) != 0 && errno != ENOSYS) {
+        throw std::system_error(errno, std::generic_category());
+    }
+#endif
+}
+
+} // anonymous namespace
+
+std::size_t memory_policy::block_size(std::size_t length) const {
+    if (pages == page_size::heap) {
+        return length;
+    }
+    return crossbow::align(length, pageBytes(pages));
+}
+
+void* memory_policy::allocate(std::size_t length, page_size* used) const {
+    if (pages == page_size::heap) {
+        if (used) {
+            *used = page_size::heap;
+        }
+        return new char[length];
+    }
+
+    length = block_size(length);
+    auto actual = pages;
+    auto data = mapPages(length, actual);
+    while (data == MAP_FAILED && actual != page_size::standard) {
+        actual = static_cast<page_size>(static_cast<int>(actual) - 1);
+        data = (actual == page_size::standard ? mapTransparent(length) : mapPages(length, actual));
+    }
+    if (data == MAP_FAILED) {
+        throw std::system_error(errno, std::generic_category());
+    }
+
+    if (numa_node >= 0) {
+        try {
+            bindNode(data, length, numa_node);
+        } catch (...) {
+            munmap(data, length);
+            throw;
+        }
+    }
+
+    if (prefault) {
+        auto page = pageBytes(actual);
+        auto p = static_cast<volatile char*>(data);
+        for (std::size_t i = 0; i < length; i += page) {
+            p[i] = 0;
+        }
+    }
+
+    if (used) {
+        *used = actual;
+    }
+    return data;
+}
+
+std::error_code memory_policy::deallocate(void* ptr, std::size_t length) const {
+    if (pages == page_size::heap) {
+        delete[] static_cast<char*>(ptr);
+        return std::error_code();
+    }
+    if (munmap(ptr, block_size(length))) {
+        return std::error_code(errno, std::generic_category());
+    }
+    return std::error_code();
+}
+
+} // namespace crossbow
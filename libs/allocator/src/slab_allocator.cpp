@@ -0,0 +1,328 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/slab_allocator.hpp>
+
+#include <crossbow/adaptive_mutex.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace crossbow {
+namespace {
+
+constexpr size_t NUM_ARENAS = 8;
+
+/// Number of blocks moved between a thread cache and an arena at once
+constexpr size_t TRANSFER_BATCH = 32;
+
+struct block {
+    block* next;
+};
+
+/**
+ * @brief Header at the beginning of every slab
+ */
+struct alignas(64) slab_header {
+    uint32_t sizeClass;
+    uint32_t arena;
+};
+
+size_t classIndex(size_t size) {
+    if (size <= 128) {
+        return (size == 0 ? 0 : (size + 15) / 16 - 1);
+    }
+    // Four classes per power of two
+    size_t s = size - 1;
+    size_t msb = 63 - __builtin_clzll(s);
+    return 8 + (msb - 7) * 4 + ((s >> (msb - 2)) & 3);
+}
+
+size_t classSize(size_t index) {
+    if (index < 8) {
+        return (index + 1) * 16;
+    }
+    auto d = (index - 8) / 4;
+    auto m = (index - 8) % 4;
+    return (size_t(128) << d) + (m + 1) * (size_t(32) << d);
+}
+
+slab_header* slabOf(void* ptr) {
+    return reinterpret_cast<slab_header*>(reinterpret_cast<uintptr_t>(ptr) & ~(slab_allocator::slab_size - 1));
+}
+
+std::atomic<size_t> gReserved(0);
+
+/**
+ * @brief Shared pool of blocks for all threads running on one NUMA node
+ */
+class arena {
+public:
+    arena()
+        : mIndex(0) {
+        for (auto& c : mClasses) {
+            c.free = nullptr;
+            c.cursor = nullptr;
+            c.end = nullptr;
+        }
+    }
+
+    void init(uint32_t index) {
+        mIndex = index;
+    }
+
+    /**
+     * @brief Takes up to max blocks of the size class, carving a new slab if required
+     */
+    block* take(size_t index, size_t max, size_t& count) {
+        std::unique_lock<adaptive_mutex<>> _(mMutex);
+        auto& c = mClasses[index];
+        block* head = nullptr;
+        count = 0;
+        while (count < max && c.free) {
+            auto b = c.free;
+            c.free = b->next;
+            b->next = head;
+            head = b;
+            ++count;
+        }
+
+        auto size = classSize(index);
+        while (count < max) {
+            if (c.cursor + size > c.end) {
+                if (!newSlab(index)) {
+                    break;
+                }
+            }
+            auto b = reinterpret_cast<block*>(c.cursor);
+            c.cursor += size;
+            b->next = head;
+            head = b;
+            ++count;
+        }
+        return head;
+    }
+
+    /**
+     * @brief Returns the chain first to last to the free list of the size class
+     */
+    void put(size_t index, block* first, block* last) {
+        std::unique_lock<adaptive_mutex<>> _(mMutex);
+        auto& c = mClasses[index];
+        last->next = c.free;
+        c.free = first;
+    }
+
+private:
+    bool newSlab(size_t index) {
+        auto slab = reinterpret_cast<char*>(::aligned_alloc(slab_allocator::slab_size, slab_allocator::slab_size));
+        if (!slab) {
+            return false;
+        }
+        gReserved.fetch_add(slab_allocator::slab_size, std::memory_order_relaxed);
+        auto header = new (slab) slab_header();
+        header->sizeClass = static_cast<uint32_t>(index);
+        header->arena = mIndex;
+        mClasses[index].cursor = slab + sizeof(slab_header);
+        mClasses[index].end = slab + slab_allocator::slab_size;
+        return true;
+    }
+
+    struct size_class {
+        block* free;
+        char* cursor;
+        char* end;
+    };
+
+    adaptive_mutex<> mMutex;
+    uint32_t mIndex;
+    std::array<size_class, slab_allocator::num_classes> mClasses;
+};
+
+std::array<arena, NUM_ARENAS>& arenas() {
+    static std::array<arena, NUM_ARENAS>* instance = []() {
+        auto res = new std::array<arena, NUM_ARENAS>();
+        for (uint32_t i = 0; i < NUM_ARENAS; ++i) {
+            (*res)[i].init(i);
+        }
+        return res;
+    }();
+    return *instance;
+}
+
+uint32_t currentNode() {
+#ifdef __linux__
+    unsigned cpu = 0;
+    unsigned node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) {
+        return node % NUM_ARENAS;
+    }
+#endif
+    return 0;
+}
+
+/**
+ * @brief Per thread free lists
+ *
+ * Trivially destructible so that it stays usable while other thread local objects are destroyed, the thread_cleanup
+ * object returns the cached blocks when the thread exits.
+ */
+struct thread_cache {
+    struct free_list {
+        block* head;
+        size_t count;
+    };
+
+    arena* home;
+    bool exited;
+    free_list lists[slab_allocator::num_classes];
+};
+
+thread_local thread_cache tCache;
+
+struct thread_cleanup {
+    ~thread_cleanup() {
+        for (size_t i = 0; i < slab_allocator::num_classes; ++i) {
+            auto& list = tCache.lists[i];
+            while (list.head) {
+                auto b = list.head;
+                list.head = b->next;
+                b->next = nullptr;
+                arenas()[slabOf(b)->arena].put(i, b, b);
+            }
+            list.count = 0;
+        }
+        tCache.exited = true;
+    }
+};
+
+thread_local thread_cleanup tCleanup;
+
+arena& homeArena() {
+    if (!tCache.home) {
+        tCache.home = &arenas()[currentNode()];
+        // Registers the destructor returning the cached blocks
+        static_cast<void>(&tCleanup);
+    }
+    return *tCache.home;
+}
+
+/**
+ * @brief Returns the oldest TRANSFER_BATCH blocks of the list to the arenas owning them
+ */
+void release(size_t index, thread_cache::free_list& list) {
+    std::array<block*, NUM_ARENAS> first;
+    std::array<block*, NUM_ARENAS> last;
+    first.fill(nullptr);
+    last.fill(nullptr);
+
+    // Keep the most recently freed blocks in the cache
+    auto keep = list.head;
+    for (size_t i = 1; i < list.count - TRANSFER_BATCH; ++i) {
+        keep = keep->next;
+    }
+    auto b = keep->next;
+    keep->next = nullptr;
+    list.count -= TRANSFER_BATCH;
+
+    while (b) {
+        auto next = b->next;
+        auto a = slabOf(b)->arena;
+        b->next = first[a];
+        first[a] = b;
+        if (!last[a]) {
+            last[a] = b;
+        }
+        b = next;
+    }
+    for (size_t a = 0; a < NUM_ARENAS; ++a) {
+        if (first[a]) {
+            arenas()[a].put(index, first[a], last[a]);
+        }
+    }
+}
+
+} // anonymous namespace
+
+constexpr std::size_t slab_allocator::slab_size;
+constexpr std::size_t slab_allocator::max_size;
+constexpr std::size_t slab_allocator::num_classes;
+
+void* slab_allocator::allocate(std::size_t size) {
+    auto index = classIndex(size);
+    if (tCache.exited) {
+        size_t count;
+        return arenas()[currentNode()].take(index, 1, count);
+    }
+
+    auto& list = tCache.lists[index];
+    if (!list.head) {
+        list.head = homeArena().take(index, TRANSFER_BATCH, list.count);
+        if (!list.head) {
+            return nullptr;
+        }
+    }
+    auto b = list.head;
+    list.head = b->next;
+    --list.count;
+    return b;
+}
+
+void slab_allocator::deallocate(void* ptr) {
+    auto b = reinterpret_cast<block*>(ptr);
+    auto index = slabOf(ptr)->sizeClass;
+    if (tCache.exited) {
+        b->next = nullptr;
+        arenas()[slabOf(ptr)->arena].put(index, b, b);
+        return;
+    }
+
+    homeArena();
+    auto& list = tCache.lists[index];
+    b->next = list.head;
+    list.head = b;
+    if (++list.count > 2 * TRANSFER_BATCH) {
+        release(index, list);
+    }
+}
+
+std::size_t slab_allocator::block_size(std::size_t size) {
+    return classSize(classIndex(size));
+}
+
+std::size_t slab_allocator::usable_size(void* ptr) {
+    return classSize(slabOf(ptr)->sizeClass);
+}
+
+std::size_t slab_allocator::reserved() {
+    return gReserved.load(std::memory_order_relaxed);
+}
+
+} // namespace crossbow
@@ -22,8 +22,8 @@
  */
 #pragma once
 
+#include <crossbow/mpsc_queue.hpp>
 #include <crossbow/non_copyable.hpp>
-#include <crossbow/singleconsumerqueue.hpp>
 
 #include <atomic>
 #include <cstddef>
@@ -148,9 +148,7 @@ public:
     /**
      * @brief Enqueues the given function into the task queue
      *
-     * Can only be called from outside the current event processor. In case the task queue reached maximum capacity the
-     * call blocks until a free slot opens up in the task queue (this can lead to a deadlock if the queue is full and
-     * execute is called from within the event processor).
+     * Can only be called from outside the current event processor. The task queue is unbounded, the call never blocks.
      *
      * @param fun The function to execute in the poll thread
      */
@@ -166,7 +164,7 @@ private:
     EventProcessor& mProcessor;
 
     /// Queue containing function objects to be executed by the poll thread
-    crossbow::SingleConsumerQueue<std::function<void()>, 256> mTaskQueue;
+    crossbow::mpsc_queue<std::function<void()>> mTaskQueue;
 
     /// Eventfd triggered when the event processor is sleeping and another thread enqueues a task to the queue
     int mInterrupt;
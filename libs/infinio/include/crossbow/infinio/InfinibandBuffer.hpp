@@ -22,6 +22,7 @@
  */
 #pragma once
 
+#include <crossbow/memory_policy.hpp>
 #include <crossbow/non_copyable.hpp>
 
 #include <cstddef>
@@ -231,10 +232,12 @@ public:
      * @param domain The protection domain to register this region with
      * @param length The length of the memory region
      * @param access Access flags for the Infiniband Adapter
+     * @param policy Page size, NUMA node and prefaulting of the memory, the length is rounded up to the page size
      *
      * @exception std::system_error In case mapping the memory or allocating the region failed
      */
-    AllocatedMemoryRegion(const ProtectionDomain& domain, size_t length, int access);
+    AllocatedMemoryRegion(const ProtectionDomain& domain, size_t length, int access,
+            const memory_policy& policy = memory_policy(memory_policy::page_size::standard));
 
     /**
      * @brief Releases the memory region
@@ -242,7 +245,8 @@ public:
     ~AllocatedMemoryRegion();
 
     AllocatedMemoryRegion(AllocatedMemoryRegion&& other)
-            : mRegion(std::move(other.mRegion)) {
+            : mPolicy(other.mPolicy),
+              mRegion(std::move(other.mRegion)) {
     }
 
     AllocatedMemoryRegion& operator=(AllocatedMemoryRegion&& other);
@@ -276,8 +280,10 @@ public:
     }
 
 private:
-    static void* allocateMemory(size_t length);
+    static LocalMemoryRegion allocateRegion(const ProtectionDomain& domain, size_t length, int access,
+            const memory_policy& policy);
 
+    memory_policy mPolicy = memory_policy(memory_policy::page_size::standard);
     LocalMemoryRegion mRegion;
 };
 
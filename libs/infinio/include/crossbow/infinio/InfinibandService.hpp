@@ -45,6 +45,15 @@ public:
 
     ~InfinibandProcessor();
 
+    /**
+     * @brief Allocates the processor aligned to cache lines
+     *
+     * The task queues are cache line aligned but operator new ignores extended alignment before C++17.
+     */
+    static void* operator new(size_t size);
+
+    static void operator delete(void* ptr);
+
     std::thread::id threadId() const {
         return mProcessor.threadId();
     }
@@ -152,7 +161,8 @@ public:
 
     LocalMemoryRegion registerMemoryRegion(void* data, size_t length, int access);
 
-    AllocatedMemoryRegion allocateMemoryRegion(size_t length, int access);
+    AllocatedMemoryRegion allocateMemoryRegion(size_t length, int access,
+            const memory_policy& policy = memory_policy(memory_policy::page_size::standard));
 
 private:
     friend class InfinibandSocketImpl;
@@ -448,8 +448,9 @@ public:
         return LocalMemoryRegion(mProtectionDomain, data, length, access);
     }
 
-    AllocatedMemoryRegion allocateMemoryRegion(size_t length, int access) {
-        return AllocatedMemoryRegion(mProtectionDomain, length, access);
+    AllocatedMemoryRegion allocateMemoryRegion(size_t length, int access,
+            const memory_policy& policy = memory_policy(memory_policy::page_size::standard)) {
+        return AllocatedMemoryRegion(mProtectionDomain, length, access, policy);
     }
 
     CompletionChannel createCompletionChannel() {
@@ -25,6 +25,7 @@
 #include <crossbow/logger.hpp>
 
 #include <algorithm>
+#include <array>
 #include <cerrno>
 
 #include <sys/epoll.h>
@@ -151,7 +152,7 @@ TaskQueue::~TaskQueue() {
 }
 
 void TaskQueue::execute(std::function<void()> fun) {
-    mTaskQueue.write(std::move(fun));
+    mTaskQueue.emplace(std::move(fun));
     if (mSleeping.load()) {
         uint64_t counter = 0x1u;
         write(mInterrupt, &counter, sizeof(uint64_t));
@@ -162,10 +163,13 @@ bool TaskQueue::poll() {
     bool result = false;
 
     // Process all task from the task queue
-    std::function<void()> fun;
-    while (mTaskQueue.read(fun)) {
+    std::array<std::function<void()>, 16> tasks;
+    while (auto count = mTaskQueue.read_bulk(tasks.begin(), tasks.end())) {
         result = true;
-        fun();
+        for (size_t i = 0; i < count; ++i) {
+            tasks[i]();
+            tasks[i] = nullptr;
+        }
     }
 
     return result;
@@ -26,8 +26,6 @@
 
 #include <crossbow/logger.hpp>
 
-#include <sys/mman.h>
-
 namespace crossbow {
 namespace infinio {
 
@@ -99,8 +97,10 @@ void LocalMemoryRegion::deregisterRegion() {
     mDataRegion = nullptr;
 }
 
-AllocatedMemoryRegion::AllocatedMemoryRegion(const ProtectionDomain& domain, size_t length, int access)
-        : mRegion(domain, allocateMemory(length), length, access) {
+AllocatedMemoryRegion::AllocatedMemoryRegion(const ProtectionDomain& domain, size_t length, int access,
+        const memory_policy& policy)
+        : mPolicy(policy),
+          mRegion(allocateRegion(domain, length, access, policy)) {
 }
 
 AllocatedMemoryRegion::~AllocatedMemoryRegion() {
@@ -118,41 +118,46 @@ AllocatedMemoryRegion::~AllocatedMemoryRegion() {
         LOG_ERROR("Failed to deregister memory region [error = %1% %2%]", e.code(), e.what());
     }
 
-    if (munmap(data, length)) {
-        std::error_code ec(errno, std::generic_category());
+    if (auto ec = mPolicy.deallocate(data, length)) {
         LOG_ERROR("Failed to unmap memory region [error = %1% %2%]", ec, ec.message());
     }
 }
 
 AllocatedMemoryRegion& AllocatedMemoryRegion::operator=(AllocatedMemoryRegion&& other) {
     if (!mRegion.valid()) {
+        mPolicy = other.mPolicy;
         mRegion = std::move(other.mRegion);
         return *this;
     }
 
     auto data = reinterpret_cast<void*>(mRegion.address());
     auto length = mRegion.length();
+    auto policy = mPolicy;
 
     // We have to release the memory region with the Infiniband adapter first
+    mPolicy = other.mPolicy;
     mRegion = std::move(other.mRegion);
 
-    if (munmap(data, length)) {
-        throw std::system_error(errno, std::generic_category());
+    if (auto ec = policy.deallocate(data, length)) {
+        throw std::system_error(ec);
     }
 
     return *this;
 }
 
-void* AllocatedMemoryRegion::allocateMemory(size_t length) {
-    // TODO Size might have to be a multiple of the page size
-    auto data = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, 0, 0);
-
-    if (data == MAP_FAILED) {
-        throw std::system_error(errno, std::generic_category());
-    }
+LocalMemoryRegion AllocatedMemoryRegion::allocateRegion(const ProtectionDomain& domain, size_t length, int access,
+        const memory_policy& policy) {
+    // The registered length covers the whole block so it can be handed back to the policy
+    length = policy.block_size(length);
+    auto data = policy.allocate(length);
     LOG_TRACE("Mapped %1% bytes of buffer space", length);
 
-    return data;
+    try {
+        return LocalMemoryRegion(domain, data, length, access);
+    } catch (...) {
+        policy.deallocate(data, length);
+        throw;
+    }
 }
 
 } // namespace infinio
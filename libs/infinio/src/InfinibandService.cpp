@@ -26,6 +26,7 @@
 #include <crossbow/infinio/ErrorCode.hpp>
 #include <crossbow/infinio/Fiber.hpp>
 #include <crossbow/infinio/InfinibandSocket.hpp>
+#include <crossbow/alignment.hpp>
 #include <crossbow/logger.hpp>
 
 #include "AddressHelper.hpp"
@@ -35,6 +36,7 @@
 #include <cerrno>
 #include <chrono>
 #include <cstddef>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 
@@ -112,6 +114,14 @@ InfinibandProcessor::InfinibandProcessor(std::shared_ptr<DeviceContext> device,
 
 InfinibandProcessor::~InfinibandProcessor() = default;
 
+void* InfinibandProcessor::operator new(size_t size) {
+    return crossbow::aligned_allocate(size, alignof(InfinibandProcessor));
+}
+
+void InfinibandProcessor::operator delete(void* ptr) {
+    ::free(ptr);
+}
+
 void InfinibandProcessor::executeLocalFiber(std::function<void (Fiber&)> fun) {
     Fiber* fiber;
     if (mFiberCache.empty()) {
@@ -230,8 +240,9 @@ LocalMemoryRegion InfinibandService::registerMemoryRegion(void* data, size_t len
     return mDevice->registerMemoryRegion(data, length, access);
 }
 
-AllocatedMemoryRegion InfinibandService::allocateMemoryRegion(size_t length, int access) {
-    return mDevice->allocateMemoryRegion(length, access);
+AllocatedMemoryRegion InfinibandService::allocateMemoryRegion(size_t length, int access,
+        const memory_policy& policy) {
+    return mDevice->allocateMemoryRegion(length, access, policy);
 }
 
 void InfinibandService::processEvent(struct rdma_cm_event* event) {
@@ -0,0 +1,105 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/allocator.hpp>
+
+#include "../check.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+
+namespace {
+
+std::atomic<uint64_t> gDestroyed(0);
+
+struct Value {
+    explicit Value(uint64_t d) : data(d) {}
+    ~Value() {
+        ++gDestroyed;
+    }
+
+    uint64_t data;
+};
+
+void releaseGuards(int count) {
+    for (int i = 0; i < count; ++i) {
+        crossbow::allocator _;
+    }
+}
+
+} // anonymous namespace
+
+int main() {
+    crossbow::allocator::init();
+
+    // A guard held by another thread keeps retired objects alive
+    std::atomic<int> state(0);
+    std::thread reader([&state]() {
+        crossbow::allocator _;
+        state = 1;
+        while (state != 2) {
+            std::this_thread::yield();
+        }
+    });
+    while (state != 1) {
+        std::this_thread::yield();
+    }
+    {
+        crossbow::allocator _;
+        crossbow::allocator::destroy(crossbow::allocator::construct<Value>(1));
+    }
+    releaseGuards(1000);
+    CHECK(gDestroyed == 0);
+    state = 2;
+    reader.join();
+    releaseGuards(10);
+    CHECK(gDestroyed == 1);
+
+    // Nested guards only leave the critical section with the outermost guard
+    {
+        crossbow::allocator outer;
+        crossbow::allocator::destroy(crossbow::allocator::construct<Value>(2));
+        {
+            crossbow::allocator inner;
+        }
+        std::thread other([]() {
+            releaseGuards(1000);
+        });
+        other.join();
+        CHECK(gDestroyed == 1);
+    }
+    releaseGuards(10);
+    CHECK(gDestroyed == 2);
+
+    // Threads that exited do not block the epoch
+    for (int i = 0; i < 16; ++i) {
+        std::thread([]() {
+            crossbow::allocator _;
+            crossbow::allocator::destroy(crossbow::allocator::construct<Value>(3));
+        }).join();
+    }
+    releaseGuards(10);
+    CHECK(gDestroyed == 18);
+    return 0;
+}
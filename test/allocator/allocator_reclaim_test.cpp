@@ -0,0 +1,141 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/allocator.hpp>
+
+#include "../check.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::atomic<uint64_t> gDestroyed(0);
+
+struct Value {
+    explicit Value(uint64_t d) : data(d) {}
+    ~Value() {
+        ++gDestroyed;
+    }
+
+    uint64_t data;
+};
+
+/**
+ * @brief Retires an object when the thread exits
+ *
+ * Constructed before the thread first uses the allocator, so it is destroyed after the thread local retire buffer.
+ */
+struct ExitRetirer {
+    ~ExitRetirer() {
+        crossbow::allocator _;
+        crossbow::allocator::destroy(crossbow::allocator::construct<Value>(0));
+    }
+
+    void touch() {
+    }
+};
+
+thread_local ExitRetirer exitRetirer;
+
+/**
+ * @brief Releases guards until all retired objects were reclaimed or the limit is reached
+ */
+bool reclaim(uint64_t expected) {
+    for (int i = 0; i < 100000 && gDestroyed != expected; ++i) {
+        crossbow::allocator _;
+    }
+    return gDestroyed == expected;
+}
+
+} // anonymous namespace
+
+int main() {
+    crossbow::allocator::init();
+
+    // A single epoch with a million retired objects is reclaimed iteratively in chunks
+    constexpr uint64_t numObjects = 1000000;
+    {
+        crossbow::allocator _;
+        for (uint64_t i = 0; i < numObjects; ++i) {
+            crossbow::allocator::destroy(crossbow::allocator::construct<Value>(i));
+        }
+    }
+    CHECK(gDestroyed < numObjects);
+    CHECK(reclaim(numObjects));
+
+    // Objects buffered by a thread are flushed when the thread exits
+    gDestroyed = 0;
+    constexpr uint64_t numThreads = 4;
+    constexpr uint64_t perThread = 1000;
+    std::vector<std::thread> threads;
+    for (uint64_t t = 0; t < numThreads; ++t) {
+        threads.emplace_back([]() {
+            for (uint64_t i = 0; i < perThread; ++i) {
+                crossbow::allocator _;
+                crossbow::allocator::destroy(crossbow::allocator::construct<Value>(i));
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    CHECK(reclaim(numThreads * perThread));
+
+    // Objects retired after the retire buffer of the thread was destroyed are reclaimed as well
+    gDestroyed = 0;
+    threads.clear();
+    for (uint64_t t = 0; t < numThreads; ++t) {
+        threads.emplace_back([]() {
+            exitRetirer.touch();
+            crossbow::allocator _;
+            crossbow::allocator::destroy(crossbow::allocator::construct<Value>(1));
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    CHECK(reclaim(2 * numThreads));
+
+    // The background reclaimer invokes the destructors, guards only advance the epoch
+    gDestroyed = 0;
+    crossbow::allocator::start_reclaimer();
+    {
+        crossbow::allocator _;
+        for (uint64_t i = 0; i < numObjects; ++i) {
+            crossbow::allocator::destroy(crossbow::allocator::construct<Value>(i));
+        }
+    }
+    for (int i = 0; i < 3; ++i) {
+        crossbow::allocator _;
+    }
+    for (int i = 0; i < 1000 && gDestroyed != numObjects; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CHECK(gDestroyed == numObjects);
+    crossbow::allocator::stop_reclaimer();
+    return 0;
+}
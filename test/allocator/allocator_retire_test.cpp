@@ -0,0 +1,94 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/allocator.hpp>
+
+#include "../check.hpp"
+
+#include <cstdint>
+#include <iostream>
+
+namespace {
+
+uint64_t gDestroyed = 0;
+uint64_t gInvoked = 0;
+
+struct Value {
+    explicit Value(uint64_t d) : data(d) {}
+    ~Value() {
+        ++gDestroyed;
+    }
+
+    uint64_t data;
+};
+
+void addInvoked(void* arg) {
+    gInvoked += *static_cast<uint64_t*>(arg);
+}
+
+/**
+ * @brief Rotates the epochs until everything retired so far has been reclaimed
+ */
+void reclaim() {
+    for (int i = 0; i < 3; ++i) {
+        crossbow::allocator _;
+    }
+}
+
+} // anonymous namespace
+
+int main() {
+    crossbow::allocator::init();
+
+    CHECK(crossbow::allocator::header_size() % 16 == 0);
+    CHECK(crossbow::allocator::header_size() < 48);
+
+    uint64_t increment = 2;
+    {
+        crossbow::allocator _;
+        for (uint64_t i = 0; i < 100; ++i) {
+            crossbow::allocator::destroy(crossbow::allocator::construct<Value>(i));
+        }
+        crossbow::allocator::destroy_in_order(crossbow::allocator::construct<Value>(100));
+        crossbow::allocator::invoke(&addInvoked, &increment);
+        crossbow::allocator::invoke([]() {
+            gInvoked += 3;
+        });
+
+        // Retiring a pointer twice must only register the first callback
+        auto ptr = crossbow::allocator::malloc(16);
+        crossbow::allocator::free(ptr, [&increment]() {
+            gInvoked += increment;
+        });
+        crossbow::allocator::free(ptr, []() {
+            gInvoked += 1000;
+        });
+        crossbow::allocator::free(crossbow::allocator::malloc(32));
+
+        CHECK(gDestroyed == 0);
+        CHECK(gInvoked == 0);
+    }
+    reclaim();
+    CHECK(gDestroyed == 101);
+    CHECK(gInvoked == 7);
+    return 0;
+}
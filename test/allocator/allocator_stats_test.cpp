@@ -0,0 +1,158 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/allocator.hpp>
+
+#include "../check.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Value {
+    uint64_t data[6];
+};
+
+void releaseGuards(int count) {
+    for (int i = 0; i < count; ++i) {
+        crossbow::allocator _;
+    }
+}
+
+void retire(uint64_t count) {
+    crossbow::allocator _;
+    for (uint64_t i = 0; i < count; ++i) {
+        crossbow::allocator::destroy(crossbow::allocator::construct<Value>());
+    }
+}
+
+} // anonymous namespace
+
+int main() {
+    crossbow::allocator::init();
+    constexpr uint64_t numObjects = 64 * 100;
+
+    auto stats = crossbow::allocator::snapshot();
+    CHECK(stats.retired_objects == 0 && stats.pending_bytes == 0);
+    CHECK(stats.active_guards == 0);
+
+    retire(numObjects);
+    stats = crossbow::allocator::snapshot();
+    CHECK(stats.retired_objects == numObjects);
+    CHECK(stats.retired_bytes >= numObjects * (sizeof(Value) + crossbow::allocator::header_size()));
+
+    releaseGuards(10);
+    stats = crossbow::allocator::snapshot();
+    CHECK(stats.reclaimed_objects == numObjects);
+    CHECK(stats.reclaimed_bytes == stats.retired_bytes);
+    CHECK(stats.pending_bytes == 0);
+    CHECK(stats.pending_objects[0] + stats.pending_objects[1] + stats.pending_objects[2] + stats.expired_objects == 0);
+    CHECK(stats.epoch > 0);
+
+    // A stalled guard shows up as old guard and makes the pending bytes cross the threshold
+    std::atomic<uint64_t> callbacks(0);
+    std::atomic<uint64_t> reportedBytes(0);
+    crossbow::allocator::set_pending_callback(100 * 1024, [&callbacks, &reportedBytes](
+            const crossbow::allocator::stats& s) {
+        ++callbacks;
+        reportedBytes = s.pending_bytes;
+    });
+
+    std::atomic<int> state(0);
+    std::thread reader([&state]() {
+        crossbow::allocator _;
+        state = 1;
+        while (state != 2) {
+            std::this_thread::yield();
+        }
+    });
+    while (state != 1) {
+        std::this_thread::yield();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    for (int i = 0; i < 10; ++i) {
+        retire(numObjects);
+        releaseGuards(10);
+    }
+    stats = crossbow::allocator::snapshot();
+    CHECK(stats.active_guards == 1);
+    CHECK(stats.oldest_guard_age >= std::chrono::milliseconds(20));
+    CHECK(stats.pending_bytes > 100 * 1024);
+    CHECK(stats.pending_objects[0] + stats.pending_objects[1] + stats.pending_objects[2] + stats.expired_objects
+            == 10 * numObjects);
+    CHECK(callbacks == 1);
+    CHECK(reportedBytes > 100 * 1024);
+
+    // The callback fires again once the pending bytes dropped below the threshold in between
+    state = 2;
+    reader.join();
+    releaseGuards(100);
+    stats = crossbow::allocator::snapshot();
+    CHECK(stats.active_guards == 0);
+    CHECK(stats.pending_bytes == 0);
+    retire(numObjects);
+    CHECK(callbacks == 2);
+
+    // Threads retire and reclaim concurrently around the threshold, the pending bytes must neither wrap around nor
+    // keep the callback from being re-armed
+    releaseGuards(100);
+    constexpr uint64_t numThreads = 4;
+    constexpr uint64_t batch = 64;
+    constexpr uint64_t threshold = 2 * batch * (sizeof(Value) + 16);
+    std::atomic<uint64_t> wrapped(0);
+    crossbow::allocator::set_pending_callback(threshold, [&callbacks, &wrapped](const crossbow::allocator::stats& s) {
+        ++callbacks;
+        if (s.pending_bytes > s.retired_bytes) {
+            ++wrapped;
+        }
+    });
+    crossbow::allocator::start_reclaimer();
+    std::vector<std::thread> threads;
+    for (uint64_t t = 0; t < numThreads; ++t) {
+        threads.emplace_back([]() {
+            for (int i = 0; i < 500; ++i) {
+                retire(batch);
+                releaseGuards(2);
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    crossbow::allocator::stop_reclaimer();
+    releaseGuards(100);
+    stats = crossbow::allocator::snapshot();
+    CHECK(stats.pending_bytes == 0);
+    CHECK(wrapped == 0);
+
+    // The last reclamation re-armed the callback
+    callbacks = 0;
+    retire(4 * batch);
+    CHECK(callbacks == 1);
+    crossbow::allocator::set_pending_callback(0, nullptr);
+    return 0;
+}
@@ -0,0 +1,111 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/allocator.hpp>
+
+#include "../check.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::atomic<uint64_t> gDestroyed(0);
+
+struct Value {
+    explicit Value(uint64_t d) : data(d), check(~d) {}
+    ~Value() {
+        check = data;
+        ++gDestroyed;
+    }
+
+    volatile uint64_t data;
+    volatile uint64_t check;
+};
+
+constexpr size_t numShared = 16;
+std::atomic<Value*> gShared[numShared];
+
+/**
+ * @brief Replaces and reads shared values, returns the number of values found destroyed or reused inside a guard
+ */
+uint64_t work(uint64_t id, uint64_t iterations) {
+    uint64_t errors = 0;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        crossbow::allocator _;
+        auto& shared = gShared[(id + i) % numShared];
+        if (i % 4 == 0) {
+            auto old = shared.exchange(crossbow::allocator::construct<Value>((id << 32) | i));
+            crossbow::allocator::destroy(old);
+            continue;
+        }
+        auto value = shared.load();
+        uint64_t data = value->data;
+        for (int j = 0; j < 16; ++j) {
+            if (value->check != ~data || value->data != data) {
+                ++errors;
+                break;
+            }
+        }
+    }
+    return errors;
+}
+
+} // anonymous namespace
+
+int main() {
+    crossbow::allocator::init();
+    for (auto& shared : gShared) {
+        shared.store(crossbow::allocator::construct<Value>(0));
+    }
+
+    // Several threads retire while the background reclaimer advances the epoch outside of any guard
+    crossbow::allocator::start_reclaimer();
+    constexpr uint64_t numThreads = 8;
+    constexpr uint64_t iterations = 200000;
+    std::atomic<uint64_t> errors(0);
+    std::vector<std::thread> threads;
+    for (uint64_t t = 0; t < numThreads; ++t) {
+        threads.emplace_back([t, &errors]() {
+            errors += work(t + 1, iterations);
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    crossbow::allocator::stop_reclaimer();
+    CHECK(errors == 0);
+
+    for (auto& shared : gShared) {
+        crossbow::allocator _;
+        crossbow::allocator::destroy(shared.exchange(nullptr));
+    }
+    constexpr uint64_t retired = numThreads * (iterations / 4) + numShared;
+    for (int i = 0; i < 100000 && gDestroyed != retired; ++i) {
+        crossbow::allocator _;
+    }
+    CHECK(gDestroyed == retired);
+    return 0;
+}
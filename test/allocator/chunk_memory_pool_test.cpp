@@ -0,0 +1,184 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/ChunkAllocator.hpp>
+
+#include "../check.hpp"
+
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t chunkSize = 4096;
+
+int checkAlignment() {
+    crossbow::ChunkMemoryPool pool(chunkSize);
+    for (std::size_t align = 1; align <= 256; align *= 2) {
+        for (int i = 0; i < 100; ++i) {
+            auto p = reinterpret_cast<uintptr_t>(pool.allocate(3, align));
+            CHECK(p % align == 0);
+        }
+    }
+    auto large = reinterpret_cast<uintptr_t>(pool.allocate(chunkSize, 128));
+    CHECK(large % 128 == 0);
+
+    std::vector<uint64_t, crossbow::ChunkAllocator<uint64_t>> vec{crossbow::ChunkAllocator<uint64_t>(&pool)};
+    for (uint64_t i = 0; i < 1000; ++i) {
+        vec.push_back(i);
+    }
+    CHECK(reinterpret_cast<uintptr_t>(vec.data()) % alignof(uint64_t) == 0);
+    CHECK(vec[999] == 999);
+    return 0;
+}
+
+int checkReset() {
+    crossbow::ChunkCache cache(chunkSize);
+    {
+        crossbow::ChunkMemoryPool pool(cache);
+        CHECK(pool.chunkSize() == chunkSize);
+
+        std::vector<void*> first;
+        for (int i = 0; i < 10; ++i) {
+            first.push_back(pool.allocate(1000));
+        }
+        pool.allocate(3 * chunkSize);
+        auto reserved = pool.reserved();
+        CHECK(reserved == 3 * chunkSize + cache.blockSize(3 * chunkSize));
+
+        // Allocations after a reset reuse the chunks in the same order
+        pool.reset();
+        CHECK(pool.reserved() == 3 * chunkSize);
+        CHECK(cache.cached() == 4 * chunkSize);
+        for (int i = 0; i < 10; ++i) {
+            CHECK(pool.allocate(1000) == first[i]);
+        }
+        pool.allocate(3 * chunkSize);
+        CHECK(cache.cached() == 0);
+
+        pool.reset(1);
+        CHECK(pool.reserved() == chunkSize);
+        CHECK(cache.cached() == 6 * chunkSize);
+    }
+    CHECK(cache.cached() == 7 * chunkSize);
+
+    // A new pool takes its chunks from the cache
+    crossbow::ChunkMemoryPool pool(cache);
+    CHECK(cache.cached() == 6 * chunkSize);
+    return 0;
+}
+
+int checkCapacity() {
+    crossbow::ChunkCache cache(chunkSize, 2 * chunkSize);
+    {
+        crossbow::ChunkMemoryPool pool(cache);
+        for (int i = 0; i < 4; ++i) {
+            pool.allocate(chunkSize);
+        }
+        pool.allocate(1000 * chunkSize);
+    }
+    CHECK(cache.cached() == 2 * chunkSize);
+    return 0;
+}
+
+int checkInlineArena() {
+    crossbow::ChunkCache cache(chunkSize);
+    {
+        crossbow::inline_arena<256> arena(cache);
+        CHECK(arena.reserved() == 0);
+        CHECK(cache.cached() == 0);
+
+        std::vector<uint64_t, crossbow::ChunkAllocator<uint64_t>> vec{crossbow::ChunkAllocator<uint64_t>(&arena)};
+        vec.reserve(16);
+        CHECK(arena.isInline(vec.data()));
+        CHECK(arena.reserved() == 0);
+
+        // Overflow spills into chunks from the cache
+        vec.reserve(400);
+        CHECK(!arena.isInline(vec.data()));
+        CHECK(arena.reserved() == chunkSize);
+        for (uint64_t i = 0; i < 400; ++i) {
+            vec.push_back(i);
+        }
+
+        arena.reset(0);
+        CHECK(arena.reserved() == 0);
+        CHECK(cache.cached() == chunkSize);
+        CHECK(arena.isInline(arena.allocate(8)));
+        CHECK(!arena.isInline(arena.allocate(chunkSize)));
+        CHECK(cache.cached() == 0);
+    }
+    CHECK(cache.cached() == chunkSize);
+    return 0;
+}
+
+int replayRequests() {
+    void* first = nullptr;
+    for (int request = 0; request < 100; ++request) {
+        crossbow::ChunkPoolScope scope;
+        {
+            crossbow::ChunkPoolScope nested;
+            CHECK(&nested.pool() == &scope.pool());
+            nested.pool().allocate(64);
+        }
+        auto p = scope.pool().allocate(64);
+        if (first == nullptr) {
+            first = p;
+        }
+        // Only the outermost scope resets the pool of the thread
+        CHECK(p == first);
+        for (int i = 0; i < 100; ++i) {
+            scope.pool().allocate(64 * 1024);
+        }
+    }
+    return 0;
+}
+
+int checkLocal() {
+    std::vector<std::thread> threads;
+    std::vector<int> results(4, 1);
+    for (std::size_t t = 0; t < results.size(); ++t) {
+        threads.emplace_back([&results, t]() {
+            results[t] = replayRequests();
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    for (auto r : results) {
+        CHECK(r == 0);
+    }
+    return 0;
+}
+
+} // anonymous namespace
+
+int main() {
+    CHECK(checkAlignment() == 0);
+    CHECK(checkReset() == 0);
+    CHECK(checkCapacity() == 0);
+    CHECK(checkInlineArena() == 0);
+    CHECK(checkLocal() == 0);
+    return 0;
+}
@@ -0,0 +1,130 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/allocator.hpp>
+#include <crossbow/hazard_pointer.hpp>
+
+#include "../check.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr uint64_t ALIVE = 0xa11ce;
+
+std::atomic<uint64_t> gDestroyed(0);
+
+struct Value {
+    explicit Value(uint64_t d) : data(d), state(ALIVE) {}
+    ~Value() {
+        state = 0;
+        ++gDestroyed;
+    }
+
+    uint64_t data;
+    uint64_t state;
+};
+
+} // anonymous namespace
+
+int main() {
+    crossbow::allocator::init();
+
+    // A protected object survives scans until the hazard pointer moves on
+    {
+        crossbow::hazard_domain domain(16);
+        std::atomic<Value*> shared(new Value(1));
+        crossbow::hazard_pointer hp(domain);
+        auto value = hp.protect(shared);
+        CHECK(value->data == 1);
+        shared = new Value(2);
+        domain.retire(value);
+        for (uint64_t i = 0; i < 1000; ++i) {
+            domain.retire(new Value(i));
+        }
+        domain.scan();
+        CHECK(value->state == ALIVE);
+        CHECK(domain.pending() == 1);
+        CHECK(gDestroyed == 1000);
+
+        hp.reset();
+        domain.scan();
+        CHECK(domain.pending() == 0);
+        CHECK(gDestroyed == 1001);
+        domain.retire(shared.load());
+    }
+    // Destroying the domain reclaims everything
+    CHECK(gDestroyed == 1002);
+
+    // Readers never see a reclaimed object while writers keep replacing it, also alongside epoch guards
+    gDestroyed = 0;
+    crossbow::hazard_domain domain(128);
+    std::atomic<Value*> shared(new Value(0));
+    std::atomic<bool> stop(false);
+    std::atomic<uint64_t> failures(0);
+    std::atomic<size_t> maxPending(0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([&domain, &shared, &stop, &failures]() {
+            while (!stop) {
+                crossbow::allocator _;
+                crossbow::hazard_pointer hp(domain);
+                auto value = hp.protect(shared);
+                if (value->state != ALIVE) {
+                    ++failures;
+                }
+            }
+        });
+    }
+    constexpr uint64_t numWrites = 100000;
+    for (int i = 0; i < 2; ++i) {
+        threads.emplace_back([&domain, &shared, &maxPending]() {
+            for (uint64_t w = 0; w < numWrites; ++w) {
+                auto old = shared.exchange(new Value(w));
+                domain.retire(old);
+                auto pending = domain.pending();
+                if (pending > maxPending) {
+                    maxPending = pending;
+                }
+            }
+        });
+    }
+    for (size_t i = 4; i < threads.size(); ++i) {
+        threads[i].join();
+    }
+    stop = true;
+    for (size_t i = 0; i < 4; ++i) {
+        threads[i].join();
+    }
+    CHECK(failures == 0);
+
+    // Pending objects are bounded by the threshold, the blocks being scanned and the hazard slots
+    CHECK(maxPending < 128 + 2 * 64 + 8);
+    domain.retire(shared.load());
+    domain.scan();
+    CHECK(domain.pending() == 0);
+    return 0;
+}
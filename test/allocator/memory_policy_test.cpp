@@ -0,0 +1,100 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/memory_policy.hpp>
+#include <crossbow/ChunkAllocator.hpp>
+
+#include "../check.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <system_error>
+
+namespace {
+
+using page_size = crossbow::memory_policy::page_size;
+
+constexpr std::size_t hugePage = 2 * 1024 * 1024;
+
+int checkAllocation(const crossbow::memory_policy& policy, std::size_t length, std::size_t alignment) {
+    CHECK(policy.block_size(length) >= length);
+    CHECK(policy.block_size(length) % alignment == 0);
+
+    page_size used;
+    auto data = static_cast<char*>(policy.allocate(length, &used));
+    CHECK(reinterpret_cast<uintptr_t>(data) % alignment == 0);
+    if (policy.pages == page_size::heap) {
+        CHECK(used == page_size::heap);
+    } else {
+        // Huge pages might not be available, falling back to smaller pages is fine
+        CHECK(used != page_size::heap && used <= policy.pages);
+    }
+    memset(data, 1, policy.block_size(length));
+    CHECK(!policy.deallocate(data, length));
+    return 0;
+}
+
+} // anonymous namespace
+
+int main() {
+    CHECK(crossbow::memory_policy().block_size(1000) == 1000);
+    CHECK(crossbow::memory_policy(page_size::standard).block_size(1000) == 4096);
+    CHECK(crossbow::memory_policy(page_size::huge_2m).block_size(hugePage + 1) == 2 * hugePage);
+
+    CHECK(checkAllocation(crossbow::memory_policy(), 1000, 8) == 0);
+    CHECK(checkAllocation(crossbow::memory_policy(page_size::standard), 10000, 4096) == 0);
+    CHECK(checkAllocation(crossbow::memory_policy(page_size::standard, -1, true), 10000, 4096) == 0);
+    // Without huge pages the block is still aligned so transparent huge pages can back it
+    CHECK(checkAllocation(crossbow::memory_policy(page_size::huge_2m, -1, true), 3 * hugePage, hugePage) == 0);
+    // Node 0 exists on every machine, kernels without NUMA support ignore the binding
+    CHECK(checkAllocation(crossbow::memory_policy(page_size::standard, 0), 10000, 4096) == 0);
+
+    bool failed = false;
+    try {
+        crossbow::memory_policy(page_size::standard, 100000).allocate(4096);
+    } catch (const std::system_error&) {
+        failed = true;
+    }
+    CHECK(failed);
+
+    // Unmapping errors are reported to the caller
+    CHECK(crossbow::memory_policy(page_size::standard).deallocate(reinterpret_cast<void*>(1), 4096)
+            == std::errc::invalid_argument);
+
+    // The chunk size of pools is rounded up to the page size
+    crossbow::ChunkMemoryPool pool(1000 * 1000, crossbow::memory_policy(page_size::huge_2m));
+    CHECK(pool.chunkSize() == hugePage);
+    CHECK(reinterpret_cast<uintptr_t>(pool.allocate(100)) % hugePage == 0);
+    pool.allocate(hugePage - 100);
+    pool.allocate(hugePage + 1);
+    CHECK(pool.reserved() == 2 * hugePage + hugePage + 1);
+
+    crossbow::ChunkCache cache(4096, 1024 * 1024, crossbow::memory_policy(page_size::standard));
+    {
+        crossbow::ChunkMemoryPool cached(cache);
+        CHECK(cached.chunkSize() == 4096);
+        cached.allocate(3 * 4096);
+    }
+    CHECK(cache.cached() == 4096 + 4 * 4096);
+    return 0;
+}
@@ -0,0 +1,203 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/ChunkAllocator.hpp>
+#include <crossbow/Serializer.hpp>
+#include <crossbow/allocator.hpp>
+#include <crossbow/concurrent_flat_map.hpp>
+#include <crossbow/concurrent_map.hpp>
+#include <crossbow/memory_resource.hpp>
+#include <crossbow/string.hpp>
+
+#include "../check.hpp"
+
+#include <cstdint>
+#include <iostream>
+
+namespace {
+
+/**
+ * @brief Resource counting the bytes it hands out
+ */
+class counting_resource : public crossbow::memory_resource {
+public:
+    std::size_t allocated = 0;
+    std::size_t deallocated = 0;
+
+private:
+    virtual void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        allocated += bytes;
+        return crossbow::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    virtual void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+        deallocated += bytes;
+        crossbow::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    virtual bool do_is_equal(const crossbow::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+/**
+ * @brief Takes containers of any resource without being a template
+ */
+std::size_t totalLength(const crossbow::pmr::vector<crossbow::pmr::string>& strings) {
+    std::size_t result = 0;
+    for (auto& s : strings) {
+        result += s.size();
+    }
+    return result;
+}
+
+int checkChunkResource() {
+    crossbow::ChunkMemoryPool pool(4096);
+    crossbow::ChunkMemoryResource resource(pool);
+    crossbow::ChunkMemoryResource other(pool);
+    CHECK(resource == other);
+    CHECK(resource != *crossbow::new_delete_resource());
+
+    auto reserved = pool.reserved();
+    crossbow::pmr::vector<crossbow::pmr::string> arena(&resource);
+    crossbow::pmr::vector<crossbow::pmr::string> heap;
+    for (int i = 0; i < 100; ++i) {
+        arena.emplace_back(crossbow::pmr::string("a rather long string that does not fit inline", &resource));
+        heap.emplace_back("a rather long string that does not fit inline");
+    }
+    CHECK(pool.reserved() > reserved);
+    CHECK(totalLength(arena) == totalLength(heap));
+    CHECK(arena.get_allocator().resource() == &resource);
+    CHECK(heap.get_allocator().resource() == crossbow::get_default_resource());
+
+    // Moving between resources copies, moving within one resource steals the memory
+    crossbow::pmr::string moved(&resource);
+    auto data = arena[0].data();
+    moved = std::move(arena[0]);
+    CHECK(moved.data() == data);
+    moved = std::move(heap[0]);
+    CHECK(moved == arena[1]);
+    CHECK(moved.get_allocator().resource() == &resource);
+
+    crossbow::pmr::map<int, crossbow::pmr::string> map(&resource);
+    crossbow::pmr::unordered_map<int, int> unorderedMap(16, std::hash<int>(), std::equal_to<int>(), &resource);
+    for (int i = 0; i < 100; ++i) {
+        map.emplace(i, "value");
+        unorderedMap.emplace(i, i);
+    }
+    CHECK(map.size() == 100 && unorderedMap.at(42) == 42);
+    return 0;
+}
+
+int checkDefaultResource() {
+    counting_resource counting;
+    auto previous = crossbow::set_default_resource(&counting);
+    {
+        crossbow::pmr::vector<uint64_t> vec;
+        vec.resize(100);
+        CHECK(counting.allocated >= 100 * sizeof(uint64_t));
+    }
+    CHECK(counting.allocated == counting.deallocated);
+    CHECK(crossbow::set_default_resource(previous) == &counting);
+    return 0;
+}
+
+int checkEpochResource() {
+    crossbow::allocator::init();
+    auto resource = crossbow::allocator::resource();
+    CHECK(resource == crossbow::allocator::resource());
+    {
+        crossbow::allocator _;
+        crossbow::pmr::vector<uint64_t> vec(resource);
+        for (uint64_t i = 0; i < 1000; ++i) {
+            vec.push_back(i);
+        }
+        CHECK(vec[999] == 999);
+    }
+    auto aligned = resource->allocate(100, 128);
+    CHECK(reinterpret_cast<uintptr_t>(aligned) % 128 == 0);
+    resource->deallocate(aligned, 100, 128);
+    return 0;
+}
+
+int checkSerializer() {
+    crossbow::ChunkMemoryPool pool;
+    crossbow::ChunkMemoryResource resource(pool);
+    crossbow::pmr::vector<uint64_t> values(&resource);
+    values.push_back(1);
+    values.push_back(2);
+    crossbow::pmr::string name("a name that is long enough to be allocated", &resource);
+    std::basic_string<char, std::char_traits<char>, crossbow::polymorphic_allocator<char>> stdName("short", &resource);
+
+    crossbow::sizer sizer;
+    sizer & values & name & stdName;
+    crossbow::serializer ser(sizer.size);
+    ser & values & name & stdName;
+
+    crossbow::pmr::vector<uint64_t> outValues(&resource);
+    crossbow::pmr::string outName(&resource);
+    std::basic_string<char, std::char_traits<char>, crossbow::polymorphic_allocator<char>> outStdName(&resource);
+    crossbow::deserializer des(ser.buffer.get());
+    des & outValues & outName & outStdName;
+    CHECK(outValues == values);
+    CHECK(outName == name);
+    CHECK(outStdName == stdName);
+    CHECK(outName.get_allocator().resource() == &resource);
+    return 0;
+}
+
+int checkConcurrentMap() {
+    counting_resource counting;
+    {
+        crossbow::pmr::concurrent_map<uint64_t, uint64_t> map(std::hash<uint64_t>(), std::equal_to<uint64_t>(), &counting);
+        CHECK(counting.allocated > 0);
+        for (uint64_t i = 0; i < 1000; ++i) {
+            map.insert(i, i);
+        }
+        CHECK(map.at(500).second == 500);
+    }
+    CHECK(counting.allocated == counting.deallocated);
+
+    auto allocated = counting.allocated;
+    {
+        crossbow::pmr::concurrent_flat_map<uint64_t, uint64_t> map(std::hash<uint64_t>(), std::equal_to<uint64_t>(),
+                &counting);
+        CHECK(counting.allocated > allocated);
+        for (uint64_t i = 0; i < 1000; ++i) {
+            map.insert(i, i);
+        }
+        CHECK(map.at(500).second == 500);
+    }
+    CHECK(counting.allocated == counting.deallocated);
+    return 0;
+}
+
+} // anonymous namespace
+
+int main() {
+    CHECK(checkChunkResource() == 0);
+    CHECK(checkDefaultResource() == 0);
+    CHECK(checkEpochResource() == 0);
+    CHECK(checkSerializer() == 0);
+    CHECK(checkConcurrentMap() == 0);
+    return 0;
+}
@@ -0,0 +1,122 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/allocator.hpp>
+#include <crossbow/slab_allocator.hpp>
+
+#include "../check.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::atomic<uint64_t> gDestroyed(0);
+
+struct Value {
+    explicit Value(uint64_t d) : data(d) {}
+    ~Value() {
+        ++gDestroyed;
+    }
+
+    uint64_t data;
+};
+
+} // anonymous namespace
+
+int main() {
+    using crossbow::slab_allocator;
+    crossbow::allocator::init(crossbow::allocator::backend::slab);
+
+    // Size classes are multiples of 16 and waste at most a quarter of the block
+    CHECK(slab_allocator::block_size(1) == 16);
+    CHECK(slab_allocator::block_size(128) == 128);
+    CHECK(slab_allocator::block_size(129) == 160);
+    CHECK(slab_allocator::block_size(257) == 320);
+    CHECK(slab_allocator::block_size(slab_allocator::max_size) == slab_allocator::max_size);
+    for (size_t size = 1; size <= slab_allocator::max_size; ++size) {
+        auto block = slab_allocator::block_size(size);
+        CHECK(block >= size && block % 16 == 0);
+        CHECK(size <= 128 || block - size < block / 4);
+    }
+
+    // Blocks are distinct, aligned and reused after being freed
+    std::vector<void*> blocks;
+    std::set<void*> unique;
+    for (size_t i = 0; i < 10000; ++i) {
+        auto size = 1 + (i * 37) % 2000;
+        auto ptr = slab_allocator::allocate(size);
+        CHECK(ptr != nullptr);
+        CHECK(reinterpret_cast<uintptr_t>(ptr) % 16 == 0);
+        memset(ptr, 0xab, size);
+        blocks.push_back(ptr);
+        unique.insert(ptr);
+    }
+    CHECK(unique.size() == blocks.size());
+    auto reserved = slab_allocator::reserved();
+    for (auto ptr : blocks) {
+        slab_allocator::deallocate(ptr);
+    }
+    for (size_t i = 0; i < 10000; ++i) {
+        blocks[i] = slab_allocator::allocate(1 + (i * 37) % 2000);
+    }
+    CHECK(slab_allocator::reserved() == reserved);
+
+    // Blocks freed by another thread are reusable
+    std::thread other([&blocks]() {
+        for (auto ptr : blocks) {
+            slab_allocator::deallocate(ptr);
+        }
+    });
+    other.join();
+    for (size_t i = 0; i < 10000; ++i) {
+        blocks[i] = slab_allocator::allocate(1 + (i * 37) % 2000);
+    }
+    CHECK(slab_allocator::reserved() == reserved);
+    for (auto ptr : blocks) {
+        slab_allocator::deallocate(ptr);
+    }
+
+    // Epoch managed objects are carved from slabs, large ones still come from ::malloc
+    {
+        crossbow::allocator _;
+        for (uint64_t i = 0; i < 1000; ++i) {
+            auto value = crossbow::allocator::construct<Value>(i);
+            CHECK(value->data == i);
+            crossbow::allocator::destroy(value);
+        }
+        auto large = crossbow::allocator::malloc(2 * slab_allocator::max_size);
+        memset(large, 0, 2 * slab_allocator::max_size);
+        crossbow::allocator::free(large);
+        crossbow::allocator::free_now(crossbow::allocator::malloc(64));
+    }
+    for (int i = 0; i < 100 && gDestroyed != 1000; ++i) {
+        crossbow::allocator _;
+    }
+    CHECK(gDestroyed == 1000);
+    return 0;
+}
@@ -0,0 +1,158 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/concurrent_flat_map.hpp>
+#include <crossbow/string.hpp>
+
+#include "../check.hpp"
+
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+int testAgainstReference() {
+    crossbow::concurrent_flat_map<uint64_t, uint64_t> map;
+    std::unordered_map<uint64_t, uint64_t> reference;
+
+    std::mt19937_64 rnd(42);
+    std::uniform_int_distribution<uint64_t> keyDist(0, 20000);
+    for (int i = 0; i < 200000; ++i) {
+        auto key = keyDist(rnd);
+        switch (rnd() % 4) {
+        case 0:
+        case 1: {
+            auto res = map.insert(key, uint64_t(i));
+            auto iter = reference.find(key);
+            CHECK(res.first == (iter == reference.end()));
+            if (iter != reference.end()) {
+                CHECK(res.second == iter->second);
+            }
+            reference[key] = i;
+        } break;
+        case 2: {
+            auto res = map.erase(key);
+            auto iter = reference.find(key);
+            CHECK(res.first == (iter != reference.end()));
+            if (iter != reference.end()) {
+                CHECK(res.second == iter->second);
+                reference.erase(iter);
+            }
+        } break;
+        case 3: {
+            auto res = map.at(key);
+            auto iter = reference.find(key);
+            CHECK(res.first == (iter != reference.end()));
+            if (iter != reference.end()) {
+                CHECK(res.second == iter->second);
+            }
+        } break;
+        }
+        CHECK(map.size() == reference.size());
+    }
+
+    size_t count = 0;
+    bool valid = true;
+    map.for_each([&reference, &count, &valid](uint64_t key, uint64_t value) {
+        ++count;
+        auto iter = reference.find(key);
+        valid = valid && iter != reference.end() && iter->second == value;
+    });
+    CHECK(valid);
+    CHECK(count == reference.size());
+
+    map.clear();
+    CHECK(map.size() == 0);
+    CHECK(!map.at(1).first);
+    return 0;
+}
+
+int testExecOn() {
+    crossbow::concurrent_flat_map<crossbow::string, int> map;
+
+    // Insert through exec_on
+    map.exec_on("foo", [](int& value) {
+        value = 1;
+        return false;
+    });
+    CHECK(map.size() == 1);
+    CHECK(map.at("foo").second == 1);
+
+    // Nothing is inserted if the function returns true
+    map.exec_on("bar", [](int&) {
+        return true;
+    });
+    CHECK(map.size() == 1);
+    CHECK(!map.at("bar").first);
+
+    // Update in place
+    map.exec_on("foo", [](int& value) {
+        ++value;
+        return false;
+    });
+    CHECK(map.at("foo").second == 2);
+
+    // Remove
+    map.exec_on("foo", [](int&) {
+        return true;
+    });
+    CHECK(map.size() == 0);
+    return 0;
+}
+
+int testConcurrentInsert() {
+    constexpr uint64_t numThreads = 4;
+    constexpr uint64_t numKeys = 50000;
+    crossbow::concurrent_flat_map<uint64_t, uint64_t> map;
+
+    std::vector<std::thread> threads;
+    for (uint64_t t = 0; t < numThreads; ++t) {
+        threads.emplace_back([&map, t]() {
+            for (uint64_t i = t; i < numKeys; i += numThreads) {
+                map.insert(i, i * 2);
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    CHECK(map.size() == numKeys);
+    for (uint64_t i = 0; i < numKeys; ++i) {
+        auto res = map.at(i);
+        CHECK(res.first && res.second == i * 2);
+    }
+    return 0;
+}
+
+} // anonymous namespace
+
+int main() {
+    if (testAgainstReference() || testExecOn() || testConcurrentInsert()) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,76 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/concurrent_map.hpp>
+
+#include "../check.hpp"
+
+#include <cstdint>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+int main() {
+    constexpr uint64_t numKeys = 10000;
+    std::vector<std::pair<uint64_t, uint64_t>> elements;
+    for (uint64_t i = 0; i < numKeys; ++i) {
+        elements.emplace_back(i, i * 3);
+    }
+
+    // Bulk-load constructor
+    crossbow::concurrent_map<uint64_t, uint64_t> map(elements.begin(), elements.end());
+    CHECK(map.size() == numKeys);
+
+    // Bulk lookup of existing and non-existing keys
+    std::vector<uint64_t> keys;
+    for (uint64_t i = 0; i < 2 * numKeys; i += 2) {
+        keys.push_back(i);
+    }
+    std::vector<std::pair<bool, uint64_t>> results;
+    map.at_bulk(keys.begin(), keys.end(), std::back_inserter(results));
+    CHECK(results.size() == keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        CHECK(results[i].first == (keys[i] < numKeys));
+        if (results[i].first) {
+            CHECK(results[i].second == keys[i] * 3);
+        }
+    }
+
+    // Bulk erase removes only existing keys
+    CHECK(map.erase_bulk(keys.begin(), keys.end()) == numKeys / 2);
+    CHECK(map.size() == numKeys / 2);
+    CHECK(!map.at(0).first);
+    CHECK(map.at(1).first);
+
+    // Bulk insert overwrites existing keys and counts new keys only
+    std::vector<std::pair<uint64_t, uint64_t>> update;
+    for (uint64_t i = 0; i < 2 * numKeys; ++i) {
+        update.emplace_back(i, i);
+    }
+    CHECK(map.insert_bulk(update.begin(), update.end()) == numKeys + numKeys / 2);
+    CHECK(map.size() == 2 * numKeys);
+    for (uint64_t i = 0; i < 2 * numKeys; ++i) {
+        auto res = map.at(i);
+        CHECK(res.first && res.second == i);
+    }
+    return 0;
+}
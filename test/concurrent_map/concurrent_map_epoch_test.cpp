@@ -0,0 +1,123 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/allocator.hpp>
+#include <crossbow/concurrent_map.hpp>
+#include <crossbow/epoch_ptr.hpp>
+
+#include "../check.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::atomic<uint64_t> gCopies(0);
+std::atomic<uint64_t> gDestroyed(0);
+
+struct Value {
+    Value() : data(0) {}
+    explicit Value(uint64_t d) : data(d) {}
+    Value(const Value& other) : data(other.data) {
+        ++gCopies;
+    }
+    Value(Value&& other) : data(other.data) {}
+    Value& operator=(const Value& other) {
+        ++gCopies;
+        data = other.data;
+        return *this;
+    }
+    Value& operator=(Value&& other) {
+        data = other.data;
+        return *this;
+    }
+    ~Value() {
+        ++gDestroyed;
+    }
+
+    uint64_t data;
+};
+
+} // anonymous namespace
+
+int main() {
+    crossbow::allocator::init();
+    constexpr uint64_t numKeys = 1000;
+
+    // Inserting an rvalue moves the value into the map
+    {
+        crossbow::concurrent_map<uint64_t, Value> map;
+        for (uint64_t i = 0; i < numKeys; ++i) {
+            Value v(i);
+            map.insert(i, std::move(v));
+        }
+        Value v(numKeys);
+        map.insert(uint64_t(0), std::move(v));
+        CHECK(gCopies == 0);
+        CHECK(map.at(0).second.data == numKeys);
+    }
+
+    crossbow::concurrent_map<uint64_t, crossbow::epoch_ptr<Value>> map;
+    for (uint64_t i = 0; i < numKeys; ++i) {
+        map.insert(i, crossbow::make_epoch_ptr<Value>(i));
+    }
+    CHECK(map.size() == numKeys);
+    CHECK(map.get(numKeys) == nullptr);
+
+    gDestroyed = 0;
+    {
+        crossbow::allocator _;
+        const Value* value = map.get(1);
+        CHECK(value != nullptr && value->data == 1);
+
+        // Overwriting and erasing from another thread must not destroy the object while the guard is held
+        std::thread writer([&map]() {
+            crossbow::allocator _;
+            map.insert(uint64_t(1), crossbow::make_epoch_ptr<Value>(42));
+        });
+        writer.join();
+        CHECK(value->data == 1);
+        CHECK(map.get(1)->data == 42);
+
+        const Value* overwritten = map.get(1);
+        CHECK(map.erase(1).first);
+        CHECK(map.get(1) == nullptr);
+        CHECK(overwritten->data == 42);
+        CHECK(value->data == 1);
+        CHECK(gDestroyed == 0);
+    }
+
+    // Values survive a resize without being copied
+    gCopies = 0;
+    for (uint64_t i = numKeys; i < 8 * numKeys; ++i) {
+        map.insert(i, crossbow::make_epoch_ptr<Value>(i));
+    }
+    for (uint64_t i = 2; i < 8 * numKeys; ++i) {
+        auto value = map.get(i);
+        CHECK(value != nullptr && value->data == i);
+    }
+    CHECK(gCopies == 0);
+    return 0;
+}
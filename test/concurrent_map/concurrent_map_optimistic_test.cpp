@@ -0,0 +1,101 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/concurrent_map.hpp>
+
+#include "../check.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Entry {
+    uint64_t first;
+    uint64_t second;
+};
+
+} // anonymous namespace
+
+int main() {
+    constexpr uint64_t numKeys = 1024;
+    constexpr uint64_t numUpdates = 200000;
+    crossbow::concurrent_map<uint64_t, Entry> map;
+    static_assert(decltype(map)::optimistic_reads, "Entry should be read optimistically");
+
+    for (uint64_t i = 0; i < numKeys; ++i) {
+        map.insert(i, Entry{i, i});
+    }
+
+    // The writer keeps both fields of every entry equal, readers must never observe a torn entry. The writer also
+    // inserts new keys to trigger resizes while the readers are running.
+    std::atomic<bool> done(false);
+    std::atomic<uint64_t> torn(0);
+    std::atomic<uint64_t> missing(0);
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 2; ++t) {
+        readers.emplace_back([&map, &done, &torn, &missing]() {
+            for (uint64_t i = 0; !done.load(); i = (i + 1) % numKeys) {
+                auto res = map.at(i);
+                if (!res.first) {
+                    ++missing;
+                } else if (res.second.first != res.second.second) {
+                    ++torn;
+                }
+                map.find_if(i, [&torn](const Entry& e) {
+                    if (e.first != e.second) {
+                        ++torn;
+                    }
+                    return true;
+                });
+            }
+        });
+    }
+
+    for (uint64_t i = 0; i < numUpdates; ++i) {
+        auto key = i % numKeys;
+        map.insert(key, Entry{i, i});
+        if (i % 8 == 0) {
+            map.insert(numKeys + i, Entry{i, i});
+        }
+    }
+    done.store(true);
+    for (auto& t : readers) {
+        t.join();
+    }
+
+    CHECK(torn.load() == 0);
+    CHECK(missing.load() == 0);
+    CHECK(map.find_if(1, [](const Entry& e) { return e.first == e.second; }));
+    CHECK(!map.find_if(numKeys + 1, [](const Entry&) { return true; }));
+
+    // Once the readers are gone the arrays replaced by the resizes are freed
+    CHECK(map.release_retired());
+    for (uint64_t i = 0; i < numUpdates; i += 8) {
+        auto res = map.at(numKeys + i);
+        CHECK(res.first && res.second.first == i);
+    }
+    return 0;
+}
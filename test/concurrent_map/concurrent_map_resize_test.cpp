@@ -0,0 +1,176 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/concurrent_map.hpp>
+#include <crossbow/string.hpp>
+
+#include "../check.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+template <typename Value>
+Value makeValue(uint64_t key);
+
+template <>
+uint64_t makeValue<uint64_t>(uint64_t key) {
+    return key;
+}
+
+template <>
+crossbow::string makeValue<crossbow::string>(uint64_t key) {
+    return crossbow::string(std::to_string(key));
+}
+
+/**
+ * @brief Grows the map from several threads while erasing every other key, checks the content afterwards
+ */
+template <typename Value>
+int testConcurrentGrowth() {
+    constexpr uint64_t numThreads = 4;
+    constexpr uint64_t numKeys = 100000;
+    crossbow::concurrent_map<uint64_t, Value> map;
+
+    std::vector<std::thread> threads;
+    for (uint64_t t = 0; t < numThreads; ++t) {
+        threads.emplace_back([&map, t]() {
+            for (uint64_t i = t; i < numKeys; i += numThreads) {
+                map.insert(i, makeValue<Value>(i));
+                if (i % 2 == 1) {
+                    map.erase(i - 1);
+                }
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    // Keys erased by a thread might have been inserted after their erase by another thread
+    for (uint64_t i = 1; i < numKeys; i += 2) {
+        auto res = map.at(i);
+        CHECK(res.first && res.second == makeValue<Value>(i));
+    }
+
+    size_t count = 0;
+    bool valid = true;
+    map.for_each([&count, &valid](uint64_t key, const Value& value) {
+        ++count;
+        valid = valid && value == makeValue<Value>(key);
+    });
+    CHECK(valid);
+    CHECK(count == map.size());
+    return 0;
+}
+
+/**
+ * @brief Checks that elements are found while a resize is in progress
+ */
+int testLookupDuringResize() {
+    crossbow::concurrent_map<uint64_t, crossbow::string> map;
+    for (uint64_t i = 0; i < 10000; ++i) {
+        map.insert(i, makeValue<crossbow::string>(i));
+        // Lookups for all keys of the lock the insert migrated from
+        for (uint64_t j = i % 32; j <= i; j += 32) {
+            auto res = map.at(j);
+            CHECK(res.first && res.second == makeValue<crossbow::string>(j));
+        }
+    }
+    return 0;
+}
+
+std::atomic<size_t> gAllocated(0);
+
+/**
+ * @brief Allocator keeping track of the number of bytes allocated by all its instances
+ */
+template <typename T>
+struct counting_allocator {
+    typedef T value_type;
+
+    counting_allocator() = default;
+
+    template <typename U>
+    counting_allocator(const counting_allocator<U>&) {
+    }
+
+    T* allocate(size_t n) {
+        gAllocated += n * sizeof(T);
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* ptr, size_t n) {
+        gAllocated -= n * sizeof(T);
+        std::allocator<T>().deallocate(ptr, n);
+    }
+
+    template <typename U>
+    bool operator==(const counting_allocator<U>&) const {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const counting_allocator<U>&) const {
+        return false;
+    }
+};
+
+/**
+ * @brief Returns the number of bytes allocated by a map holding numKeys keys that are multiples of stride
+ */
+size_t allocatedFor(uint64_t numKeys, uint64_t stride) {
+    crossbow::concurrent_map<uint64_t, uint64_t, std::hash<uint64_t>, std::equal_to<uint64_t>,
+            counting_allocator<std::pair<const uint64_t, uint64_t>>> map;
+    for (uint64_t i = 0; i < numKeys; ++i) {
+        map.insert(i * stride, i);
+    }
+    return gAllocated.load();
+}
+
+/**
+ * @brief Checks that keys hashing to a single lock do not grow the map beyond its size
+ */
+int testSkewedGrowth() {
+    constexpr uint64_t numKeys = 100000;
+    auto uniform = allocatedFor(numKeys, 1);
+    CHECK(gAllocated == 0);
+
+    // With the identity hash all multiples of the concurrency level are guarded by the same lock
+    auto skewed = allocatedFor(numKeys, 32);
+    CHECK(skewed < 2 * uniform);
+    return 0;
+}
+
+} // anonymous namespace
+
+int main() {
+    if (testConcurrentGrowth<uint64_t>() || testConcurrentGrowth<crossbow::string>() || testLookupDuringResize()
+            || testSkewedGrowth()) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,90 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/adaptive_mutex.hpp>
+#include <crossbow/concurrent_flat_map.hpp>
+#include <crossbow/concurrent_map.hpp>
+
+#include "../check.hpp"
+
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+int main() {
+    constexpr unsigned numThreads = 4;
+    constexpr uint64_t numKeys = 20000;
+
+    typedef crossbow::concurrent_map<uint64_t, uint64_t, std::hash<uint64_t>, std::equal_to<uint64_t>,
+            std::allocator<std::pair<const uint64_t, uint64_t>>, crossbow::adaptive_mutex<>> map_type;
+    static_assert(sizeof(map_type::Stripe) % crossbow::cache_line_size == 0, "Stripes must not share a cache line");
+
+    // Every thread inserts its own keys and erases every other one again
+    map_type map;
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < numThreads; ++t) {
+        threads.emplace_back([&map, t]() {
+            for (uint64_t i = t; i < numKeys; i += numThreads) {
+                map.insert(i, i);
+            }
+            for (uint64_t i = t; i < numKeys; i += 2 * numThreads) {
+                map.erase(i);
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    CHECK(map.size() == numKeys / 2);
+    for (uint64_t i = 0; i < numKeys; ++i) {
+        CHECK(map.at(i).first == ((i % (2 * numThreads)) >= numThreads));
+    }
+
+    // exec_on updates the count of the stripe
+    map.exec_on(numKeys, [](uint64_t& value) {
+        value = 1;
+        return false;
+    });
+    CHECK(map.size() == numKeys / 2 + 1);
+
+    map.clear();
+    CHECK(map.size() == 0);
+    CHECK(!map.at(numKeys).first);
+
+    // The lock also works with the flat map
+    crossbow::concurrent_flat_map<uint64_t, uint64_t, std::hash<uint64_t>, std::equal_to<uint64_t>,
+            std::allocator<std::pair<const uint64_t, uint64_t>>, crossbow::adaptive_mutex<16>> flatMap;
+    threads.clear();
+    for (unsigned t = 0; t < numThreads; ++t) {
+        threads.emplace_back([&flatMap, t]() {
+            for (uint64_t i = t; i < numKeys; i += numThreads) {
+                flatMap.insert(i, i);
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    CHECK(flatMap.size() == numKeys);
+    return 0;
+}
@@ -0,0 +1,145 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/mpmc_queue.hpp>
+
+#include "../check.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <thread>
+#include <vector>
+
+int main() {
+    // Single threaded FIFO order and capacity
+    {
+        crossbow::mpmc_queue<uint64_t, 8> queue;
+        uint64_t value;
+        CHECK(!queue.read(value));
+        for (uint64_t i = 0; i < 8; ++i) {
+            CHECK(queue.try_write(i));
+        }
+        CHECK(!queue.try_write(uint64_t(8)));
+        CHECK(queue.size() == 8);
+        for (uint64_t i = 0; i < 8; ++i) {
+            CHECK(queue.read(value) && value == i);
+        }
+        CHECK(queue.empty());
+    }
+
+    // Bulk operations only transfer what fits
+    {
+        crossbow::mpmc_queue<std::unique_ptr<uint64_t>, 16> queue;
+        std::vector<std::unique_ptr<uint64_t>> in;
+        for (uint64_t i = 0; i < 20; ++i) {
+            in.emplace_back(new uint64_t(i));
+        }
+        CHECK(queue.write_bulk(std::make_move_iterator(in.begin()), std::make_move_iterator(in.end())) == 16);
+        CHECK(!in[15] && in[16]);
+        std::array<std::unique_ptr<uint64_t>, 10> out;
+        CHECK(queue.read_bulk(out.begin(), out.end()) == 10);
+        for (uint64_t i = 0; i < 10; ++i) {
+            CHECK(*out[i] == i);
+        }
+        CHECK(queue.write_bulk(std::make_move_iterator(in.begin() + 16), std::make_move_iterator(in.end())) == 4);
+        CHECK(queue.size() == 10);
+        // The remaining elements are destroyed by the queue
+    }
+
+    // Empty ranges return immediately no matter whether the next slot is free or filled
+    {
+        crossbow::mpmc_queue<int, 16> queue;
+        std::vector<int> empty;
+        CHECK(queue.write_bulk(empty.begin(), empty.end()) == 0);
+        CHECK(queue.read_bulk(empty.begin(), empty.end()) == 0);
+        CHECK(queue.try_write(1));
+        CHECK(queue.write_bulk(empty.begin(), empty.end()) == 0);
+        CHECK(queue.read_bulk(empty.begin(), empty.end()) == 0);
+        CHECK(queue.size() == 1);
+    }
+
+    // Multiple blocking producers and consumers deliver every element exactly once
+    {
+        constexpr unsigned numProducers = 4;
+        constexpr uint64_t numItems = 20000;
+        crossbow::mpmc_queue<uint64_t, 16> queue;
+        std::vector<std::atomic<uint32_t>> seen(numProducers * numItems);
+        for (auto& s : seen) {
+            s.store(0);
+        }
+        std::atomic<uint64_t> received(0);
+
+        std::vector<std::thread> threads;
+        for (unsigned p = 0; p < numProducers; ++p) {
+            threads.emplace_back([&queue, p]() {
+                for (uint64_t i = 0; i < numItems; ++i) {
+                    queue.write(p * numItems + i);
+                }
+            });
+        }
+        // Blocking consumer
+        threads.emplace_back([&queue, &seen, &received]() {
+            uint64_t value;
+            while (received.load() < numProducers * numItems) {
+                queue.read_wait(value);
+                ++seen[value];
+                if (++received == numProducers * numItems) {
+                    // Release the other consumer in case it is waiting
+                    queue.write(uint64_t(0));
+                }
+            }
+        });
+        // Polling bulk consumer
+        threads.emplace_back([&queue, &seen, &received]() {
+            std::array<uint64_t, 8> values;
+            while (received.load() < numProducers * numItems) {
+                auto count = queue.read_bulk(values.begin(), values.end());
+                if (count == 0) {
+                    std::this_thread::yield();
+                }
+                for (size_t i = 0; i < count; ++i) {
+                    ++seen[values[i]];
+                    if (++received == numProducers * numItems) {
+                        queue.write(uint64_t(0));
+                    }
+                }
+            }
+        });
+        for (auto& t : threads) {
+            t.join();
+        }
+        for (auto& s : seen) {
+            CHECK(s.load() >= 1);
+        }
+        uint64_t duplicates = 0;
+        for (auto& s : seen) {
+            duplicates += s.load() - 1;
+        }
+        // Only the wake up elements of value 0 might be received twice
+        CHECK(seen[0].load() == 1 + duplicates);
+    }
+    return 0;
+}
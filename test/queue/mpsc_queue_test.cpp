@@ -0,0 +1,106 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/mpsc_queue.hpp>
+
+#include "../check.hpp"
+
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+int main() {
+    // Single threaded FIFO order across many segments
+    {
+        crossbow::mpsc_queue<uint64_t, 4> queue;
+        uint64_t value;
+        CHECK(queue.empty());
+        CHECK(!queue.read(value));
+        for (uint64_t round = 0; round < 3; ++round) {
+            for (uint64_t i = 0; i < 1000; ++i) {
+                queue.emplace(i);
+            }
+            for (uint64_t i = 0; i < 500; ++i) {
+                CHECK(queue.read(value) && value == i);
+            }
+            std::array<uint64_t, 7> values;
+            for (uint64_t i = 500; i < 1000;) {
+                auto count = queue.read_bulk(values.begin(), values.end());
+                CHECK(count == std::min<uint64_t>(7, 1000 - i));
+                for (size_t j = 0; j < count; ++j, ++i) {
+                    CHECK(values[j] == i);
+                }
+            }
+            CHECK(queue.empty());
+        }
+    }
+
+    // Elements are constructed in place and remaining elements are destroyed with the queue
+    {
+        crossbow::mpsc_queue<std::unique_ptr<uint64_t>, 8> queue;
+        for (uint64_t i = 0; i < 20; ++i) {
+            queue.emplace(new uint64_t(i));
+        }
+        std::unique_ptr<uint64_t> value;
+        CHECK(queue.read(value) && *value == 0);
+    }
+
+    // Concurrent producers never block and the order of every producer is preserved
+    {
+        constexpr unsigned numProducers = 4;
+        constexpr uint64_t numItems = 50000;
+        crossbow::mpsc_queue<uint64_t, 8> queue;
+        std::vector<std::thread> producers;
+        for (unsigned p = 0; p < numProducers; ++p) {
+            producers.emplace_back([&queue, p]() {
+                for (uint64_t i = 0; i < numItems; ++i) {
+                    queue.emplace(p * numItems + i);
+                }
+            });
+        }
+
+        std::vector<uint64_t> next(numProducers, 0);
+        uint64_t received = 0;
+        std::array<uint64_t, 16> values;
+        while (received < numProducers * numItems) {
+            auto count = queue.read_bulk(values.begin(), values.end());
+            if (count == 0) {
+                std::this_thread::yield();
+            }
+            for (size_t i = 0; i < count; ++i) {
+                auto producer = values[i] / numItems;
+                CHECK(producer < numProducers);
+                CHECK(values[i] % numItems == next[producer]);
+                ++next[producer];
+            }
+            received += count;
+        }
+        for (auto& t : producers) {
+            t.join();
+        }
+        CHECK(queue.empty());
+    }
+    return 0;
+}
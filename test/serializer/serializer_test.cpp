@@ -0,0 +1,413 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/Serializer.hpp>
+
+#include "../check.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+std::atomic<uint64_t> gAllocatedBytes(0);
+
+/**
+ * @brief Allocator counting the bytes allocated by the containers using it
+ */
+template <typename T>
+struct counting_allocator {
+    typedef T value_type;
+
+    counting_allocator() = default;
+
+    template <typename U>
+    counting_allocator(const counting_allocator<U>&) {
+    }
+
+    T* allocate(size_t n) {
+        gAllocatedBytes += n * sizeof(T);
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* ptr, size_t n) {
+        std::allocator<T>().deallocate(ptr, n);
+    }
+
+    template <typename U>
+    bool operator==(const counting_allocator<U>&) const {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const counting_allocator<U>&) const {
+        return false;
+    }
+};
+
+template <typename T>
+using counted_vector = std::vector<T, counting_allocator<T>>;
+
+using counted_string = std::basic_string<char, std::char_traits<char>, counting_allocator<char>>;
+
+template <typename Key, typename Value>
+using counted_map = std::map<Key, Value, std::less<Key>, counting_allocator<std::pair<const Key, Value>>>;
+
+struct point {
+    int32_t x;
+    int32_t y;
+};
+
+struct item {
+    uint64_t id;
+    std::string name;
+    std::vector<point> points;
+    std::map<std::string, std::vector<int32_t>> tags;
+
+    template<class Archiver>
+    void visit(Archiver& ar) {
+        ar & id;
+        ar & name;
+        ar & points;
+        ar & tags;
+    }
+
+    bool operator==(const item& other) const {
+        if (id != other.id || name != other.name || tags != other.tags || points.size() != other.points.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < points.size(); ++i) {
+            if (points[i].x != other.points[i].x || points[i].y != other.points[i].y) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+std::vector<item> makeItems(size_t count) {
+    std::vector<item> items(count);
+    for (size_t i = 0; i < count; ++i) {
+        auto& e = items[i];
+        e.id = i;
+        e.name = "item " + std::to_string(i);
+        for (int32_t j = 0; j < int32_t(i % 7); ++j) {
+            e.points.push_back(point{j, -j});
+            e.tags["tag" + std::to_string(j)] = std::vector<int32_t>(size_t(j), j);
+        }
+    }
+    return items;
+}
+
+/**
+ * @brief View of a serialized item reading strings and points in place
+ */
+struct item_view {
+    uint64_t id;
+    crossbow::serialized_string_view name;
+    crossbow::serialized_span<point> points;
+
+    template<class Archiver>
+    void visit(Archiver& ar) {
+        ar & id;
+        ar & name;
+        ar & points;
+    }
+};
+
+enum class color : int16_t {
+    red = -300,
+    green = 5
+};
+
+} // anonymous namespace
+
+int main() {
+    static_assert(crossbow::static_serialized_size<int32_t>::value == sizeof(int32_t), "");
+    static_assert(crossbow::static_serialized_size<point>::value == sizeof(point), "");
+    static_assert(crossbow::static_serialized_size<std::pair<int32_t, uint64_t>>::value == 12, "");
+    static_assert(crossbow::static_serialized_size<std::tuple<bool, point, int16_t>>::value == 11, "");
+    static_assert(crossbow::static_serialized_size<std::pair<int32_t, std::string>>::value == 0, "");
+    static_assert(crossbow::static_serialized_size<std::vector<int32_t>>::value == 0, "");
+    static_assert(crossbow::static_serialized_size<item>::value == 0, "");
+
+    auto items = makeItems(100);
+    std::unique_ptr<uint8_t[]> expected;
+    auto size = crossbow::serialize(expected, items);
+
+    // The single pass serializer has to produce the same bytes as the two pass serializer
+    {
+        crossbow::growing_serializer ser(1);
+        ser & items;
+        CHECK(ser.size() == size);
+        CHECK(ser.capacity() >= size);
+        CHECK(memcmp(ser.data(), expected.get(), size) == 0);
+
+        std::vector<item> result;
+        crossbow::deserialize(result, ser.data());
+        CHECK(result == items);
+
+        // Reusing the buffer must not grow it again
+        auto capacity = ser.capacity();
+        ser.clear();
+        ser & items;
+        CHECK(ser.size() == size);
+        CHECK(ser.capacity() == capacity);
+
+        // Buffers can be taken out and handed back in
+        auto buffer = ser.release();
+        CHECK(ser.size() == 0);
+        ser & std::make_pair(int32_t(1), uint64_t(2));
+        CHECK(ser.size() == 12);
+        crossbow::growing_serializer other(std::move(buffer), capacity);
+        other & items;
+        CHECK(other.capacity() == capacity);
+        CHECK(memcmp(other.data(), expected.get(), size) == 0);
+    }
+
+    // Serializing into a buffer writer
+    {
+        std::unique_ptr<char[]> buffer(new char[size + 16]);
+        crossbow::buffer_writer writer(buffer.get(), size + 16);
+        writer.write<uint64_t>(42);
+        CHECK(crossbow::serialize(writer, items));
+        CHECK(writer.data() == buffer.get() + sizeof(uint64_t) + size);
+        CHECK(memcmp(buffer.get() + sizeof(uint64_t), expected.get(), size) == 0);
+
+        // Objects not fitting into the remaining space leave the writer untouched
+        auto pos = writer.data();
+        CHECK(!crossbow::serialize(writer, items));
+        CHECK(writer.data() == pos);
+        CHECK(crossbow::serialize(writer, std::make_tuple(int32_t(1), int32_t(2))));
+        CHECK(writer.data() == pos + 8);
+        CHECK(writer.exhausted());
+        CHECK(!crossbow::serialize(writer, true));
+    }
+
+    // Types with a compile time size skip the sizing pass
+    {
+        std::unique_ptr<uint8_t[]> buffer;
+        auto p = std::make_tuple(true, point{1, 2}, int16_t(3));
+        CHECK(crossbow::serialize(buffer, p) == 11);
+        std::tuple<bool, point, int16_t> res;
+        crossbow::deserialize(res, buffer.get());
+        CHECK(std::get<0>(res) && std::get<1>(res).x == 1 && std::get<1>(res).y == 2 && std::get<2>(res) == 3);
+    }
+
+    // Ranges of trivially copyable types are copied in bulk
+    {
+        static_assert(crossbow::is_bitwise_serializable<point>::value, "");
+        static_assert(!crossbow::is_bitwise_serializable<bool>::value, "");
+        static_assert(!crossbow::is_bitwise_serializable<item>::value, "");
+        static_assert(crossbow::static_serialized_size<std::array<point, 3>>::value == 3 * sizeof(point), "");
+        static_assert(crossbow::static_serialized_size<std::array<bool, 3>>::value == 3, "");
+        static_assert(crossbow::static_serialized_size<std::array<std::pair<int32_t, int16_t>, 2>>::value == 12, "");
+        static_assert(crossbow::static_serialized_size<std::array<std::string, 2>>::value == 0, "");
+
+        std::vector<uint64_t> values(1000);
+        for (size_t i = 0; i < values.size(); ++i) {
+            values[i] = i * i;
+        }
+        std::unique_ptr<uint8_t[]> buffer;
+        CHECK(crossbow::serialize(buffer, values) == sizeof(size_t) + values.size() * sizeof(uint64_t));
+        std::vector<uint64_t> res(1, 7);
+        CHECK(crossbow::deserialize(res, buffer.get()) == buffer.get() + sizeof(size_t) + 8000);
+        CHECK(res.size() == 1001 && res[0] == 7);
+        CHECK(std::equal(values.begin(), values.end(), res.begin() + 1));
+
+        // Elements keep their per element encoding
+        std::vector<point> points{{1, 2}, {3, 4}};
+        std::array<int16_t, 3> shorts{{5, 6, 7}};
+        std::array<std::string, 2> strings{{"first", std::string(100, 's')}};
+        std::vector<std::string> stringList{"a", "bc", std::string(64, 'd')};
+        auto obj = std::make_tuple(points, shorts, strings, stringList, std::vector<bool>{true, false, true});
+        auto size = crossbow::serialize(buffer, obj);
+        CHECK(size == 8 + 16 + 6 + (4 + 5 + 4 + 100) + (8 + 5 + 6 + 68) + (8 + 3));
+        crossbow::growing_serializer ser(1);
+        ser & obj;
+        CHECK(ser.size() == size && memcmp(ser.data(), buffer.get(), size) == 0);
+        crossbow::serializer_into_array elementWise(ser.data());
+        elementWise & points.size();
+        for (auto& p : points) {
+            elementWise & p;
+        }
+        CHECK(memcmp(ser.data(), buffer.get(), size) == 0);
+
+        decltype(obj) out;
+        crossbow::deserialize(out, buffer.get());
+        CHECK(std::get<0>(out).size() == 2 && std::get<0>(out)[1].x == 3 && std::get<0>(out)[1].y == 4);
+        CHECK(std::get<1>(out) == shorts);
+        CHECK(std::get<2>(out) == strings);
+        CHECK(std::get<3>(out) == stringList);
+        CHECK(std::get<4>(out) == std::get<4>(obj));
+
+        // Wide strings copy all bytes of their characters
+        std::wstring wide(L"wide characters");
+        CHECK(crossbow::serialize(buffer, wide) == 4 + wide.size() * sizeof(wchar_t));
+        std::wstring wideRes;
+        crossbow::deserialize(wideRes, buffer.get());
+        CHECK(wideRes == wide);
+    }
+
+    // Views read strings and vectors in place without allocating
+    {
+        item obj;
+        obj.id = 17;
+        obj.name = std::string(100, 'n');
+        obj.points = {{1, 2}, {3, 4}, {5, 6}};
+        std::unique_ptr<uint8_t[]> buffer;
+        auto size = crossbow::serialize(buffer, std::make_tuple(obj.id, obj.name, obj.points));
+
+        item_view view;
+        CHECK(crossbow::deserialize(view, buffer.get()) == buffer.get() + size);
+        CHECK(view.id == 17);
+        CHECK(view.name.size() == 100 && view.name.str() == obj.name);
+        CHECK(view.name.data() == reinterpret_cast<const char*>(buffer.get()) + 12);
+        CHECK(view.points.size() == 3 && view.points[2].x == 5 && view.points[2].y == 6);
+        int32_t sum = 0;
+        for (auto p : view.points) {
+            sum += p.x + p.y;
+        }
+        CHECK(sum == 21);
+        CHECK(view.points.end() - view.points.begin() == 3);
+        std::vector<point> copy(view.points.size());
+        view.points.copy(copy.data());
+        CHECK(copy[1].x == 3 && copy[1].y == 4);
+
+        // Serializing a view writes the format of the viewed type
+        crossbow::growing_serializer ser(1);
+        ser & view;
+        CHECK(ser.size() == size && memcmp(ser.data(), buffer.get(), size) == 0);
+        std::unique_ptr<uint8_t[]> other;
+        CHECK(crossbow::serialize(other, view) == size && memcmp(other.get(), buffer.get(), size) == 0);
+        auto fromVector = std::make_tuple(obj.id, crossbow::serialized_string_view(obj.name),
+                crossbow::serialized_span<point>(obj.points.data(), obj.points.size()));
+        CHECK(crossbow::serialize(other, fromVector) == size && memcmp(other.get(), buffer.get(), size) == 0);
+
+        crossbow::serialized_string_view empty;
+        crossbow::serialize(other, empty);
+        crossbow::deserialize(view.name, other.get());
+        CHECK(view.name.empty() && view.name == empty);
+    }
+
+    // The compact format encodes integers and lengths as varints
+    {
+        std::unique_ptr<uint8_t[]> buffer;
+        auto compactSize = crossbow::compact_serialize(buffer, items);
+        CHECK(compactSize < size);
+        std::vector<item> result;
+        CHECK(crossbow::compact_deserialize(result, buffer.get(), compactSize) == buffer.get() + compactSize);
+        CHECK(result == items);
+
+        auto limits = std::make_tuple(uint64_t(0), uint64_t(127), uint64_t(128), std::numeric_limits<uint64_t>::max(),
+                int64_t(-1), std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max(), int32_t(-64),
+                color::red, color::green, true, uint8_t(200));
+        auto limitsSize = crossbow::compact_serialize(buffer, limits);
+        CHECK(limitsSize == 1 + 1 + 2 + 10 + 1 + 10 + 10 + 1 + 2 + 1 + 1 + 1);
+        decltype(limits) limitsRes;
+        CHECK(crossbow::compact_deserialize(limitsRes, buffer.get(), limitsSize) == buffer.get() + limitsSize);
+        CHECK(limitsRes == limits);
+
+        // Exercise the batch decoder on single byte runs, mixed lengths and the scalar tail
+        std::vector<int32_t> ints;
+        std::vector<uint16_t> shorts;
+        for (int32_t i = 0; i < 1000; ++i) {
+            ints.push_back(i < 100 ? i % 50 - 25 : (i % 3 == 0 ? i * 100000 : -i));
+            shorts.push_back(uint16_t(i % 7 == 0 ? 65535 : i % 100));
+        }
+        auto obj = std::make_tuple(ints, shorts, std::string("compact"), std::vector<point>{{1, 2}});
+        auto objSize = crossbow::compact_serialize(buffer, obj);
+        decltype(obj) objRes;
+        std::get<0>(objRes).push_back(42);
+        CHECK(crossbow::compact_deserialize(objRes, buffer.get(), objSize) == buffer.get() + objSize);
+        CHECK(std::get<0>(objRes).size() == 1001 && std::get<0>(objRes)[0] == 42);
+        CHECK(std::equal(ints.begin(), ints.end(), std::get<0>(objRes).begin() + 1));
+        CHECK(std::get<1>(objRes) == shorts);
+        CHECK(std::get<2>(objRes) == "compact");
+        CHECK(std::get<3>(objRes).size() == 1 && std::get<3>(objRes)[0].y == 2);
+
+        crossbow::serialized_string_view name;
+        crossbow::compact_deserialize(name, buffer.get() + objSize - 8 - 1 - 8, 8);
+        CHECK(name.str() == "compact");
+    }
+
+    // The checked deserializer rejects truncated and corrupted input without reading past the end
+    {
+        auto few = makeItems(12);
+        auto obj = std::make_tuple(few, std::string("tail"), std::array<int16_t, 2>{{1, 2}}, true);
+        std::unique_ptr<uint8_t[]> buffer;
+        auto objSize = crossbow::serialize(buffer, obj);
+        decltype(obj) res;
+        CHECK(crossbow::checked_deserialize(res, buffer.get(), objSize) == buffer.get() + objSize);
+        CHECK(std::get<0>(res) == few && std::get<1>(res) == "tail" && std::get<3>(res));
+
+        for (size_t length = 0; length < objSize; ++length) {
+            std::unique_ptr<uint8_t[]> truncated(new uint8_t[length]);
+            memcpy(truncated.get(), buffer.get(), length);
+            decltype(obj) out;
+            CHECK(crossbow::checked_deserialize(out, truncated.get(), length) == nullptr);
+        }
+
+        // Length prefixes larger than the buffer fail before anything is allocated
+        counted_vector<uint64_t> values{1, 2, 3};
+        counted_map<counted_string, counted_vector<int32_t>> tags;
+        tags[counted_string("a")].push_back(1);
+        counted_vector<counted_string> names{counted_string("x")};
+        auto lengths = std::make_tuple(values, counted_string("abc"), tags, names);
+        auto lengthsSize = crossbow::serialize(buffer, lengths);
+        for (auto offset : {size_t(0), size_t(32), size_t(39), size_t(47), size_t(51), size_t(59), size_t(64)}) {
+            std::unique_ptr<uint8_t[]> corrupted(new uint8_t[lengthsSize]);
+            memcpy(corrupted.get(), buffer.get(), lengthsSize);
+            memset(corrupted.get() + offset, 0x7f, 4);
+            decltype(lengths) out;
+            gAllocatedBytes = 0;
+            CHECK(crossbow::checked_deserialize(out, corrupted.get(), lengthsSize) == nullptr);
+            CHECK(gAllocatedBytes.load() < 1024);
+        }
+
+        // Reading from a buffer_reader advances it only on success
+        crossbow::buffer_reader reader(reinterpret_cast<const char*>(buffer.get()), lengthsSize);
+        decltype(lengths) out;
+        CHECK(crossbow::deserialize(reader, out));
+        CHECK(reader.exhausted() && out == lengths);
+        crossbow::buffer_reader shortReader(reinterpret_cast<const char*>(buffer.get()), lengthsSize - 1);
+        CHECK(!crossbow::deserialize(shortReader, out));
+        CHECK(shortReader.data() == reinterpret_cast<const char*>(buffer.get()));
+
+        crossbow::checked_deserializer des(buffer.get(), 4);
+        uint64_t value = 0;
+        des & value;
+        CHECK(des.failed() && value == 0);
+        des & value;
+        CHECK(des.failed() && des.pos == des.end());
+    }
+
+    return 0;
+}
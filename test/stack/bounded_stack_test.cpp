@@ -0,0 +1,108 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/bounded_stack.hpp>
+
+#include "../check.hpp"
+
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+int main() {
+    // Single threaded LIFO order and capacity
+    {
+        crossbow::bounded_stack<uint64_t> stack(4);
+        uint64_t value;
+        CHECK(stack.empty());
+        CHECK(!stack.pop(value));
+        for (uint64_t i = 0; i < 4; ++i) {
+            CHECK(stack.push(i));
+        }
+        CHECK(!stack.push(4));
+        for (uint64_t i = 4; i > 0; --i) {
+            CHECK(stack.pop(value) && value == i - 1);
+        }
+        CHECK(stack.empty());
+    }
+
+    // Bulk operations preserve the order of the range and only transfer what fits
+    {
+        crossbow::bounded_stack<uint32_t> stack(10);
+        std::vector<uint32_t> in = {1, 2, 3, 4, 5, 6, 7, 8};
+        CHECK(stack.push_bulk(in.begin(), in.end()) == 8);
+        CHECK(stack.push_bulk(in.begin(), in.end()) == 2);
+        std::array<uint32_t, 4> out;
+        CHECK(stack.pop_bulk(out.begin(), out.end()) == 4);
+        CHECK(out[0] == 1 && out[1] == 2 && out[2] == 1 && out[3] == 2);
+        CHECK(stack.pop_bulk(out.begin(), out.end()) == 4);
+        CHECK(out[0] == 3 && out[3] == 6);
+        CHECK(stack.pop_bulk(out.begin(), out.end()) == 2);
+        CHECK(out[0] == 7 && out[1] == 8);
+        CHECK(stack.pop_bulk(out.begin(), out.end()) == 0);
+    }
+
+    // Concurrent push and pop neither lose nor duplicate elements
+    {
+        constexpr uint64_t numElements = 64;
+        constexpr unsigned numThreads = 4;
+        crossbow::bounded_stack<uint64_t> stack(numElements);
+        for (uint64_t i = 0; i < numElements; ++i) {
+            CHECK(stack.push(i));
+        }
+        std::vector<std::thread> threads;
+        for (unsigned t = 0; t < numThreads; ++t) {
+            threads.emplace_back([&stack, t]() {
+                std::array<uint64_t, 5> values;
+                for (unsigned i = 0; i < 50000; ++i) {
+                    if ((i + t) % 2 == 0) {
+                        uint64_t value;
+                        if (stack.pop(value)) {
+                            while (!stack.push(value)) {
+                            }
+                        }
+                    } else {
+                        auto count = stack.pop_bulk(values.begin(), values.end());
+                        for (size_t pushed = 0; pushed < count;) {
+                            pushed += stack.push_bulk(values.begin() + pushed, values.begin() + count);
+                        }
+                    }
+                }
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        std::vector<bool> seen(numElements, false);
+        uint64_t value;
+        while (stack.pop(value)) {
+            CHECK(value < numElements && !seen[value]);
+            seen[value] = true;
+        }
+        for (auto s : seen) {
+            CHECK(s);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,109 @@
+/*
+ * (C) Copyright 2015 ETH Zurich Systems Group (http://www.systems.ethz.ch/) and others.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Contributors:
+ *     Markus Pilman <mpilman@inf.ethz.ch>
+ *     Simon Loesing <sloesing@inf.ethz.ch>
+ *     Thomas Etter <etterth@gmail.com>
+ *     Kevin Bocksrocker <kevin.bocksrocker@gmail.com>
+ *     Lucas Braun <braunl@inf.ethz.ch>
+ */
+#include <crossbow/fixed_size_stack.hpp>
+#include <crossbow/magazine_depot.hpp>
+
+#include "../check.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+int main() {
+    constexpr uint32_t numIds = 1000;
+    crossbow::fixed_size_stack<uint32_t> stack(numIds, 0);
+    for (uint32_t i = 0; i < numIds; ++i) {
+        CHECK(stack.push(i));
+    }
+
+    {
+        crossbow::magazine_depot<uint32_t, 8> depot(stack, 4);
+
+        // A single cache only goes to the depot once per magazine
+        {
+            crossbow::magazine_depot<uint32_t, 8>::cache cache(depot);
+            std::vector<uint32_t> ids(20);
+            for (auto& id : ids) {
+                CHECK(cache.pop(id));
+            }
+            CHECK(cache.misses() == 3);
+            CHECK(cache.hits() == 17);
+            CHECK(stack.size() == numIds - 24);
+            // The third magazine filled up is handed to the depot
+            for (auto id : ids) {
+                cache.push(id);
+            }
+            CHECK(cache.misses() == 4);
+            CHECK(cache.hits() == 36);
+        }
+        CHECK(stack.size() == numIds - 8);
+        CHECK(depot.hits() == 36 && depot.misses() == 4);
+
+        // Concurrent caches never hand out the same id twice
+        std::vector<std::atomic<bool>> owned(numIds);
+        for (auto& o : owned) {
+            o.store(false);
+        }
+        std::atomic<bool> failed(false);
+        std::vector<std::thread> threads;
+        for (unsigned t = 0; t < 4; ++t) {
+            threads.emplace_back([&depot, &owned, &failed, t]() {
+                crossbow::magazine_depot<uint32_t, 8>::cache cache(depot);
+                std::vector<uint32_t> ids;
+                for (unsigned i = 0; i < 20000; ++i) {
+                    uint32_t id;
+                    if ((i * (t + 1)) % 7 < 4 && cache.pop(id)) {
+                        if (owned[id].exchange(true)) {
+                            failed = true;
+                        }
+                        ids.push_back(id);
+                    } else if (!ids.empty()) {
+                        owned[ids.back()].store(false);
+                        cache.push(ids.back());
+                        ids.pop_back();
+                    }
+                }
+                for (auto id : ids) {
+                    owned[id].store(false);
+                    cache.push(id);
+                }
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        CHECK(!failed);
+    }
+
+    // All ids are back in the stack once the depot is gone
+    CHECK(stack.size() == numIds);
+    std::vector<bool> seen(numIds, false);
+    uint32_t id;
+    while (stack.pop(id)) {
+        CHECK(id < numIds && !seen[id]);
+        seen[id] = true;
+    }
+    return 0;
+}